@@ -29,4 +29,6 @@
 #pragma once
 
 #include "genetic_optimization.h"
+#include "island_optimization.h"
+#include "population_optimization.h"
 #include "regression_analysis.h"
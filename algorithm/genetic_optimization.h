@@ -28,7 +28,14 @@
 
 #pragma once
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
 #include <functional>
 #include <tuple>
 #include <chrono>
@@ -36,18 +43,603 @@
 #include <ostream>
 #include <fstream>
 #include <array>
+#include <vector>
 #include <ranges>
 #include <algorithm>
 #include <utility>
 #include <optional>
 #include <filesystem>
+#include <span>
 
 #include "../util/gbutil.h"
 #include "../async/threadpool.h"
 #include "../archive/archive.h"
+#include "../archive/versioned.h"
 
 namespace gb::yadro::algorithm
 {
+    namespace detail
+    {
+        //------------------------------------------------------------------------------------------
+        // set of hashes split in shards with their own mutexes, so the threads rarely wait for each other
+        // the set may be limited to max_count hashes, the limit is split evenly among the shards
+        // and each shard evicts its oldest hashes first, so the eviction order is only roughly global
+        // serialized in the format of std::unordered_set<std::size_t>, the hashes are sorted,
+        // so the same set is always saved the same way
+        struct sharded_hash_set
+        {
+            bool insert(std::size_t hash)
+            {
+                auto& shard = _shards[shard_index(hash)];
+                std::lock_guard _(shard.m);
+                if (!shard.set.insert(hash).second)
+                    return false;
+
+                if (shard.capacity != std::size_t(-1))
+                {
+                    if (shard.order.size() < shard.capacity)
+                        shard.order.push_back(hash);
+                    else if (shard.capacity == 0)
+                        shard.set.erase(hash); // the limit is smaller than the number of shards
+                    else
+                    {
+                        shard.set.erase(shard.order[shard.next]);
+                        shard.order[shard.next] = hash;
+                        shard.next = (shard.next + 1) % shard.capacity;
+                    }
+                }
+                return true;
+            }
+
+            void clear()
+            {
+                for (auto&& shard : _shards)
+                {
+                    std::lock_guard _(shard.m);
+                    shard.set.clear();
+                    shard.order.clear();
+                    shard.next = 0;
+                }
+            }
+
+            // limit the number of hashes, -1 for unlimited, the excess hashes are dropped
+            void set_limit(std::size_t max_count)
+            {
+                for (std::size_t i = 0; i < shard_count; ++i)
+                {
+                    auto& shard = _shards[i];
+                    std::lock_guard _(shard.m);
+                    shard.capacity = max_count == std::size_t(-1) ? max_count : max_count / shard_count + (i < max_count % shard_count);
+                    shard.order.clear();
+                    shard.next = 0;
+                    if (shard.capacity == std::size_t(-1))
+                        continue;
+
+                    for (auto it = shard.set.begin(); it != shard.set.end();)
+                    {
+                        if (shard.order.size() < shard.capacity)
+                            shard.order.push_back(*it++);
+                        else
+                            it = shard.set.erase(it);
+                    }
+                }
+            }
+
+            auto size() const
+            {
+                std::size_t size = 0;
+                for (auto&& shard : _shards)
+                {
+                    std::lock_guard _(shard.m);
+                    size += shard.set.size();
+                }
+                return size;
+            }
+
+            // approximate memory used, in bytes
+            auto memory() const
+            {
+                std::size_t memory = sizeof(*this);
+                for (auto&& shard : _shards)
+                {   // a node of the set holds the hash, the next pointer and the cached hash
+                    std::lock_guard _(shard.m);
+                    memory += shard.set.size() * 3 * sizeof(std::size_t) + shard.set.bucket_count() * sizeof(void*)
+                        + shard.order.capacity() * sizeof(std::size_t);
+                }
+                return memory;
+            }
+
+            template<class Ar>
+            auto serialize(Ar& a) requires(gb::yadro::archive::is_iarchive_v<Ar>)
+            {
+                clear();
+                std::size_t size{}, bucket_count{};
+                a(gb::yadro::archive::serialize_as<std::uint64_t>(size));
+                a(gb::yadro::archive::serialize_as<std::uint64_t>(bucket_count));
+                // the size comes from the stream, a corrupted one mustn't allocate before the hashes are read
+                for (auto&& shard : _shards)
+                    shard.set.reserve(std::min(size / shard_count, std::min(shard.capacity, max_reserve)));
+
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    std::size_t hash{};
+                    a(hash);
+                    insert(hash);
+                }
+            }
+
+            template<class Ar>
+            auto serialize(Ar& a) const requires(gb::yadro::archive::is_oarchive_v<Ar>)
+            {
+                std::vector<std::size_t> hashes;
+                hashes.reserve(size());
+                for (auto&& shard : _shards)
+                    hashes.insert(hashes.end(), shard.set.begin(), shard.set.end());
+                std::ranges::sort(hashes);
+
+                a(gb::yadro::archive::serialize_as<std::uint64_t>(hashes.size()));
+                a(gb::yadro::archive::serialize_as<std::uint64_t>(hashes.size())); // bucket count for the reader
+                for (auto hash : hashes)
+                    a(hash);
+            }
+
+        private:
+            static constexpr std::size_t shard_count = 64;
+            static constexpr std::size_t max_reserve = 1 << 16; // per shard, when reading
+
+            struct alignas(64) shard_t
+            {
+                mutable util::mutexer<std::mutex> m;
+                std::unordered_set<std::size_t> set;
+                std::vector<std::size_t> order; // insertion order ring, when the set is limited
+                std::size_t next = 0; // the oldest hash in the ring
+                std::size_t capacity = -1; // the shard's part of the limit
+            };
+            std::array<shard_t, shard_count> _shards;
+
+            // the high bits of the multiplicative hash don't correlate with the buckets of the shard
+            static std::size_t shard_index(std::size_t hash)
+            {
+                return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ull) >> 58);
+            }
+        };
+
+        //------------------------------------------------------------------------------------------
+        // blocked bloom filter of hashes, all bits of a hash are in one 512 bit block (a cache line)
+        // sized for expected_count hashes with the given false positive rate,
+        // the rate grows when more hashes are inserted
+        // the bits are set atomically, no locking is needed
+        struct blocked_bloom_filter
+        {
+            blocked_bloom_filter() = default;
+
+            blocked_bloom_filter(std::size_t expected_count, double false_positive_rate)
+            {
+                if (expected_count == 0 || !(false_positive_rate > 0 && false_positive_rate < 1))
+                    throw util::exception_t("invalid bloom filter parameters", std::tuple(expected_count, false_positive_rate));
+
+                auto ln2 = std::log(2.);
+                auto bits = std::ceil(-static_cast<double>(expected_count) * std::log(false_positive_rate) / (ln2 * ln2));
+                _bit_count = static_cast<std::uint32_t>(std::clamp(std::round(bits / expected_count * ln2), 1., 16.));
+                _words.resize(static_cast<std::size_t>(std::ceil(bits / block_bits)) * block_words);
+            }
+
+            bool empty() const { return _words.empty(); }
+
+            // returns true if the hash wasn't in the filter
+            bool insert(std::size_t hash)
+            {
+                auto h = static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ull;
+                auto block = &_words[static_cast<std::size_t>((h >> 32) % (_words.size() / block_words)) * block_words];
+                // double hashing of the bit positions inside the block
+                auto h1 = static_cast<std::uint32_t>(h), h2 = static_cast<std::uint32_t>((h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ull >> 32) | 1;
+
+                auto added = false;
+                for (std::uint32_t i = 0; i < _bit_count; ++i)
+                {
+                    auto bit = (h1 + i * h2) % block_bits;
+                    auto mask = std::uint64_t(1) << (bit % 64);
+                    auto old = std::atomic_ref(block[bit / 64]).fetch_or(mask, std::memory_order_relaxed);
+                    added |= (old & mask) == 0;
+                }
+                return added;
+            }
+
+            void clear() { std::ranges::fill(_words, 0); }
+
+            auto memory() const { return sizeof(*this) + _words.capacity() * sizeof(std::uint64_t); }
+
+            template<class Ar>
+            auto serialize(Ar& a) { a(_bit_count, _words); }
+
+            template<class Ar>
+            auto serialize(Ar& a) const { a(_bit_count, _words); }
+
+        private:
+            static constexpr std::uint32_t block_bits = 512;
+            static constexpr std::size_t block_words = block_bits / 64;
+
+            std::uint32_t _bit_count = 0; // bits per hash
+            std::vector<std::uint64_t> _words;
+        };
+
+        //------------------------------------------------------------------------------------------
+        // cache of targets keyed by the exact parameters, split in shards like sharded_hash_set
+        // a key is inserted before its target is calculated, so the other threads skip it meanwhile
+        // serialized as a vector of (key, target) sorted by key, the keys without target are not saved
+        template<class Key, class Target>
+        struct evaluation_cache
+        {
+            // returns true if the key wasn't in the cache
+            bool insert(const Key& key)
+            {
+                auto& shard = _shards[shard_index(key)];
+                std::lock_guard _(shard.m);
+                return shard.map.try_emplace(key).second;
+            }
+
+            void set(const Key& key, const Target& target)
+            {
+                auto& shard = _shards[shard_index(key)];
+                std::lock_guard _(shard.m);
+                shard.map.insert_or_assign(key, target);
+            }
+
+            std::optional<Target> find(const Key& key) const
+            {
+                auto& shard = _shards[shard_index(key)];
+                std::lock_guard _(shard.m);
+                auto it = shard.map.find(key);
+                return it != shard.map.end() ? it->second : std::nullopt;
+            }
+
+            void clear()
+            {
+                for (auto&& shard : _shards)
+                {
+                    std::lock_guard _(shard.m);
+                    shard.map.clear();
+                }
+            }
+
+            auto size() const
+            {
+                std::size_t size = 0;
+                for (auto&& shard : _shards)
+                {
+                    std::lock_guard _(shard.m);
+                    size += shard.map.size();
+                }
+                return size;
+            }
+
+            // approximate memory used, in bytes, the memory owned by ranges in the keys is not counted
+            auto memory() const
+            {
+                std::size_t memory = sizeof(*this);
+                for (auto&& shard : _shards)
+                {
+                    std::lock_guard _(shard.m);
+                    memory += shard.map.size() * (sizeof(typename map_t::value_type) + 2 * sizeof(std::size_t))
+                        + shard.map.bucket_count() * sizeof(void*);
+                }
+                return memory;
+            }
+
+            template<class Ar>
+            auto serialize(Ar& a) requires(gb::yadro::archive::is_iarchive_v<Ar>)
+            {
+                std::vector<std::tuple<Key, Target>> entries;
+                a(entries);
+                clear();
+                for (auto&& [key, target] : entries)
+                    set(key, target);
+            }
+
+            template<class Ar>
+            auto serialize(Ar& a) const requires(gb::yadro::archive::is_oarchive_v<Ar>)
+            {
+                std::vector<std::tuple<Key, Target>> entries;
+                for (auto&& shard : _shards)
+                {
+                    std::lock_guard _(shard.m);
+                    for (auto&& [key, target] : shard.map)
+                        if (target)
+                            entries.emplace_back(key, *target);
+                }
+                std::ranges::sort(entries, std::less<>{}, [](auto&& entry) -> auto& { return std::get<0>(entry); });
+                a(entries);
+            }
+
+        private:
+            static constexpr std::size_t shard_count = 64;
+
+            struct hash_t
+            {
+                auto operator()(const Key& key) const { return static_cast<std::size_t>(util::make_hash(key)); }
+            };
+            using map_t = std::unordered_map<Key, std::optional<Target>, hash_t>;
+
+            struct alignas(64) shard_t
+            {
+                mutable util::mutexer<std::mutex> m;
+                map_t map;
+            };
+            std::array<shard_t, shard_count> _shards;
+
+            static std::size_t shard_index(const Key& key)
+            {
+                return static_cast<std::size_t>((static_cast<std::uint64_t>(hash_t{}(key)) * 0x9e3779b97f4a7c15ull) >> 58);
+            }
+        };
+
+        //------------------------------------------------------------------------------------------
+        // batch target function takes std::span<const std::tuple<Types...>> and returns a sized range of targets,
+        // one for each parameter set
+        template<class Fn, class ...Types>
+        concept batch_target_fn = !std::invocable<Fn, Types...> && std::invocable<Fn&, std::span<const std::tuple<Types...>>>;
+
+        template<class Fn, class ...Types>
+        concept target_fn = std::invocable<Fn, Types...> || batch_target_fn<Fn, Types...>;
+
+        template<class Fn, class ...Types>
+        struct target_type
+        {
+            using type = std::invoke_result_t<Fn, Types...>;
+        };
+
+        template<class Fn, class ...Types> requires batch_target_fn<Fn, Types...>
+        struct target_type<Fn, Types...>
+        {
+            using type = std::ranges::range_value_t<std::invoke_result_t<Fn&, std::span<const std::tuple<Types...>>>>;
+        };
+
+        //------------------------------------------------------------------------------------------
+        // operators changing the parameters, combined in bit masks
+        enum operator_t : unsigned
+        {
+            genetic_operator = 1,
+            gradient_operator = 2,
+            mutation_operator = 4,
+        };
+
+        //------------------------------------------------------------------------------------------
+        // the operators that made the parameters and the flat indices of the mutated scalars
+        // (elements of range parameters are counted one by one)
+        struct breed_info
+        {
+            unsigned operators = 0;
+            std::vector<std::uint32_t> mutated;
+        };
+
+        //------------------------------------------------------------------------------------------
+        // adaptive operator selection by probability matching: an operator is chosen with the probability
+        // proportional to its recent success rate, but not less than min_probability
+        // mutation steps of scalar parameters follow 1/5 success rule: the step of a parameter grows after
+        // a successful mutation and shrinks after a failed one, the steps are fractions of parameter ranges
+        struct adaptive_operators
+        {
+            static constexpr std::array<unsigned, 3> operator_bits{ genetic_operator, gradient_operator, mutation_operator };
+            static constexpr double min_probability = 0.1;
+            static constexpr double learning_rate = 0.05;
+            static constexpr double initial_step = 0.1;
+            static constexpr double min_step = 1e-9;
+            static constexpr double step_growth = 1.5;
+            static constexpr double step_shrink = 0.9036020036098448; // step_growth^(-1/4), steps are stable at 1/5 success rate
+
+            std::array<double, 3> quality{}; // recent success rates of genetic, gradient and mutation operators
+            std::vector<double> steps;
+
+            // probabilities of genetic, gradient and mutation operators
+            auto probabilities() const
+            {
+                std::array<double, 3> p{};
+                auto sum = quality[0] + quality[1] + quality[2];
+                for (std::size_t i = 0; i < p.size(); ++i)
+                    p[i] = min_probability + (1 - p.size() * min_probability) * (sum > 0 ? quality[i] / sum : 1. / p.size());
+                return p;
+            }
+
+            // choose one of the allowed operators (mask of operator_t bits), r is uniform in [0, 1)
+            unsigned select(double r, unsigned allowed) const
+            {
+                auto p = probabilities();
+                auto total = 0.;
+                for (std::size_t i = 0; i < p.size(); ++i)
+                    total += (allowed & operator_bits[i]) ? p[i] : 0;
+
+                r *= total;
+                for (std::size_t i = 0; i < p.size(); ++i)
+                {
+                    if (!(allowed & operator_bits[i]))
+                        continue;
+                    if (r < p[i])
+                        return operator_bits[i];
+                    r -= p[i];
+                }
+                return mutation_operator;
+            }
+
+            double step(std::size_t index)
+            {
+                if (index >= steps.size())
+                    steps.resize(index + 1, initial_step);
+                return steps[index];
+            }
+
+            void reward(const breed_info& info, bool success)
+            {
+                for (std::size_t i = 0; i < quality.size(); ++i)
+                {
+                    if (info.operators & operator_bits[i])
+                        quality[i] += learning_rate * ((success ? 1. : 0.) - quality[i]);
+                }
+
+                for (auto index : info.mutated)
+                {
+                    if (index < steps.size())
+                        steps[index] = std::clamp(steps[index] * (success ? step_growth : step_shrink), min_step, 1.);
+                }
+            }
+
+            // add what a thread learned since it copied base from this shared state,
+            // the quality changes are added and the step changes are multiplied, as they were made
+            void merge(const adaptive_operators& learned, const adaptive_operators& base)
+            {
+                for (std::size_t i = 0; i < quality.size(); ++i)
+                    quality[i] = std::clamp(quality[i] + learned.quality[i] - base.quality[i], 0., 1.);
+
+                for (std::size_t i = 0; i < learned.steps.size(); ++i)
+                {
+                    auto base_step = i < base.steps.size() ? base.steps[i] : initial_step;
+                    steps[i] = std::clamp(step(i) * learned.steps[i] / base_step, min_step, 1.);
+                }
+            }
+
+            void reset() { quality = {}; steps.clear(); }
+        };
+    }
+
+    //------------------------------------------------------------------------------------------
+    // statistics for genetic_optimization_t
+    // successes are the improvements of the best target by the parameters changed by the operator
+    struct stats
+    {
+        std::size_t gradient_count;
+        std::size_t genetic_count;
+        std::size_t mutation_count;
+        std::size_t improvement_count;
+        std::size_t repetition_count;
+        std::size_t loop_count;
+        std::size_t unique_param_count;
+        std::size_t visited_memory; // bytes
+        std::size_t gradient_success;
+        std::size_t genetic_success;
+        std::size_t mutation_success;
+
+        void add(const stats& other)
+        {
+            gradient_count += other.gradient_count;
+            genetic_count += other.genetic_count;
+            mutation_count += other.mutation_count;
+            improvement_count += other.improvement_count;
+            repetition_count += other.repetition_count;
+            loop_count += other.loop_count;
+            unique_param_count += other.unique_param_count;
+            visited_memory = std::max(visited_memory, other.visited_memory);
+            gradient_success += other.gradient_success;
+            genetic_success += other.genetic_success;
+            mutation_success += other.mutation_success;
+        }
+
+        // counters accumulated after the earlier stats
+        auto since(const stats& earlier) const
+        {
+            return stats{ gradient_count - earlier.gradient_count, genetic_count - earlier.genetic_count,
+                mutation_count - earlier.mutation_count, improvement_count - earlier.improvement_count,
+                repetition_count - earlier.repetition_count, loop_count - earlier.loop_count,
+                unique_param_count - earlier.unique_param_count, visited_memory,
+                gradient_success - earlier.gradient_success, genetic_success - earlier.genetic_success,
+                mutation_success - earlier.mutation_success };
+        }
+
+        // credit the operators (detail::operator_t bits) that produced the improvement
+        void add_success(unsigned operators)
+        {
+            genetic_success += (operators & detail::genetic_operator) != 0;
+            gradient_success += (operators & detail::gradient_operator) != 0;
+            mutation_success += (operators & detail::mutation_operator) != 0;
+        }
+
+        static double success_rate(std::size_t success, std::size_t count) { return count != 0 ? static_cast<double>(success) / count : 0; }
+
+        friend auto& operator<< (std::ostream& os, const stats& s)
+        {
+            os << "loops: " << s.loop_count
+                << ", improvements: " << s.improvement_count
+                << ", gradients: " << s.gradient_count << " (" << 100 * success_rate(s.gradient_success, s.gradient_count) << "% success)"
+                << ", genetics: " << s.genetic_count << " (" << 100 * success_rate(s.genetic_success, s.genetic_count) << "% success)"
+                << ", mutations: " << s.mutation_count << " (" << 100 * success_rate(s.mutation_success, s.mutation_count) << "% success)"
+                << ", unique: " << s.unique_param_count
+                << ", repetitions: " << (s.loop_count != 0 ? 100. * s.repetition_count / s.loop_count : 0) << "%"
+                << ", visited memory: " << s.visited_memory / 1024 << " KB"
+                << "\n";
+            return os;
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // optimization progress reported periodically by genetic_optimization_t (set_telemetry)
+    // the rates are calculated over the period since the previous sample
+    template<class Target>
+    struct telemetry_sample
+    {
+        std::chrono::duration<double> time; // since the start of optimization
+        std::optional<Target> best_target;
+        stats total; // counters since the start of optimization
+        double evaluations_per_second;
+        double improvements_per_second;
+        double utilization; // share of the threads time spent in target function
+        bool is_final; // the last sample of optimization
+
+        friend auto& operator<< (std::ostream& os, const telemetry_sample& s)
+        {
+            os << "time: " << s.time.count() << " s";
+            if (s.best_target)
+                os << ", best: " << *s.best_target;
+            os << ", evaluations: " << s.total.unique_param_count
+                << ", evaluations/s: " << s.evaluations_per_second
+                << ", improvements/s: " << s.improvements_per_second
+                << ", utilization: " << 100 * s.utilization << "%"
+                << ", success genetic: " << 100 * stats::success_rate(s.total.genetic_success, s.total.genetic_count) << "%"
+                << ", gradient: " << 100 * stats::success_rate(s.total.gradient_success, s.total.gradient_count) << "%"
+                << ", mutation: " << 100 * stats::success_rate(s.total.mutation_success, s.total.mutation_count) << "%"
+                << "\n";
+            return os;
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // compact trace of telemetry samples: a whitespace separated data file, one line per sample
+    // columns: time, best target, evaluations, evaluations/s, improvements/s, utilization,
+    // success rates of genetic, gradient and mutation operators
+    // gnuplot renders the convergence curve with: plot "file" using 1:2 with lines, see util::data_file_plot
+    // the trace is passed to set_telemetry with std::ref and must outlive the optimization
+    template<class Target>
+    struct telemetry_trace
+    {
+        explicit telemetry_trace(const std::filesystem::path& path) : _os(path)
+        {
+            util::gbassert(static_cast<bool>(_os), "failed to create telemetry trace: " + path.string());
+            _os << "# time best evaluations evaluations/s improvements/s utilization genetic_success gradient_success mutation_success\n";
+        }
+
+        void operator()(const telemetry_sample<Target>& s)
+        {
+            _os << s.time.count() << ' ';
+            if (s.best_target)
+                _os << *s.best_target << ' ';
+            else
+                _os << "NaN ";
+            _os << s.total.unique_param_count << ' ' << s.evaluations_per_second << ' ' << s.improvements_per_second << ' '
+                << s.utilization << ' ' << stats::success_rate(s.total.genetic_success, s.total.genetic_count) << ' '
+                << stats::success_rate(s.total.gradient_success, s.total.gradient_count) << ' '
+                << stats::success_rate(s.total.mutation_success, s.total.mutation_count) << '\n';
+            if (s.is_final)
+                _os.flush();
+
+            if (s.best_target)
+                _best_targets.push_back(*s.best_target);
+        }
+
+        // best targets of the samples, can be plotted with util::plot_t
+        const auto& best_targets() const { return _best_targets; }
+
+    private:
+        std::ofstream _os;
+        std::vector<Target> _best_targets;
+    };
+
     //------------------------------------------------------------------------------------------
     // modified genetic optimization algorithm, minimizing target function
     // algorithm makes probablistic changes: parent swaps, mutations, gradient moves
@@ -55,19 +647,29 @@ namespace gb::yadro::algorithm
     // algorithm is greedy
     // parameters to be optimized are supplied in min_max tuples
     // parameters may be scalar types or random access sized ranges (e.g. vector)
+    // each thread breeds from its own copy of the best solutions and merges the new solutions
+    // into the shared optimization map periodically (set_sync_interval)
+    // target function may evaluate a batch of parameter sets (detail::batch_target_fn),
+    // then the parameters are generated and evaluated in batches (set_batch_size)
+    // calculated targets may be cached (set_cache) and the parameters rounded to a grid (set_grid)
+    // progress of optimization may be reported periodically (set_telemetry)
+    // adaptive mode (set_adaptive) shifts the operator probabilities toward the operators producing improvements
     //------------------------------------------------------------------------------------------
 
     template<class Fn, class CompareFn, class ...Types>
     struct genetic_optimization_t
     {
-        using target_t = std::invoke_result_t<Fn, Types...>;
+        using target_t = typename detail::target_type<Fn, Types...>::type;
+        using params_t = std::tuple<Types...>;
+        using solution_t = std::tuple<target_t, params_t>;
+        using compare_t = CompareFn;
 
         //------------------------------------------------------------------------------------------
         // constructor takes comparison function for target function
         //------------------------------------------------------------------------------------------
         genetic_optimization_t(Fn target_fn, CompareFn compare, std::tuple<Types, Types> ... min_max)
-            requires ((std::invocable<Fn, Types...>
-        && std::invocable<CompareFn, std::invoke_result_t< Fn, Types...>, std::invoke_result_t< Fn, Types...>>))
+            requires ((detail::target_fn<Fn, Types...>
+        && std::invocable<CompareFn, target_t, target_t>))
             : _target_fn(std::move(target_fn)), _min_max_params(std::move(min_max)...), _opt_map(compare)
         {
         }
@@ -76,7 +678,7 @@ namespace gb::yadro::algorithm
         // constructor uses std::less<> for target function
         //------------------------------------------------------------------------------------------
         genetic_optimization_t(Fn target_fn, std::tuple<Types, Types> ... min_max)
-            requires (std::invocable<Fn, Types...>)
+            requires (detail::target_fn<Fn, Types...>)
         : _target_fn(std::move(target_fn)), _min_max_params(std::move(min_max)...), _opt_map(std::less<>{})
         {
         }
@@ -86,8 +688,8 @@ namespace gb::yadro::algorithm
         //------------------------------------------------------------------------------------------
         genetic_optimization_t(const std::filesystem::path& archive_file, Fn target_fn, CompareFn compare,
             std::tuple<Types, Types> ... min_max)
-            requires ((std::invocable<Fn, Types...>
-        && std::invocable<CompareFn, std::invoke_result_t< Fn, Types...>, std::invoke_result_t< Fn, Types...>>))
+            requires ((detail::target_fn<Fn, Types...>
+        && std::invocable<CompareFn, target_t, target_t>))
             : _target_fn(std::move(target_fn)), _min_max_params(std::move(min_max)...), _opt_map(compare)
         {
             load(archive_file);
@@ -98,7 +700,7 @@ namespace gb::yadro::algorithm
         //------------------------------------------------------------------------------------------
         genetic_optimization_t(const std::filesystem::path& archive_file, Fn target_fn,
             std::tuple<Types, Types> ... min_max)
-            requires (std::invocable<Fn, Types...>)
+            requires (detail::target_fn<Fn, Types...>)
         : _target_fn(std::move(target_fn)), _min_max_params(std::move(min_max)...), _opt_map(std::less<>{})
         {
             load(archive_file);
@@ -110,7 +712,9 @@ namespace gb::yadro::algorithm
         void save(const std::filesystem::path& archive_file) const
         {
             std::ofstream ofs(archive_file, std::ios::binary);
-            serialize(gb::yadro::archive::bin_archive(ofs));
+            gb::yadro::archive::bin_archive ar(ofs);
+            gb::yadro::archive::write_header(ar);
+            ar(gb::yadro::archive::versioned(*this));
         }
 
         //------------------------------------------------------------------------------------------
@@ -119,7 +723,15 @@ namespace gb::yadro::algorithm
         void load(const std::filesystem::path& archive_file)
         {
             std::ifstream ifs(archive_file, std::ios::binary);
-            serialize(gb::yadro::archive::bin_archive(ifs));
+            gb::yadro::archive::bin_archive ar(ifs);
+            if (gb::yadro::archive::read_header(ar))
+                ar(gb::yadro::archive::versioned(*this));
+            else
+            {   // files saved before versioning have no header
+                ifs.clear();
+                ifs.seekg(0);
+                serialize(ar, 1);
+            }
         }
 
         //------------------------------------------------------------------------------------------
@@ -130,6 +742,97 @@ namespace gb::yadro::algorithm
             _opt_param = opt_param_t{ swap_probability, mutation_probability, gradient_probability};
         }
 
+        //------------------------------------------------------------------------------------------
+        // adaptive mode applies one operator to make new parameters, chosen with probability matching,
+        // mutation moves the parameters of the best solution by normally distributed steps,
+        // the steps are adapted for each parameter, mutation_probability is the chance of each parameter to move
+        // the state is learned while optimizing and kept until clear()
+        //------------------------------------------------------------------------------------------
+        void set_adaptive(bool enable) { _adaptive = enable; }
+
+        // learned probabilities and mutation steps, must not be called while optimizing
+        const auto& adaptive_state() const { return _adaptive_state; }
+
+        //------------------------------------------------------------------------------------------
+        // set how often the optimizing threads exchange solutions: after loops or period, whichever comes first
+        // frequent exchange spreads the improvements faster, but the threads wait for each other more
+        //------------------------------------------------------------------------------------------
+        void set_sync_interval(std::size_t loops, std::chrono::microseconds period)
+        {
+            _sync_loops = loops;
+            _sync_period = period;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // report the progress to fn(const telemetry_sample<target_t>&) every period while optimizing
+        // and once at the end, e.g. write to logger or telemetry_trace
+        // fn is called under the optimizer lock, so it should be fast, empty fn stops the reports
+        //------------------------------------------------------------------------------------------
+        void set_telemetry(std::function<void(const telemetry_sample<target_t>&)> fn,
+            std::chrono::microseconds period = std::chrono::milliseconds(100))
+        {
+            _telemetry.fn = std::move(fn);
+            _telemetry.period = period;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // set the number of parameter sets evaluated by a batch target function in one call
+        // ignored by the target functions taking one parameter set
+        //------------------------------------------------------------------------------------------
+        void set_batch_size(std::size_t batch_size)
+        {
+            _batch_size = std::max<std::size_t>(1, batch_size);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // the tried parameters are remembered by their hashes to skip repetitions, by default all of them
+        // set_visited_limit keeps at most max_count hashes (-1 for unlimited), forgetting the oldest ones,
+        // the age is tracked in each of the 64 shards of the set separately
+        // set_visited_filter uses a bloom filter instead, it takes about 1.44 * log2(1 / false_positive_rate) bits
+        // per hash, but rejects false_positive_rate part of the new parameters as repetitions
+        // both clear the visited parameters
+        //------------------------------------------------------------------------------------------
+        void set_visited_limit(std::size_t max_count)
+        {
+            _visited.clear();
+            _visited.set_limit(max_count);
+            _visited_limit = max_count;
+            _visited_filter = {};
+        }
+
+        void set_visited_filter(std::size_t expected_count, double false_positive_rate)
+        {
+            _visited.clear();
+            _visited.set_limit(-1);
+            _visited_limit = -1;
+            _visited_filter = detail::blocked_bloom_filter(expected_count, false_positive_rate);
+        }
+
+        // approximate memory used by the visited parameters, in bytes
+        auto visited_memory() const { return _visited.memory() + _visited_filter.memory() + _cache.memory(); }
+
+        //------------------------------------------------------------------------------------------
+        // the cache keeps the targets of all tried parameters, the exact parameters replace their hashes
+        // in the visited parameters, so a hash collision can't skip new parameters
+        // the cache is shared by the threads and saved with the optimizer state
+        //------------------------------------------------------------------------------------------
+        void set_cache(bool enable)
+        {
+            _cache_enabled = enable;
+            if (!enable)
+                _cache.clear();
+        }
+
+        // target of the parameters tried before, if the cache is enabled
+        auto cached_target(const std::tuple<Types...>& params) const { return _cache.find(params); }
+
+        //------------------------------------------------------------------------------------------
+        // new parameters are rounded to min_value + n * step, so close parameters become the same
+        // and are tried once, zero step leaves the parameter unchanged, steps of range parameters are ranges
+        //------------------------------------------------------------------------------------------
+        void set_grid(Types ... steps) { _grid = std::tuple{ std::move(steps)... }; }
+        void clear_grid() { _grid.reset(); }
+
         //------------------------------------------------------------------------------------------
         // adding a solution with a known target
         // adding a known good solution can speed up optimzation
@@ -146,8 +849,45 @@ namespace gb::yadro::algorithm
         auto add_solution(auto&& ... params) requires (sizeof...(params) == sizeof...(Types))
         {
             // order of evalution of function parameters is unspecified, must calculate target first
-            auto target = std::invoke(_target_fn, params ...);
-            _opt_map.emplace(std::move(target), std::tuple{ std::forward<decltype(params)>(params)... });
+            if constexpr (is_batch)
+            {
+                std::tuple<Types...> batch[]{ { params... } };
+                auto targets = std::invoke(_target_fn, std::span<const std::tuple<Types...>>(batch));
+                _opt_map.emplace(*std::ranges::begin(targets), std::move(batch[0]));
+            }
+            else
+            {
+                auto target = std::invoke(_target_fn, params ...);
+                _opt_map.emplace(std::move(target), std::tuple{ std::forward<decltype(params)>(params)... });
+            }
+        }
+
+        //------------------------------------------------------------------------------------------
+        // adding solutions with known targets, e.g. received from other optimizers
+        // the parameters already tried are skipped
+        //------------------------------------------------------------------------------------------
+        void add_solutions(std::ranges::input_range auto&& solutions)
+        {
+            for (auto&& [target, params] : solutions)
+            {
+                if (_cache_enabled ? _cache.insert(params) : insert_visited(gb::yadro::util::make_hash(params)))
+                {
+                    _opt_map.emplace(target, params);
+                    if (_cache_enabled)
+                        _cache.set(params, target);
+                }
+            }
+        }
+
+        //------------------------------------------------------------------------------------------
+        // best solutions found so far, at most count
+        //------------------------------------------------------------------------------------------
+        auto best_solutions(std::size_t count) const
+        {
+            std::vector<solution_t> solutions;
+            for (auto&& [target, params] : _opt_map | std::views::take(count))
+                solutions.emplace_back(target, params);
+            return solutions;
         }
 
         //------------------------------------------------------------------------------------------
@@ -175,25 +915,83 @@ namespace gb::yadro::algorithm
         template<class Rep, class Period>
         auto optimize(gb::yadro::async::threadpool<>& tp, target_t acceptable_target, std::chrono::duration<Rep, Period> duration, std::size_t max_history = -1, std::size_t max_tries = -1);
 
+        //------------------------------------------------------------------------------------------
+        // asynchronous steady state optimization using threadpool (intended for target functions of varying cost)
+        // the calling thread breeds new parameters from the best solutions whenever a worker is free
+        // and merges the results as they arrive, the workers never wait for each other
+        //------------------------------------------------------------------------------------------
+        template<class Rep, class Period>
+        auto optimize_steady(gb::yadro::async::threadpool<>& tp, std::chrono::duration<Rep, Period> duration, std::size_t max_history = -1, std::size_t max_tries = -1)
+        {
+            return optimize_steady_state(tp, std::nullopt, duration, max_history, max_tries);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // same as above, but also specifying acceptable target, after satisfying which the optimization may stop
+        template<class Rep, class Period>
+        auto optimize_steady(gb::yadro::async::threadpool<>& tp, target_t acceptable_target, std::chrono::duration<Rep, Period> duration,
+            std::size_t max_history = -1, std::size_t max_tries = -1)
+        {
+            return optimize_steady_state(tp, std::move(acceptable_target), duration, max_history, max_tries);
+        }
+
         //------------------------------------------------------------------------------------------
         // clear the state
         //------------------------------------------------------------------------------------------
-        void clear() { _visited.clear(); _opt_map.clear(); }
+        void clear() { _visited.clear(); _visited_filter.clear(); _cache.clear(); _opt_map.clear(); _adaptive_state.reset(); }
 
         //------------------------------------------------------------------------------------------
         // serialize the state in the archive
         //------------------------------------------------------------------------------------------
+        static constexpr std::uint32_t serialization_version = 3;
+
         auto serialize(this auto&& self, auto&& archive)
         {
-            std::invoke(std::forward<decltype(archive)>(archive), self._visited, self._opt_map, self._opt_param);
+            self.serialize(archive, serialization_version);
+        }
+
+        // version 1 had no visited set limit and filter, version 2 had no cache and grid
+        auto serialize(this auto&& self, auto&& archive, std::uint32_t version)
+        {
+            std::invoke(archive, self._visited, self._opt_map, self._opt_param);
+            if (version >= 2)
+            {
+                std::invoke(archive, gb::yadro::archive::serialize_as<std::uint64_t>(self._visited_limit), self._visited_filter);
+                if constexpr (gb::yadro::archive::is_iarchive_v<decltype(archive)>)
+                    self._visited.set_limit(self._visited_limit);
+            }
+            if (version >= 3)
+                std::invoke(archive, self._cache_enabled, self._cache, self._grid);
         }
 
     private:
         Fn _target_fn;
         std::tuple<std::tuple<Types, Types>...> _min_max_params;
-        util::mutexer<std::mutex> _m;
-        std::unordered_set<std::size_t> _visited; // hashes of already tried parameters
-        std::multimap<target_t, std::tuple<Types...>, CompareFn> _opt_map; // target functions calculated
+        util::mutexer<std::mutex> _m; // protects _opt_map while optimizing
+        detail::sharded_hash_set _visited; // hashes of already tried parameters
+        std::size_t _visited_limit = -1;
+        detail::blocked_bloom_filter _visited_filter; // replaces _visited when not empty
+        bool _cache_enabled = false; // _cache replaces _visited and _visited_filter
+        detail::evaluation_cache<std::tuple<Types...>, target_t> _cache;
+        std::optional<std::tuple<Types...>> _grid;
+        using opt_map_t = std::multimap<target_t, std::tuple<Types...>, CompareFn>;
+        opt_map_t _opt_map; // target functions calculated
+        std::size_t _sync_loops = 64;
+        std::chrono::microseconds _sync_period{ 10'000 };
+        static constexpr std::size_t elite_size = 2; // the parents are the two best solutions
+        static constexpr bool is_batch = detail::batch_target_fn<Fn, Types...>;
+        std::size_t _batch_size = 16;
+
+        // telemetry of the current optimization, protected by _m
+        struct telemetry_t
+        {
+            std::function<void(const telemetry_sample<target_t>&)> fn;
+            std::chrono::microseconds period{};
+            std::chrono::high_resolution_clock::time_point start, last;
+            std::size_t thread_count = 1;
+            stats total{}, last_total{};
+            std::chrono::duration<double> busy{}, last_busy{}; // time spent in target function
+        } _telemetry;
 
         //------------------------------------------------------------------------------------------
         // optimization parameters
@@ -210,26 +1008,119 @@ namespace gb::yadro::algorithm
             }
         } _opt_param;
 
-        auto insert_visited(std::size_t v)
+        bool _adaptive = false;
+        detail::adaptive_operators _adaptive_state; // learned in adaptive mode, protected by _m while optimizing
+
+        //------------------------------------------------------------------------------------------
+        // returns true if the parameters with this hash weren't tried
+        bool insert_visited(std::size_t hash)
+        {
+            return _visited_filter.empty() ? _visited.insert(hash) : _visited_filter.insert(hash);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // telemetry of optimization, telemetry_update and telemetry_report are called under _m
+        void telemetry_start(std::size_t thread_count)
         {
             std::lock_guard _(_m);
-            return _visited.insert(v).second;
+            _telemetry.start = _telemetry.last = std::chrono::high_resolution_clock::now();
+            _telemetry.thread_count = std::max<std::size_t>(thread_count, 1);
+            _telemetry.total = _telemetry.last_total = stats{};
+            _telemetry.busy = _telemetry.last_busy = {};
+        }
+
+        void telemetry_update(const stats& delta, std::chrono::duration<double> busy)
+        {
+            if (!_telemetry.fn)
+                return;
+
+            _telemetry.total.add(delta);
+            _telemetry.busy += busy;
+            if (std::chrono::high_resolution_clock::now() - _telemetry.last >= _telemetry.period)
+                telemetry_report(false);
+        }
+
+        void telemetry_report(bool is_final)
+        {
+            auto now = std::chrono::high_resolution_clock::now();
+            auto seconds = std::max(std::chrono::duration<double>(now - _telemetry.last).count(), 1e-9);
+            auto delta = _telemetry.total.since(_telemetry.last_total);
+
+            telemetry_sample<target_t> sample{ now - _telemetry.start,
+                _opt_map.empty() ? std::nullopt : std::optional<target_t>(_opt_map.begin()->first), _telemetry.total,
+                delta.unique_param_count / seconds, delta.improvement_count / seconds,
+                std::min(1., (_telemetry.busy - _telemetry.last_busy).count() / (seconds * _telemetry.thread_count)), is_final };
+
+            _telemetry.last = now;
+            _telemetry.last_total = _telemetry.total;
+            _telemetry.last_busy = _telemetry.busy;
+            _telemetry.fn(sample);
         }
 
-        // emplace the new target and return true if it improved
-        auto opt_map_emplace(auto target, auto&& params, std::size_t max_history)
+        // the final report includes the counters not reported by the optimizing threads
+        void telemetry_finish(const stats& delta = {}, std::chrono::duration<double> busy = {})
         {
             std::lock_guard _(_m);
-            auto improved = _opt_map.empty() || _opt_map.key_comp()(target, _opt_map.begin()->first);
+            if (!_telemetry.fn)
+                return;
+
+            _telemetry.total.add(delta);
+            _telemetry.busy += busy;
+            telemetry_report(true);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // round new parameters to the grid and return true if they weren't tried
+        bool try_visit(std::tuple<Types...>& params)
+        {
+            if (_grid)
+                params = snap_to_grid(params);
+            return _cache_enabled ? _cache.insert(params) : insert_visited(gb::yadro::util::make_hash(params));
+        }
+
+        auto snap_to_grid(const std::tuple<Types...>& params) const
+        {
+            auto snap_value = [](auto v, auto step, auto min_value, auto max_value)
+                {
+                    if (step <= 0)
+                        return v;
+                    auto snapped = static_cast<double>(min_value) + std::round((static_cast<double>(v) - static_cast<double>(min_value)) / static_cast<double>(step)) * static_cast<double>(step);
+                    return static_cast<decltype(v)>(std::clamp(snapped, static_cast<double>(std::min(min_value, max_value)), static_cast<double>(std::max(min_value, max_value))));
+                };
 
-            if (improved || _opt_map.size() < max_history || _opt_map.key_comp()(target, _opt_map.rend()->first))
+            auto snap = [&](auto&& v, auto&& step, auto&& min_max_tuple)
+                {
+                    const auto& [min_value, max_value] = min_max_tuple;
+                    using type = std::remove_cvref_t<decltype(v)>;
+
+                    if constexpr (std::ranges::random_access_range<type>)
+                    {
+                        type result(v);
+                        for (std::size_t i = 0; i < result.size() && i < step.size(); ++i)
+                            result[i] = snap_value(v[i], step[i], min_value[i], max_value[i]);
+                        return result;
+                    }
+                    else
+                        return snap_value(v, step, min_value, max_value);
+                };
+
+            return util::tuple_transform(snap, params, *_grid, _min_max_params);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // emplace the new target into the map of max_history best targets and return true if it improved
+        static auto opt_map_emplace(opt_map_t& opt_map, auto&& target, auto&& params, std::size_t max_history)
+        {
+            auto improved = opt_map.empty() || opt_map.key_comp()(target, opt_map.begin()->first);
+
+            if (improved || opt_map.size() < max_history || opt_map.key_comp()(target, opt_map.rbegin()->first))
             {
-                _opt_map.emplace(target, params);
+                opt_map.emplace(std::forward<decltype(target)>(target), std::forward<decltype(params)>(params));
             }
 
-            while (_opt_map.size() > max_history)
+            while (opt_map.size() > max_history)
             {
-                _opt_map.erase(--_opt_map.end());
+                opt_map.erase(--opt_map.end());
             }
 
             return improved;
@@ -239,6 +1130,112 @@ namespace gb::yadro::algorithm
         // single thread optimization, end when acceptable_target, or timeout, or max_tries are reached
         auto optimize_one(std::optional<target_t> acceptable_target, auto&& duration, std::size_t max_history, std::size_t max_tries);
         auto optimize_in_pool(gb::yadro::async::threadpool<>& tp, std::optional<target_t> acceptable_target, auto&& duration, std::size_t max_history, std::size_t max_tries);
+        auto optimize_steady_state(gb::yadro::async::threadpool<>& tp, std::optional<target_t> acceptable_target, auto&& duration, std::size_t max_history, std::size_t max_tries);
+
+        //------------------------------------------------------------------------------------------
+        // evaluate the parameter sets with one call of batch target function, or one by one
+        auto evaluate_batch(const std::vector<std::tuple<Types...>>& batch)
+        {
+            std::vector<target_t> targets;
+            targets.reserve(batch.size());
+            if constexpr (is_batch)
+            {
+                auto batch_targets = std::invoke(_target_fn, std::span<const std::tuple<Types...>>(batch));
+                util::gbassert(std::ranges::size(batch_targets) == batch.size());
+                std::ranges::copy(batch_targets, std::back_inserter(targets));
+            }
+            else
+            {
+                for (auto&& params : batch)
+                    targets.push_back(std::apply(_target_fn, params));
+            }
+            return targets;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // breed new parameters from the two best, the steps alternate swaps of parameters and gradient moves,
+        // then the parameters are mutated, until they differ from the best or in_time() is false
+        // in adaptive mode one operator is chosen by adaptive state for each step
+        // returns the operators that changed the parameters and the mutated scalars
+        detail::breed_info breed(std::tuple<Types...>& params, const std::tuple<Types...>& first_best, const std::tuple<Types...>& second_best,
+            stats& s, detail::adaptive_operators& adaptive, auto&& in_time) const
+        {
+            detail::breed_info info;
+            if (_adaptive)
+            {
+                do
+                {
+                    auto allowed = first_best != second_best
+                        ? detail::genetic_operator | detail::gradient_operator | detail::mutation_operator : detail::mutation_operator;
+
+                    switch (adaptive.select(random_scalar(0., 1.), allowed))
+                    {
+                    case detail::genetic_operator:
+                        params = swap_parameters(first_best, second_best);
+                        if (params != first_best)
+                        {
+                            ++s.genetic_count;
+                            info.operators = detail::genetic_operator;
+                        }
+                        break;
+                    case detail::gradient_operator:
+                        params = gradient_move(first_best, second_best);
+                        if (params != first_best)
+                        {
+                            ++s.gradient_count;
+                            info.operators = detail::gradient_operator;
+                        }
+                        break;
+                    default:
+                        info.mutated.clear();
+                        params = mutate_steps(first_best, adaptive, info.mutated);
+                        if (params != first_best)
+                        {
+                            ++s.mutation_count;
+                            info.operators = detail::mutation_operator;
+                        }
+                        break;
+                    }
+                } while (params == first_best && in_time());
+                return info;
+            }
+
+            unsigned operators = 0;
+            do
+            {
+                if (first_best != second_best)
+                {
+                    if ((s.loop_count & 1) == 0)
+                    {
+                        params = swap_parameters(first_best, second_best);
+                        if (params != first_best)
+                        {
+                            ++s.genetic_count;
+                            operators |= detail::genetic_operator;
+                        }
+                    }
+                    else
+                    {
+                        params = gradient_move(first_best, second_best);
+                        if (params != first_best)
+                        {
+                            ++s.gradient_count;
+                            operators |= detail::gradient_operator;
+                        }
+                    }
+                }
+
+                if (auto mutated_params = mutate_parameters(params); params != mutated_params)
+                {
+                    params = mutated_params;
+                    ++s.mutation_count;
+                    operators |= detail::mutation_operator;
+                }
+
+            } while (params == first_best && in_time());
+            info.operators = operators;
+            return info;
+        }
 
         //------------------------------------------------------------------------------------------
         // random functions
@@ -314,6 +1311,56 @@ namespace gb::yadro::algorithm
                 { return mutate_param(param, min_max_tuple); }, param_tuple, _min_max_params);
         }
 
+        //------------------------------------------------------------------------------------------
+        // move random parameters by normally distributed steps, the steps are fractions of the parameter ranges
+        // in adaptive state, integer parameters move at least by one, indices of moved scalars are added to mutated
+        auto mutate_steps(const std::tuple<Types...>& param_tuple, detail::adaptive_operators& adaptive, std::vector<std::uint32_t>& mutated) const
+        {
+            std::uint32_t index = 0;
+            auto mutate_value = [&](auto param, auto min_value, auto max_value)
+                {
+                    using type = decltype(param);
+                    auto i = index++;
+                    auto low = std::min(static_cast<double>(min_value), static_cast<double>(max_value));
+                    auto high = std::max(static_cast<double>(min_value), static_cast<double>(max_value));
+                    if (low == high || random_scalar(0., 1.) >= _opt_param.mutation_probability)
+                        return param;
+
+                    auto step = std::normal_distribution<>{ 0., adaptive.step(i) * (high - low) }(random_generator());
+                    auto value = std::clamp(static_cast<double>(param) + step, low, high);
+                    if constexpr (std::integral<type>)
+                    {
+                        value = std::round(value);
+                        if (value == static_cast<double>(param))
+                            value = std::clamp(value + (step < 0 ? -1. : 1.), low, high);
+                    }
+                    mutated.push_back(i);
+                    return static_cast<type>(value);
+                };
+            auto mutate_param = [&](auto& param, auto&& min_max_tuple)
+                {
+                    const auto& [min_value, max_value] = min_max_tuple;
+                    using type = std::remove_cvref_t<decltype(param)>;
+
+                    if constexpr (std::ranges::random_access_range<type>)
+                    {
+                        util::gbassert(min_value.size() == max_value.size() && param.size() == min_value.size());
+                        for (std::size_t i = 0; i < param.size(); ++i)
+                            param[i] = mutate_value(param[i], min_value[i], max_value[i]);
+                    }
+                    else
+                        param = mutate_value(param, min_value, max_value);
+                };
+
+            // the parameters are mutated in order, so the indices of the scalars are the same in every call
+            auto result = param_tuple;
+            [&]<std::size_t ...I>(std::index_sequence<I...>)
+            {
+                (mutate_param(std::get<I>(result), std::get<I>(_min_max_params)), ...);
+            }(std::index_sequence_for<Types...>{});
+            return result;
+        }
+
         //------------------------------------------------------------------------------------------
         // return tuple containing random swaps between parent tuples, tuple_latest is the best
         auto swap_parameters(auto&& tuple_latest, auto&& tuple_prev) const
@@ -388,128 +1435,333 @@ namespace gb::yadro::algorithm
     template<class Fn, class ...Types>
     genetic_optimization_t(const std::string&, Fn, std::tuple<Types, Types> ...) -> genetic_optimization_t<Fn, std::less<>, Types...>;
 
-
     //------------------------------------------------------------------------------------------
-    // statistics for genetic_optimization_t
-    struct stats
+    template<class Fn, class CompareFn, class ...Types>
+    auto genetic_optimization_t<Fn, CompareFn, Types...>::optimize_one(std::optional<target_t> acceptable_target, auto&& duration, std::size_t max_history, std::size_t max_tries)
     {
-        std::size_t gradient_count;
-        std::size_t genetic_count;
-        std::size_t mutation_count;
-        std::size_t improvement_count;
-        std::size_t repetition_count;
-        std::size_t loop_count;
-        std::size_t unique_param_count;
+        auto rand_params = random_initializer();
+        auto start_time = std::chrono::high_resolution_clock::now();
+        stats s{};
 
-        void add(const stats& other)
-        {
-            gradient_count += other.gradient_count;
-            genetic_count += other.genetic_count;
-            mutation_count += other.mutation_count;
-            improvement_count += other.improvement_count;
-            repetition_count += other.repetition_count;
-            loop_count += other.loop_count;
-            unique_param_count += other.unique_param_count;
+        // the thread breeds from the local elite, new solutions are merged into _opt_map in sync
+        opt_map_t elite(_opt_map.key_comp());
+        std::vector<std::tuple<target_t, std::tuple<Types...>>> fresh;
+        auto last_sync = start_time;
+        std::size_t sync_loops = 0;
+        auto is_acceptable_target = false;
+        auto reached_target = false;
+        auto last_target_update = start_time;
+
+        // unique parameters are collected into a batch with the operators that made them, evaluated when it's full
+        std::vector<std::tuple<Types...>> batch;
+        std::vector<detail::breed_info> batch_info;
+        detail::breed_info info;
+        detail::adaptive_operators adaptive, adaptive_base;
+        if (_adaptive)
+        {   // the thread learns on a copy of the shared state, in sync its changes since the copy are merged
+            // into the shared state, so the other threads' learning is kept, then the thread copies the result
+            std::lock_guard _(_m);
+            adaptive = adaptive_base = _adaptive_state;
         }
+        const auto batch_size = is_batch ? _batch_size : 1;
+        batch.reserve(batch_size);
 
-        friend auto& operator<< (std::ostream& os, const stats& s)
+        // the time in target function and the counters already reported to telemetry
+        const auto has_telemetry = static_cast<bool>(_telemetry.fn);
+        std::chrono::duration<double> busy{};
+        stats reported{};
+        std::chrono::duration<double> reported_busy{};
+
+        auto evaluate = [&]
+            {
+                auto ingest = [&](auto&& new_target, const auto& params, const detail::breed_info& param_info)
+                    {
+                        if (_cache_enabled)
+                            _cache.set(params, new_target);
+                        reached_target = reached_target || (acceptable_target && CompareFn{}(new_target, acceptable_target.value()));
+                        auto improved = opt_map_emplace(elite, new_target, params, elite_size);
+                        if (improved)
+                        {
+                            last_target_update = std::chrono::high_resolution_clock::now();
+                            ++s.improvement_count;
+                            s.add_success(param_info.operators);
+                        }
+                        if (_adaptive)
+                            adaptive.reward(param_info, improved);
+                        fresh.emplace_back(std::forward<decltype(new_target)>(new_target), params);
+                    };
+
+                if (batch.empty())
+                    return;
+
+                auto timed = [&](auto&& fn)
+                    {
+                        if (!has_telemetry)
+                            return fn();
+                        auto evaluation_start = std::chrono::high_resolution_clock::now();
+                        auto result = fn();
+                        busy += std::chrono::high_resolution_clock::now() - evaluation_start;
+                        return result;
+                    };
+
+                if constexpr (is_batch)
+                {
+                    auto targets = timed([&] { return evaluate_batch(batch); });
+                    for (std::size_t i = 0; i < batch.size(); ++i)
+                        ingest(std::move(targets[i]), batch[i], batch_info[i]);
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < batch.size(); ++i)
+                        ingest(timed([&] { return std::apply(_target_fn, batch[i]); }), batch[i], batch_info[i]);
+                }
+                batch.clear();
+                batch_info.clear();
+            };
+
+        auto sync = [&]
+            {
+                std::lock_guard _(_m);
+                for (auto&& [target, params] : fresh)
+                    opt_map_emplace(_opt_map, std::move(target), std::move(params), max_history);
+                fresh.clear();
+
+                elite.clear();
+                for (auto&& solution : _opt_map | std::views::take(elite_size))
+                    elite.insert(solution);
+
+                is_acceptable_target = acceptable_target && !_opt_map.empty()
+                    && CompareFn{}(_opt_map.begin()->first, acceptable_target.value());
+                last_sync = std::chrono::high_resolution_clock::now();
+                sync_loops = 0;
+                reached_target = false;
+                if (_adaptive)
+                {
+                    _adaptive_state.merge(adaptive, adaptive_base);
+                    adaptive = adaptive_base = _adaptive_state;
+                }
+
+                if (has_telemetry)
+                {
+                    telemetry_update(s.since(reported), busy - reported_busy);
+                    reported = s;
+                    reported_busy = busy;
+                }
+            };
+        sync();
+
+        for (;
+            max_tries != 0 && std::chrono::high_resolution_clock::now() - start_time < duration
+            && std::chrono::high_resolution_clock::now() - last_target_update < std::chrono::duration<double>(duration) / 2
+            && !is_acceptable_target;
+            --max_tries, ++s.loop_count)
         {
-            os << "loops: " << s.loop_count
-                << ", improvements: " << s.improvement_count
-                << ", gradients: " << s.gradient_count
-                << ", genetics: " << s.genetic_count
-                << ", mutations: " << s.mutation_count
-                << ", unique: " << s.unique_param_count
-                << ", repetitions: " << (s.loop_count != 0 ? 100. * s.repetition_count / s.loop_count : 0) << "%"
-                << "\n";
-            return os;
+            if (try_visit(rand_params))
+            {
+                ++s.unique_param_count;
+                batch.push_back(rand_params);
+                batch_info.push_back(std::move(info));
+                if (batch.size() >= batch_size)
+                    evaluate();
+            }
+            else
+            {
+                ++s.repetition_count;
+            }
+
+            if (reached_target || ++sync_loops >= _sync_loops || std::chrono::high_resolution_clock::now() - last_sync >= _sync_period)
+                sync();
+
+            if (elite.empty())
+            {   // only repetitions so far
+                rand_params = random_initializer();
+                info = {};
+                continue;
+            }
+
+            // try next parameter set, two best parents
+            const auto& first_best = elite.begin()->second;
+            const auto& second_best = elite.size() > 1 ? (++elite.begin())->second : first_best;
+            info = breed(rand_params, first_best, second_best, s, adaptive,
+                [&] { return std::chrono::high_resolution_clock::now() - start_time < duration; });
         }
-    };
+
+        evaluate();
+        sync();
+        s.visited_memory = visited_memory();
+        return s;
+    }
 
     //------------------------------------------------------------------------------------------
     template<class Fn, class CompareFn, class ...Types>
-    auto genetic_optimization_t<Fn, CompareFn, Types...>::optimize_one(std::optional<target_t> acceptable_target, auto&& duration, std::size_t max_history, std::size_t max_tries)
+    auto genetic_optimization_t<Fn, CompareFn, Types...>::optimize_steady_state(gb::yadro::async::threadpool<>& tp, std::optional<target_t> acceptable_target,
+        auto&& duration, std::size_t max_history, std::size_t max_tries)
     {
         auto rand_params = random_initializer();
         auto start_time = std::chrono::high_resolution_clock::now();
+        auto last_target_update = start_time;
+        auto in_time = [&] { return std::chrono::high_resolution_clock::now() - start_time < duration; };
         stats s{};
-        
-        auto is_acceptable_target = [&]
+        const auto has_telemetry = static_cast<bool>(_telemetry.fn);
+        stats reported{};
+        telemetry_start(tp.max_thread_count());
+
+        // the workers return the evaluated batches through the queue
+        struct done_t
+        {
+            std::vector<std::tuple<Types...>> batch;
+            std::vector<detail::breed_info> info; // operators that made the parameters
+            std::vector<target_t> targets;
+            std::exception_ptr error;
+            std::chrono::duration<double> busy{}; // time spent in target function
+        };
+        std::mutex m;
+        std::condition_variable cv;
+        std::vector<done_t> done;
+        std::size_t in_flight = 0;
+
+        // next unique parameters, bred from the two best solutions by the operators
+        detail::breed_info info;
+        auto next_params = [&]() -> std::optional<std::tuple<Types...>>
             {
-                if (acceptable_target)
+                for (; max_tries != 0 && in_time() && std::chrono::high_resolution_clock::now() - last_target_update < std::chrono::duration<double>(duration) / 2; --max_tries)
                 {
-                    std::unique_lock _(_m);
-                    return !_opt_map.empty() && CompareFn {}(_opt_map.begin()->first, acceptable_target.value());
+                    {
+                        std::lock_guard _(_m);
+                        if (_opt_map.empty())
+                        {
+                            rand_params = random_initializer();
+                            info = {};
+                        }
+                        else
+                        {
+                            auto first_best = _opt_map.begin();
+                            auto second_best = _opt_map.size() > 1 ? std::next(first_best) : first_best;
+                            info = breed(rand_params, first_best->second, second_best->second, s, _adaptive_state, in_time);
+                        }
+                    }
+                    ++s.loop_count;
+
+                    if (try_visit(rand_params))
+                    {
+                        ++s.unique_param_count;
+                        return rand_params;
+                    }
+                    ++s.repetition_count;
                 }
-                return false;
+                return std::nullopt;
             };
 
-        for (auto last_target_update = start_time;
-            max_tries != 0 && std::chrono::high_resolution_clock::now() - start_time < duration
-            && std::chrono::high_resolution_clock::now() - last_target_update < duration / 2
-            && !is_acceptable_target();
-            --max_tries, ++s.loop_count)
-        {
-            if (insert_visited(gb::yadro::util::make_hash(rand_params)))
+        auto submit = [&]
             {
-                ++s.unique_param_count;
-                auto new_target = std::apply(_target_fn, rand_params);
-
-                if (opt_map_emplace(new_target, rand_params, max_history))
+                done_t task;
+                for (auto batch_size = is_batch ? _batch_size : 1; task.batch.size() < batch_size;)
                 {
-                    last_target_update = std::chrono::high_resolution_clock::now();
-                    ++s.improvement_count;
+                    auto params = next_params();
+                    if (!params)
+                        break;
+                    task.batch.push_back(std::move(*params));
+                    task.info.push_back(std::move(info));
                 }
-            }
-            else
+                if (task.batch.empty())
+                    return false;
+
+                ++in_flight;
+                tp([&, result = std::move(task)]() mutable
+                    {
+                        try
+                        {
+                            auto evaluation_start = std::chrono::high_resolution_clock::now();
+                            result.targets = evaluate_batch(result.batch);
+                            if (has_telemetry)
+                                result.busy = std::chrono::high_resolution_clock::now() - evaluation_start;
+                        }
+                        catch (...)
+                        {
+                            result.error = std::current_exception();
+                        }
+                        // notified under the lock, the optimizer may return as soon as it gets the last result
+                        std::lock_guard _(m);
+                        done.push_back(std::move(result));
+                        cv.notify_one();
+                    });
+                return true;
+            };
+
+        // twice as many tasks as the workers, so a free worker doesn't wait for the next parameters
+        const auto max_in_flight = 2 * std::max<std::size_t>(tp.max_thread_count(), 1);
+        auto stop = false;
+        std::exception_ptr error;
+        while (in_flight < max_in_flight && submit());
+
+        while (in_flight != 0)
+        {
+            std::vector<done_t> arrived;
             {
-                ++s.repetition_count;
+                std::unique_lock lock(m);
+                cv.wait(lock, [&] { return !done.empty(); });
+                arrived.swap(done);
             }
-            
-            // try next parameter set, get copies of two best parents
-            std::tuple<Types...> first_best{};
-            std::tuple<Types...> second_best{};
+            in_flight -= arrived.size();
+
             {
                 std::lock_guard _(_m);
-                first_best = _opt_map.begin()->second;
-                second_best = _opt_map.size() > 1 ? (++_opt_map.begin())->second : first_best;
-            }
-            // get a new parameter set
-            do
-            {
-                if (first_best != second_best)
+                std::chrono::duration<double> busy{};
+                for (auto&& result : arrived)
                 {
-                    if ((s.loop_count & 1) == 0)
+                    if (result.error)
                     {
-                        rand_params = swap_parameters(first_best, second_best);
-                        if (rand_params != first_best)
-                            ++s.genetic_count;
+                        error = error ? error : result.error;
+                        stop = true;
+                        continue;
                     }
-                    else
+
+                    busy += result.busy;
+                    for (std::size_t i = 0; i < result.batch.size(); ++i)
                     {
-                        rand_params = gradient_move(first_best, second_best);
-                        if (rand_params != first_best)
-                            ++s.gradient_count;
+                        if (_cache_enabled)
+                            _cache.set(result.batch[i], result.targets[i]);
+                        if (acceptable_target && CompareFn{}(result.targets[i], acceptable_target.value()))
+                            stop = true;
+                        auto improved = opt_map_emplace(_opt_map, std::move(result.targets[i]), std::move(result.batch[i]), max_history);
+                        if (improved)
+                        {
+                            last_target_update = std::chrono::high_resolution_clock::now();
+                            ++s.improvement_count;
+                            s.add_success(result.info[i].operators);
+                        }
+                        if (_adaptive)
+                            _adaptive_state.reward(result.info[i], improved);
                     }
                 }
-                
-                if(auto mutated_params = mutate_parameters(rand_params); rand_params != mutated_params)
+
+                if (has_telemetry)
                 {
-                    rand_params = mutated_params;
-                    ++s.mutation_count;
+                    telemetry_update(s.since(reported), busy);
+                    reported = s;
                 }
+            }
 
-            } while (rand_params == first_best && std::chrono::high_resolution_clock::now() - start_time < duration);
+            while (!stop && in_flight < max_in_flight && submit());
         }
-        return s;
+
+        telemetry_finish(s.since(reported));
+        if (error)
+            std::rethrow_exception(error);
+
+        s.visited_memory = visited_memory();
+        return std::tuple(s, _opt_map);
     }
-    
+
     //------------------------------------------------------------------------------------------
     template<class Fn, class CompareFn, class ...Types>
     template<class Rep, class Period>
     auto genetic_optimization_t<Fn, CompareFn, Types...>::optimize(std::chrono::duration<Rep, Period> duration, std::size_t max_history, std::size_t max_tries)
     {
-        return std::tuple(optimize_one(std::nullopt, duration, max_history, max_tries), _opt_map);
+        telemetry_start(1);
+        auto s = optimize_one(std::nullopt, duration, max_history, max_tries);
+        telemetry_finish();
+        return std::tuple(s, _opt_map);
     }
 
     //------------------------------------------------------------------------------------------
@@ -517,7 +1769,10 @@ namespace gb::yadro::algorithm
     template<class Rep, class Period>
     auto genetic_optimization_t<Fn, CompareFn, Types...>::optimize(target_t acceptable_target, std::chrono::duration<Rep, Period> duration, std::size_t max_history, std::size_t max_tries)
     {
-        return std::tuple(optimize_one(acceptable_target, duration, max_history, max_tries), _opt_map);
+        telemetry_start(1);
+        auto s = optimize_one(acceptable_target, duration, max_history, max_tries);
+        telemetry_finish();
+        return std::tuple(s, _opt_map);
     }
 
     //------------------------------------------------------------------------------------------
@@ -526,6 +1781,7 @@ namespace gb::yadro::algorithm
         auto&& duration, std::size_t max_history, std::size_t max_tries)
     {
         std::vector<std::future<stats>> futures;
+        telemetry_start(tp.max_thread_count());
 
         for (std::size_t i = 0, thread_count = tp.max_thread_count(); i < thread_count; ++i)
         {
@@ -541,6 +1797,7 @@ namespace gb::yadro::algorithm
             s.add(f.get());
         }
 
+        telemetry_finish();
         return std::tuple(s, _opt_map);
     }
     
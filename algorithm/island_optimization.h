@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2024, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+#include <map>
+#include <unordered_set>
+#include <vector>
+#include <tuple>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "../util/gbutil.h"
+#include "../async/threadpool.h"
+#include "genetic_optimization.h"
+
+//-----------------------------------------------------------------------------
+// island model of genetic optimization
+//  each island is an optimizer, usually in its own process, optimizing in epochs,
+//  after each epoch the island sends its best solutions (migrants) to the hub
+//  and receives the best solutions of the other islands, which become parents of the next epoch
+//  the hub is served by the RPC transport of util: unix_socket for std::string name,
+//  win_pipe for std::wstring name, solutions are sent as archive-serialized vectors
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::algorithm
+{
+    // hub functions
+    inline constexpr std::uint32_t island_exchange = 0;
+    inline constexpr std::uint32_t island_best = 1;
+
+    //------------------------------------------------------------------------------------------
+    // hub keeps the best solutions of all islands, at most capacity
+    template<class Target, class Params, class CompareFn = std::less<>>
+    struct island_hub_t
+    {
+        using solution_t = std::tuple<Target, Params>;
+
+        explicit island_hub_t(std::size_t capacity) : _capacity(capacity) {}
+
+        //------------------------------------------------------------------------------------------
+        // add migrants of the island and return at most count best solutions of the other islands
+        auto exchange(std::uint32_t island, const std::vector<solution_t>& migrants, std::size_t count)
+        {
+            std::lock_guard _(_m);
+            for (auto&& [target, params] : migrants)
+            {
+                if (_hashes.insert(util::make_hash(params)).second)
+                    _solutions.emplace(target, std::tuple{ island, params });
+            }
+
+            while (_solutions.size() > _capacity)
+            {
+                _hashes.erase(util::make_hash(std::get<1>(std::prev(_solutions.end())->second)));
+                _solutions.erase(std::prev(_solutions.end()));
+            }
+
+            std::vector<solution_t> immigrants;
+            for (auto it = _solutions.begin(); it != _solutions.end() && immigrants.size() < count; ++it)
+            {
+                if (auto&& [from, params] = it->second; from != island)
+                    immigrants.emplace_back(it->first, params);
+            }
+            return immigrants;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // at most count best solutions of all islands
+        auto best(std::size_t count) const
+        {
+            std::lock_guard _(_m);
+            std::vector<solution_t> solutions;
+            for (auto it = _solutions.begin(); it != _solutions.end() && solutions.size() < count; ++it)
+                solutions.emplace_back(it->first, std::get<1>(it->second));
+            return solutions;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // serve the islands until shutdown_server is called
+        void run(const auto& name, std::shared_ptr<util::logger> log = nullptr)
+        {
+            util::start_server(name, log,
+                [this](std::uint32_t island, const std::vector<solution_t>& migrants, std::size_t count)
+                {
+                    return exchange(island, migrants, count);
+                },
+                [this](std::size_t count) { return best(count); });
+        }
+
+    private:
+        mutable std::mutex _m;
+        std::size_t _capacity;
+        std::multimap<Target, std::tuple<std::uint32_t, Params>, CompareFn> _solutions;
+        std::unordered_set<std::size_t> _hashes; // parameters of the kept solutions
+    };
+
+    //------------------------------------------------------------------------------------------
+    // hub for the solutions of optimizer type
+    template<class Optimizer>
+    using island_hub_for = island_hub_t<typename Optimizer::target_t, typename Optimizer::params_t, typename Optimizer::compare_t>;
+
+    namespace detail
+    {
+        //------------------------------------------------------------------------------------------
+        // optimize_epoch(optimizer) runs one epoch, returning tuple(stats, optimization_map)
+        auto optimize_island(auto& optimizer, auto& hub_client, std::uint32_t island, std::size_t epochs,
+            std::size_t migrant_count, auto&& optimize_epoch)
+        {
+            using solution_t = typename std::remove_cvref_t<decltype(optimizer)>::solution_t;
+            auto exchange = [&]
+                {
+                    auto immigrants = hub_client.template request<std::vector<solution_t>>(island_exchange,
+                        island, optimizer.best_solutions(migrant_count), migrant_count);
+                    if (!immigrants)
+                        throw util::exception_t("island exchange failed: " + immigrants.error());
+                    optimizer.add_solutions(*immigrants);
+                };
+
+            auto result = optimize_epoch(optimizer);
+            for (std::size_t epoch = 1; epoch < epochs; ++epoch)
+            {
+                exchange();
+                auto [epoch_stats, opt_map] = optimize_epoch(optimizer);
+                std::get<0>(result).add(epoch_stats);
+                std::get<1>(result) = std::move(opt_map);
+            }
+            exchange(); // the hub gets the final solutions
+            return result;
+        }
+    }
+
+    //------------------------------------------------------------------------------------------
+    // optimize the island for epochs of epoch_duration, exchanging migrant_count solutions with the hub after each epoch
+    // hub_client is an RPC client connected to the hub (unix_socket_client_t, winpipe_client_t)
+    // returns tuple(optimization_stats, optimization_map) like genetic_optimization_t::optimize
+    template<class Optimizer, class Rep, class Period>
+    auto optimize_island(Optimizer& optimizer, auto& hub_client, std::uint32_t island, std::chrono::duration<Rep, Period> epoch_duration,
+        std::size_t epochs, std::size_t migrant_count, std::size_t max_history = -1)
+    {
+        return detail::optimize_island(optimizer, hub_client, island, epochs, migrant_count,
+            [&](auto& opt) { return opt.optimize(epoch_duration, max_history); });
+    }
+
+    //------------------------------------------------------------------------------------------
+    // multithreaded version of the above, each epoch runs in threadpool
+    template<class Optimizer, class Rep, class Period>
+    auto optimize_island(gb::yadro::async::threadpool<>& tp, Optimizer& optimizer, auto& hub_client, std::uint32_t island,
+        std::chrono::duration<Rep, Period> epoch_duration, std::size_t epochs, std::size_t migrant_count, std::size_t max_history = -1)
+    {
+        return detail::optimize_island(optimizer, hub_client, island, epochs, migrant_count,
+            [&](auto& opt) { return opt.optimize(tp, epoch_duration, max_history); });
+    }
+}
@@ -0,0 +1,733 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2024, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+#include <map>
+#include <vector>
+#include <tuple>
+#include <span>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <numeric>
+#include <ranges>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+
+#include "../util/gbutil.h"
+#include "../async/threadpool.h"
+#include "../archive/archive.h"
+#include "../archive/versioned.h"
+#include "../container/matrix_functions.h"
+#include "genetic_optimization.h"
+
+//-----------------------------------------------------------------------------
+// population based optimization
+//  population_optimization_t evolves a population of parameter sets with the strategy:
+//  tournament_ga_t - genetic algorithm with tournament selection, blend crossover and gaussian mutation
+//  differential_evolution_t - differential evolution (rand/1/bin)
+//  cma_es_t - covariance matrix adaptation evolution strategy
+//  parameters are supplied in min_max tuples like in genetic_optimization_t, the strategies work
+//  in the unit hypercube, where every scalar parameter or range element is mapped to [0, 1],
+//  integral parameters are rounded
+//  every generation is evaluated at once, on the threadpool if it's supplied
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::algorithm
+{
+    namespace detail
+    {
+        //------------------------------------------------------------------------------------------
+        // mapping of parameters to the unit hypercube and back
+        // the size of range parameters is taken from their min values
+        template<class ...Types>
+        struct unit_codec_t
+        {
+            std::tuple<std::tuple<Types, Types>...> min_max;
+
+            auto dimension() const
+            {
+                return std::apply([](auto&& ... mm) { return (std::size_t(0) + ... + size_of(std::get<0>(mm))); }, min_max);
+            }
+
+            auto encode(const std::tuple<Types...>& params) const
+            {
+                std::vector<double> x;
+                x.reserve(dimension());
+                [&]<std::size_t ...I>(std::index_sequence<I...>)
+                {
+                    (encode_one(x, std::get<I>(params), std::get<I>(min_max)), ...);
+                }(std::index_sequence_for<Types...>{});
+                return x;
+            }
+
+            auto decode(std::span<const double> x) const
+            {
+                util::gbassert(x.size() == dimension());
+                std::size_t offset = 0;
+                // braced initialization is evaluated left to right
+                return [&]<std::size_t ...I>(std::index_sequence<I...>)
+                {
+                    return std::tuple<Types...>{ decode_one<Types>(x, offset, std::get<I>(min_max))... };
+                }(std::index_sequence_for<Types...>{});
+            }
+
+        private:
+            static std::size_t size_of(const auto& v)
+            {
+                if constexpr (std::ranges::random_access_range<std::remove_cvref_t<decltype(v)>>)
+                    return std::ranges::size(v);
+                else
+                    return 1;
+            }
+
+            static double to_unit(auto v, auto min_value, auto max_value)
+            {
+                auto range = static_cast<double>(max_value) - static_cast<double>(min_value);
+                return range > 0 ? (static_cast<double>(v) - static_cast<double>(min_value)) / range : 0.;
+            }
+
+            template<class T>
+            static T from_unit(double u, T min_value, T max_value)
+            {
+                auto v = static_cast<double>(min_value) + std::clamp(u, 0., 1.) * (static_cast<double>(max_value) - static_cast<double>(min_value));
+                if constexpr (std::is_integral_v<T>)
+                    v = std::round(v);
+                return static_cast<T>(std::clamp(v, static_cast<double>(min_value), static_cast<double>(max_value)));
+            }
+
+            static void encode_one(std::vector<double>& x, const auto& v, const auto& mm)
+            {
+                const auto& [min_value, max_value] = mm;
+                if constexpr (std::ranges::random_access_range<std::remove_cvref_t<decltype(v)>>)
+                {
+                    for (std::size_t i = 0; i < std::ranges::size(min_value); ++i)
+                        x.push_back(to_unit(v[i], min_value[i], max_value[i]));
+                }
+                else
+                    x.push_back(to_unit(v, min_value, max_value));
+            }
+
+            template<class T>
+            static T decode_one(std::span<const double> x, std::size_t& offset, const auto& mm)
+            {
+                const auto& [min_value, max_value] = mm;
+                if constexpr (std::ranges::random_access_range<T>)
+                {
+                    T v(std::ranges::size(min_value));
+                    for (std::size_t i = 0; i < v.size(); ++i)
+                        v[i] = from_unit(x[offset++], min_value[i], max_value[i]);
+                    return v;
+                }
+                else
+                    return from_unit(x[offset++], min_value, max_value);
+            }
+        };
+
+        //------------------------------------------------------------------------------------------
+        // population is sorted from the best target to the worst
+        inline void sort_population(auto& population, auto&& compare)
+        {
+            std::ranges::stable_sort(population, [&](auto&& a, auto&& b) { return compare(std::get<0>(a), std::get<0>(b)); });
+        }
+
+        inline void clamp_unit(std::vector<double>& x)
+        {
+            for (auto& v : x)
+                v = std::clamp(v, 0., 1.);
+        }
+    }
+
+    //------------------------------------------------------------------------------------------
+    // genetic algorithm with tournament selection
+    // the children are bred from the tournament winners by blend crossover and gaussian mutation,
+    // elite_count best solutions survive unchanged
+    //------------------------------------------------------------------------------------------
+    struct tournament_ga_t
+    {
+        std::size_t population_size = 0; // 0 for 10 * dimension, between 20 and 200
+        std::size_t tournament_size = 3;
+        std::size_t elite_count = 1;
+        double crossover_probability = 0.9;
+        double mutation_probability = 0; // of every coordinate, 0 for 1 / dimension
+        double mutation_sigma = 0.1; // part of parameter range
+
+        auto size(std::size_t dimension) const
+        {
+            return std::max(population_size ? population_size : std::clamp<std::size_t>(10 * dimension, 20, 200), elite_count + 2);
+        }
+
+        void reset() {}
+
+        void generation(auto& population, auto&& evaluate, auto&& compare, std::mt19937_64& rng)
+        {
+            auto n = population.size();
+            auto dimension = std::get<1>(population.front()).size();
+            auto elites = std::min(elite_count, n);
+            auto pm = mutation_probability > 0 ? mutation_probability : 1. / dimension;
+
+            std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+            std::uniform_real_distribution<double> unit(0., 1.), blend(-0.25, 1.25);
+            std::normal_distribution<double> mutation(0., mutation_sigma);
+
+            // population is sorted, the lowest index wins the tournament
+            auto select = [&]
+                {
+                    auto winner = pick(rng);
+                    for (std::size_t i = 1; i < tournament_size; ++i)
+                        winner = std::min(winner, pick(rng));
+                    return winner;
+                };
+
+            std::vector<std::vector<double>> children;
+            children.reserve(n - elites);
+            while (children.size() < n - elites)
+            {
+                const auto& parent1 = std::get<1>(population[select()]);
+                const auto& parent2 = std::get<1>(population[select()]);
+                auto child = parent1;
+
+                if (unit(rng) < crossover_probability)
+                    for (std::size_t i = 0; i < dimension; ++i)
+                        child[i] += blend(rng) * (parent2[i] - parent1[i]);
+
+                for (auto& v : child)
+                    if (unit(rng) < pm)
+                        v += mutation(rng);
+
+                detail::clamp_unit(child);
+                children.push_back(std::move(child));
+            }
+
+            auto targets = evaluate(children);
+            population.erase(population.begin() + elites, population.end());
+            for (std::size_t i = 0; i < children.size(); ++i)
+                population.emplace_back(std::move(targets[i]), std::move(children[i]));
+            detail::sort_population(population, compare);
+        }
+
+        auto serialize(this auto&& self, auto&& archive)
+        {
+            std::invoke(std::forward<decltype(archive)>(archive), self.population_size, self.tournament_size, self.elite_count,
+                self.crossover_probability, self.mutation_probability, self.mutation_sigma);
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // differential evolution, rand/1/bin scheme
+    // every member competes with its trial: a random member moved by the weighted difference of
+    // two other random members, crossed over with the member
+    //------------------------------------------------------------------------------------------
+    struct differential_evolution_t
+    {
+        std::size_t population_size = 0; // 0 for 10 * dimension, between 20 and 200
+        double differential_weight = 0.7;
+        double crossover_probability = 0.9;
+
+        auto size(std::size_t dimension) const
+        {
+            return std::max<std::size_t>(population_size ? population_size : std::clamp<std::size_t>(10 * dimension, 20, 200), 4);
+        }
+
+        void reset() {}
+
+        void generation(auto& population, auto&& evaluate, auto&& compare, std::mt19937_64& rng)
+        {
+            auto n = population.size();
+            auto dimension = std::get<1>(population.front()).size();
+            std::uniform_int_distribution<std::size_t> pick(0, n - 1), pick_coordinate(0, dimension - 1);
+            std::uniform_real_distribution<double> unit(0., 1.);
+
+            std::vector<std::vector<double>> trials;
+            trials.reserve(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                std::size_t a, b, c;
+                do a = pick(rng); while (a == i);
+                do b = pick(rng); while (b == i || b == a);
+                do c = pick(rng); while (c == i || c == a || c == b);
+
+                const auto& xa = std::get<1>(population[a]);
+                const auto& xb = std::get<1>(population[b]);
+                const auto& xc = std::get<1>(population[c]);
+                auto trial = std::get<1>(population[i]);
+                auto forced = pick_coordinate(rng); // at least one coordinate comes from the donor
+                for (std::size_t j = 0; j < dimension; ++j)
+                    if (j == forced || unit(rng) < crossover_probability)
+                        trial[j] = xa[j] + differential_weight * (xb[j] - xc[j]);
+
+                detail::clamp_unit(trial);
+                trials.push_back(std::move(trial));
+            }
+
+            auto targets = evaluate(trials);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (!compare(std::get<0>(population[i]), targets[i]))
+                    population[i] = { std::move(targets[i]), std::move(trials[i]) };
+            }
+            detail::sort_population(population, compare);
+        }
+
+        auto serialize(this auto&& self, auto&& archive)
+        {
+            std::invoke(std::forward<decltype(archive)>(archive), self.population_size, self.differential_weight, self.crossover_probability);
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // covariance matrix adaptation evolution strategy, (mu/mu_w, lambda) with rank one and rank mu updates
+    // the search starts from the best member of the random initial population with step sigma,
+    // the offspring outside of the unit hypercube are clamped to it
+    //------------------------------------------------------------------------------------------
+    struct cma_es_t
+    {
+        std::size_t population_size = 0; // lambda, 0 for 4 + 3 * ln(dimension)
+        double sigma = 0.3; // initial step
+
+        auto size(std::size_t dimension) const
+        {
+            return std::max<std::size_t>(population_size ? population_size : 4 + static_cast<std::size_t>(3 * std::log(dimension)), 2);
+        }
+
+        void reset() { _mean.clear(); }
+
+        void generation(auto& population, auto&& evaluate, auto&& compare, std::mt19937_64& rng)
+        {
+            auto n = std::get<1>(population.front()).size();
+            auto lambda = size(n);
+            auto mu = lambda / 2;
+            if (_mean.empty())
+                init(std::get<1>(population.front()));
+
+            // weights and learning rates
+            std::vector<double> weights(mu);
+            for (std::size_t i = 0; i < mu; ++i)
+                weights[i] = std::log(mu + 0.5) - std::log(i + 1.);
+            auto sum = std::accumulate(weights.begin(), weights.end(), 0.);
+            for (auto& w : weights)
+                w /= sum;
+            auto mueff = 1 / std::inner_product(weights.begin(), weights.end(), weights.begin(), 0.);
+
+            auto dn = static_cast<double>(n);
+            auto cc = (4 + mueff / dn) / (dn + 4 + 2 * mueff / dn);
+            auto cs = (mueff + 2) / (dn + mueff + 5);
+            auto c1 = 2 / ((dn + 1.3) * (dn + 1.3) + mueff);
+            auto cmu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((dn + 2) * (dn + 2) + mueff));
+            auto damps = 1 + 2 * std::max(0., std::sqrt((mueff - 1) / (dn + 1)) - 1) + cs;
+            auto chi_n = std::sqrt(dn) * (1 - 1 / (4 * dn) + 1 / (21 * dn * dn));
+
+            // sample the offspring x = mean + step * B * D * z
+            std::normal_distribution<double> normal;
+            std::vector<std::vector<double>> offspring(lambda, std::vector<double>(n));
+            std::vector<double> z(n);
+            for (auto& x : offspring)
+            {
+                for (auto& v : z)
+                    v = normal(rng);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    auto y = 0.;
+                    for (std::size_t j = 0; j < n; ++j)
+                        y += _b(i, j) * _d[j] * z[j];
+                    x[i] = _mean[i] + _step * y;
+                }
+                detail::clamp_unit(x);
+            }
+
+            auto targets = evaluate(offspring);
+            population.clear();
+            for (std::size_t i = 0; i < lambda; ++i)
+                population.emplace_back(std::move(targets[i]), std::move(offspring[i]));
+            detail::sort_population(population, compare);
+
+            // recombination
+            auto old_mean = _mean;
+            std::ranges::fill(_mean, 0.);
+            for (std::size_t k = 0; k < mu; ++k)
+                for (std::size_t i = 0; i < n; ++i)
+                    _mean[i] += weights[k] * std::get<1>(population[k])[i];
+
+            std::vector<double> y_mean(n), c_inv_y(n), tmp(n);
+            for (std::size_t i = 0; i < n; ++i)
+                y_mean[i] = (_mean[i] - old_mean[i]) / _step;
+
+            // C^-1/2 * y_mean = B * D^-1 * B^T * y_mean
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                auto v = 0.;
+                for (std::size_t i = 0; i < n; ++i)
+                    v += _b(i, j) * y_mean[i];
+                tmp[j] = v / _d[j];
+            }
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                auto v = 0.;
+                for (std::size_t j = 0; j < n; ++j)
+                    v += _b(i, j) * tmp[j];
+                c_inv_y[i] = v;
+            }
+
+            // evolution paths
+            auto ps_norm = 0.;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                _ps[i] = (1 - cs) * _ps[i] + std::sqrt(cs * (2 - cs) * mueff) * c_inv_y[i];
+                ps_norm += _ps[i] * _ps[i];
+            }
+            ps_norm = std::sqrt(ps_norm);
+            ++_generation;
+            auto hsig = ps_norm / std::sqrt(1 - std::pow(1 - cs, 2. * _generation)) / chi_n < 1.4 + 2 / (dn + 1);
+            for (std::size_t i = 0; i < n; ++i)
+                _pc[i] = (1 - cc) * _pc[i] + (hsig ? std::sqrt(cc * (2 - cc) * mueff) * y_mean[i] : 0.);
+
+            // covariance matrix
+            auto c_scale = 1 - c1 - cmu + (hsig ? 0. : c1 * cc * (2 - cc));
+            for (std::size_t i = 0; i < n; ++i)
+                for (std::size_t j = 0; j <= i; ++j)
+                {
+                    auto rank_mu = 0.;
+                    for (std::size_t k = 0; k < mu; ++k)
+                    {
+                        const auto& x = std::get<1>(population[k]);
+                        rank_mu += weights[k] * (x[i] - old_mean[i]) * (x[j] - old_mean[j]);
+                    }
+                    _c(i, j) = _c(j, i) = c_scale * _c(i, j) + c1 * _pc[i] * _pc[j] + cmu * rank_mu / (_step * _step);
+                }
+
+            // step size, it can't exceed the hypercube
+            _step = std::min(_step * std::exp(cs / damps * (ps_norm / chi_n - 1)), 1.);
+
+            // B and D from C, the decomposition is O(n^3), it's updated when C changed enough
+            if (_generation - _eigen_generation >= std::max(1., 1 / ((c1 + cmu) * dn * 10)))
+            {
+                _eigen_generation = _generation;
+                std::tie(_d, _b) = container::symmetric_eigen(_c);
+                for (auto& d : _d)
+                    d = std::sqrt(std::max(d, 1e-20));
+            }
+        }
+
+        auto serialize(this auto&& self, auto&& archive)
+        {
+            std::invoke(std::forward<decltype(archive)>(archive), self.population_size, self.sigma,
+                self._mean, self._step, self._pc, self._ps, self._c, self._b, self._d, self._generation, self._eigen_generation);
+        }
+
+    private:
+        std::vector<double> _mean; // empty until the first generation
+        double _step = 0;
+        std::vector<double> _pc, _ps; // evolution paths
+        container::matrix<double> _c, _b; // covariance and its eigenvectors
+        std::vector<double> _d; // square roots of the eigenvalues
+        std::uint64_t _generation = 0;
+        std::uint64_t _eigen_generation = 0; // generation of the last decomposition
+
+        void init(const std::vector<double>& start)
+        {
+            auto n = start.size();
+            _mean = start;
+            _step = sigma;
+            _pc.assign(n, 0.);
+            _ps.assign(n, 0.);
+            _c = container::identity_matrix<double>(n);
+            _b = container::identity_matrix<double>(n);
+            _d.assign(n, 1.);
+            _generation = 0;
+            _eigen_generation = 0;
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // statistics for population_optimization_t
+    struct population_stats
+    {
+        std::size_t generation_count;
+        std::size_t evaluation_count;
+        std::size_t improvement_count;
+
+        void add(const population_stats& other)
+        {
+            generation_count += other.generation_count;
+            evaluation_count += other.evaluation_count;
+            improvement_count += other.improvement_count;
+        }
+
+        friend auto& operator<< (std::ostream& os, const population_stats& s)
+        {
+            os << "generations: " << s.generation_count
+                << ", evaluations: " << s.evaluation_count
+                << ", improvements: " << s.improvement_count
+                << "\n";
+            return os;
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // population based optimization, minimizing target function with the Strategy
+    // target function is the same as in genetic_optimization_t, taking parameters or a batch of them
+    // the optimization map keeps the best solutions of all generations
+    //------------------------------------------------------------------------------------------
+    template<class Strategy, class Fn, class CompareFn, class ...Types>
+    struct population_optimization_t
+    {
+        using target_t = typename detail::target_type<Fn, Types...>::type;
+        using params_t = std::tuple<Types...>;
+        using solution_t = std::tuple<target_t, params_t>;
+        using compare_t = CompareFn;
+        // members in the unit hypercube, sorted from the best
+        using population_t = std::vector<std::tuple<target_t, std::vector<double>>>;
+
+        //------------------------------------------------------------------------------------------
+        // constructor takes comparison function for target function
+        //------------------------------------------------------------------------------------------
+        population_optimization_t(Strategy strategy, Fn target_fn, CompareFn compare, std::tuple<Types, Types> ... min_max)
+            requires ((detail::target_fn<Fn, Types...> && std::invocable<CompareFn, target_t, target_t>))
+            : _strategy(std::move(strategy)), _target_fn(std::move(target_fn)), _codec{ { std::move(min_max)... } }, _opt_map(compare)
+        {
+            util::gbassert(_codec.dimension() != 0);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // constructor uses std::less<> for target function
+        //------------------------------------------------------------------------------------------
+        population_optimization_t(Strategy strategy, Fn target_fn, std::tuple<Types, Types> ... min_max)
+            requires (detail::target_fn<Fn, Types...>)
+            : _strategy(std::move(strategy)), _target_fn(std::move(target_fn)), _codec{ { std::move(min_max)... } }, _opt_map(std::less<>{})
+        {
+            util::gbassert(_codec.dimension() != 0);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // save optimizer state to archive file
+        //------------------------------------------------------------------------------------------
+        void save(const std::filesystem::path& archive_file) const
+        {
+            std::ofstream ofs(archive_file, std::ios::binary);
+            gb::yadro::archive::bin_archive ar(ofs);
+            gb::yadro::archive::write_header(ar);
+            ar(gb::yadro::archive::versioned(*this));
+        }
+
+        //------------------------------------------------------------------------------------------
+        // load optimizer state from archive file
+        //------------------------------------------------------------------------------------------
+        void load(const std::filesystem::path& archive_file)
+        {
+            std::ifstream ifs(archive_file, std::ios::binary);
+            gb::yadro::archive::bin_archive ar(ifs);
+            if (!gb::yadro::archive::read_header(ar))
+                throw gb::yadro::archive::invalid_archive("missing archive header");
+            ar(gb::yadro::archive::versioned(*this));
+        }
+
+        //------------------------------------------------------------------------------------------
+        // strategy settings may be changed between optimizations
+        //------------------------------------------------------------------------------------------
+        auto& strategy() { return _strategy; }
+        const auto& strategy() const { return _strategy; }
+
+        //------------------------------------------------------------------------------------------
+        // best solutions found so far, at most count
+        //------------------------------------------------------------------------------------------
+        auto best_solutions(std::size_t count) const
+        {
+            std::vector<solution_t> solutions;
+            for (auto&& [target, params] : _opt_map | std::views::take(count))
+                solutions.emplace_back(target, params);
+            return solutions;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // evolves the population for duration or max_generations
+        // returns tuple(population_stats, optimization_map), keeping best max_history results in optimization_map
+        // optimize can be called multiple times, it will continue from the previous state, unless cleared
+        //------------------------------------------------------------------------------------------
+        template<class Rep, class Period>
+        auto optimize(std::chrono::duration<Rep, Period> duration, std::size_t max_history = -1, std::size_t max_generations = -1)
+        {
+            return run(nullptr, std::nullopt, duration, max_history, max_generations);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // same as above, but also specifying acceptable target, after satisfying which the optimization stops
+        template<class Rep, class Period>
+        auto optimize(target_t acceptable_target, std::chrono::duration<Rep, Period> duration, std::size_t max_history = -1, std::size_t max_generations = -1)
+        {
+            return run(nullptr, std::move(acceptable_target), duration, max_history, max_generations);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // the generations are evaluated in parallel on the threadpool
+        template<class Rep, class Period>
+        auto optimize(gb::yadro::async::threadpool<>& tp, std::chrono::duration<Rep, Period> duration, std::size_t max_history = -1, std::size_t max_generations = -1)
+        {
+            return run(&tp, std::nullopt, duration, max_history, max_generations);
+        }
+
+        template<class Rep, class Period>
+        auto optimize(gb::yadro::async::threadpool<>& tp, target_t acceptable_target, std::chrono::duration<Rep, Period> duration,
+            std::size_t max_history = -1, std::size_t max_generations = -1)
+        {
+            return run(&tp, std::move(acceptable_target), duration, max_history, max_generations);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // clear the state
+        //------------------------------------------------------------------------------------------
+        void clear() { _population.clear(); _opt_map.clear(); _strategy.reset(); }
+
+        //------------------------------------------------------------------------------------------
+        // serialize the state in the archive
+        //------------------------------------------------------------------------------------------
+        static constexpr std::uint32_t serialization_version = 1;
+
+        auto serialize(this auto&& self, auto&& archive)
+        {
+            std::invoke(std::forward<decltype(archive)>(archive), self._strategy, self._population, self._opt_map);
+        }
+
+    private:
+        Strategy _strategy;
+        Fn _target_fn;
+        detail::unit_codec_t<Types...> _codec;
+        population_t _population;
+        std::multimap<target_t, params_t, CompareFn> _opt_map;
+        std::mt19937_64 _rng{ std::random_device{}() };
+
+        //------------------------------------------------------------------------------------------
+        // evaluate the members in chunks, one chunk per thread
+        auto evaluate(const std::vector<std::vector<double>>& xs, gb::yadro::async::threadpool<>* tp)
+        {
+            auto evaluate_chunk = [&](std::size_t begin, std::size_t end)
+                {
+                    std::vector<params_t> params;
+                    params.reserve(end - begin);
+                    for (auto i = begin; i < end; ++i)
+                        params.push_back(_codec.decode(xs[i]));
+
+                    std::vector<target_t> targets;
+                    targets.reserve(params.size());
+                    if constexpr (detail::batch_target_fn<Fn, Types...>)
+                    {
+                        auto batch_targets = std::invoke(_target_fn, std::span<const params_t>(params));
+                        util::gbassert(std::ranges::size(batch_targets) == params.size());
+                        std::ranges::copy(batch_targets, std::back_inserter(targets));
+                    }
+                    else
+                    {
+                        for (auto&& p : params)
+                            targets.push_back(std::apply(_target_fn, p));
+                    }
+                    return targets;
+                };
+
+            if (!tp || xs.size() < 2)
+                return evaluate_chunk(0, xs.size());
+
+            auto chunks = std::min(tp->max_thread_count(), xs.size());
+            std::vector<std::future<std::vector<target_t>>> futures;
+            for (std::size_t i = 0; i < chunks; ++i)
+                futures.push_back((*tp)([&evaluate_chunk, begin = xs.size() * i / chunks, end = xs.size() * (i + 1) / chunks]
+                    { return evaluate_chunk(begin, end); }));
+
+            std::vector<target_t> targets;
+            targets.reserve(xs.size());
+            for (auto&& f : futures)
+                std::ranges::move(f.get(), std::back_inserter(targets));
+            return targets;
+        }
+
+        //------------------------------------------------------------------------------------------
+        auto run(gb::yadro::async::threadpool<>* tp, std::optional<target_t> acceptable_target, auto&& duration,
+            std::size_t max_history, std::size_t max_generations)
+        {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            population_stats s{};
+            auto compare = _opt_map.key_comp();
+            auto reached_target = false;
+
+            // every evaluated member is offered to the optimization map
+            auto evaluate_and_record = [&](const std::vector<std::vector<double>>& xs)
+                {
+                    auto targets = evaluate(xs, tp);
+                    s.evaluation_count += xs.size();
+                    for (std::size_t i = 0; i < xs.size(); ++i)
+                    {
+                        const auto& target = targets[i];
+                        if (acceptable_target && compare(target, acceptable_target.value()))
+                            reached_target = true;
+
+                        if (_opt_map.empty() || compare(target, _opt_map.begin()->first))
+                            ++s.improvement_count;
+                        if (_opt_map.size() < max_history || (!_opt_map.empty() && compare(target, _opt_map.rbegin()->first)))
+                        {
+                            _opt_map.emplace(target, _codec.decode(xs[i]));
+                            while (_opt_map.size() > max_history)
+                                _opt_map.erase(--_opt_map.end());
+                        }
+                    }
+                    return targets;
+                };
+
+            if (_population.empty())
+            {   // random initial population
+                _strategy.reset();
+                std::uniform_real_distribution<double> unit(0., 1.);
+                std::vector<std::vector<double>> xs(_strategy.size(_codec.dimension()), std::vector<double>(_codec.dimension()));
+                for (auto& x : xs)
+                    for (auto& v : x)
+                        v = unit(_rng);
+
+                auto targets = evaluate_and_record(xs);
+                for (std::size_t i = 0; i < xs.size(); ++i)
+                    _population.emplace_back(std::move(targets[i]), std::move(xs[i]));
+                detail::sort_population(_population, compare);
+            }
+
+            for (; max_generations != 0 && !reached_target && std::chrono::high_resolution_clock::now() - start_time < duration;
+                --max_generations, ++s.generation_count)
+            {
+                _strategy.generation(_population, evaluate_and_record, compare, _rng);
+            }
+
+            return std::tuple(s, _opt_map);
+        }
+    };
+
+    //------------------------------------------------------------------------------------------
+    // optimizer construction guides
+    template<class Strategy, class Fn, class ...Types>
+    population_optimization_t(Strategy, Fn, std::tuple<Types, Types> ...) -> population_optimization_t<Strategy, Fn, std::less<>, Types...>;
+}
@@ -32,7 +32,12 @@
 #include <functional>
 #include <algorithm>
 #include <numeric>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <limits>
 #include "../util/tuple_functions.h"
+#include "../container/matrix_functions.h"
 #include "genetic_optimization.h"
 
 namespace gb::yadro::algorithm
@@ -75,18 +80,164 @@ namespace gb::yadro::algorithm
         return residuals(fun, data, std::minus<>{});
     }
 
+    //----------------------------------------------------------------------------------------------
+    // structure of arrays copy of data range: Y values and a column for each argument
+    // the columns are contiguous, so the compiler can vectorize the residual kernels below
+    template<class Y, class ...X>
+    struct soa_data
+    {
+        std::vector<Y> y;
+        std::tuple<std::vector<X>...> x;
+
+        auto size() const { return y.size(); }
+    };
+
+    auto make_soa_data(const data_range auto& data)
+    {
+        using tuple_type = std::remove_cvref_t<decltype(*std::begin(data))>;
+        return [&]<std::size_t ...I>(std::index_sequence<I...>)
+        {
+            soa_data<std::remove_cvref_t<std::tuple_element_t<0, tuple_type>>, std::remove_cvref_t<std::tuple_element_t<I + 1, tuple_type>>...> result;
+            auto size = static_cast<std::size_t>(std::ranges::distance(data));
+            result.y.reserve(size);
+            (std::get<I>(result.x).reserve(size), ...);
+
+            for (auto&& d : data)
+            {
+                result.y.push_back(std::get<0>(d));
+                (std::get<I>(result.x).push_back(std::get<I + 1>(d)), ...);
+            }
+            return result;
+        }(std::make_index_sequence<std::tuple_size_v<tuple_type> - 1>{});
+    }
+
+    namespace detail
+    {
+        inline constexpr auto square_fn = [](auto r) { return r * r; };
+        inline constexpr auto abs_fn = [](auto r) { return std::abs(r); };
+
+        //------------------------------------------------------------------------------------------
+        // fused residual and reduction: sum of reduce_fn(y - fun(x...)) for the points [begin, end),
+        // four independent sums let the compiler vectorize the loop without reordering floating point additions
+        template<class Y, class ...X>
+        auto residual_reduce(auto&& fun, const soa_data<Y, X...>& data, auto&& reduce_fn, std::size_t begin, std::size_t end)
+        {
+            const auto* y = data.y.data();
+            auto x = std::apply([](auto& ...columns) { return std::tuple(columns.data()...); }, data.x);
+            auto value = [&](std::size_t i)
+                {
+                    return reduce_fn(y[i] - std::apply([&](auto* ...columns) { return std::invoke(fun, columns[i]...); }, x));
+                };
+
+            using sum_t = decltype(value(0));
+            sum_t sum0{}, sum1{}, sum2{}, sum3{};
+            auto i = begin;
+            for (; i + 4 <= end; i += 4)
+            {
+                sum0 += value(i);
+                sum1 += value(i + 1);
+                sum2 += value(i + 2);
+                sum3 += value(i + 3);
+            }
+            for (; i < end; ++i)
+                sum0 += value(i);
+
+            return (sum0 + sum1) + (sum2 + sum3);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // fused residual and reduction of data range, without copying the data
+        auto residual_reduce(auto&& fun, const data_range auto& data, auto&& reduce_fn)
+        {
+            using y_type = std::remove_cvref_t<decltype(std::get<0>(*std::begin(data)))>;
+            using sum_t = decltype(reduce_fn(std::declval<y_type>() - std::apply(fun, util::subtuple<1>(*std::begin(data)))));
+
+            sum_t sum{};
+            for (auto&& d : data)
+                sum += reduce_fn(std::get<0>(d) - std::apply([&](auto&& ...args) { return std::invoke(fun, args...); }, util::subtuple<1>(d)));
+            return sum;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // the chunks of soa data are reduced in the thread pool, small data is reduced in the calling thread
+        template<class Y, class ...X>
+        auto residual_reduce(auto&& fun, const soa_data<Y, X...>& data, auto&& reduce_fn, gb::yadro::async::threadpool<>& tp,
+            std::size_t min_chunk_size)
+        {
+            auto size = data.size();
+            auto chunk_count = std::min(tp.max_thread_count(), size / std::max<std::size_t>(min_chunk_size, 1));
+            if (chunk_count < 2)
+                return residual_reduce(fun, data, reduce_fn, 0, size);
+
+            using sum_t = decltype(residual_reduce(fun, data, reduce_fn, 0, 0));
+            std::vector<std::future<sum_t>> futures;
+            futures.reserve(chunk_count);
+            for (std::size_t chunk = 0; chunk < chunk_count; ++chunk)
+            {
+                futures.push_back(tp([&, begin = size * chunk / chunk_count, end = size * (chunk + 1) / chunk_count]
+                    {
+                        return residual_reduce(fun, data, reduce_fn, begin, end);
+                    }));
+            }
+
+            sum_t sum{};
+            for (auto&& f : futures)
+                sum += f.get();
+            return sum;
+        }
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // sums of squared and absolute residuals y - fun(x...) calculated in one pass without allocations
+    // data is a data range or soa_data, the threadpool overloads split large soa_data in chunks
+
+    inline auto residual_sum_of_squares(auto fun, const data_range auto& data)
+    {
+        return detail::residual_reduce(fun, data, detail::square_fn);
+    }
+
+    template<class Y, class ...X>
+    auto residual_sum_of_squares(auto fun, const soa_data<Y, X...>& data)
+    {
+        return detail::residual_reduce(fun, data, detail::square_fn, 0, data.size());
+    }
+
+    template<class Y, class ...X>
+    auto residual_sum_of_squares(auto fun, const soa_data<Y, X...>& data, gb::yadro::async::threadpool<>& tp,
+        std::size_t min_chunk_size = 16384)
+    {
+        return detail::residual_reduce(fun, data, detail::square_fn, tp, min_chunk_size);
+    }
+
+    inline auto residual_sum_of_abs(auto fun, const data_range auto& data)
+    {
+        return detail::residual_reduce(fun, data, detail::abs_fn);
+    }
+
+    template<class Y, class ...X>
+    auto residual_sum_of_abs(auto fun, const soa_data<Y, X...>& data)
+    {
+        return detail::residual_reduce(fun, data, detail::abs_fn, 0, data.size());
+    }
+
+    template<class Y, class ...X>
+    auto residual_sum_of_abs(auto fun, const soa_data<Y, X...>& data, gb::yadro::async::threadpool<>& tp,
+        std::size_t min_chunk_size = 16384)
+    {
+        return detail::residual_reduce(fun, data, detail::abs_fn, tp, min_chunk_size);
+    }
+
     //----------------------------------------------------------------------------------------------
     // least squares optimization
     // function fun(p...) -> function(p..., x...)
+    // the optimizer keeps soa_data copy of the data
     template<class ...ParameterTypes>
     auto least_squares_optimizer(auto fun, const data_range auto& data, std::tuple<ParameterTypes, ParameterTypes> ... min_max_parameters)
     {
-        genetic_optimization_t opt([=, &data](auto&& ...params)
+        genetic_optimization_t opt([=, soa = make_soa_data(data)](auto&& ...params)
             {
                 auto fn = std::invoke(fun, std::forward<decltype(params)>(params)...);
-                auto&& v = residuals(fn, data);
-                auto zero = static_cast<std::remove_reference_t<decltype(v[0])>>(0);
-                return std::reduce(std::begin(v), std::end(v), zero, [](auto&& v1, auto&& v2) { return v1 + v2 * v2; });
+                return residual_sum_of_squares(fn, soa);
             }, std::less<>{}, min_max_parameters ...);
 
         return opt;
@@ -95,17 +246,218 @@ namespace gb::yadro::algorithm
     //----------------------------------------------------------------------------------------------
     // least abs optimization
     // function fun(p...) -> function(p..., x...)
+    // the optimizer keeps soa_data copy of the data
     template<class ...ParameterTypes>
     auto least_abs_optimizer(auto fun, const data_range auto& data, std::tuple<ParameterTypes, ParameterTypes> ... min_max_parameters)
     {
-        genetic_optimization_t opt([=, &data](auto&& ...params)
+        genetic_optimization_t opt([=, soa = make_soa_data(data)](auto&& ...params)
             {
                 auto fn = std::invoke(fun, std::forward<decltype(params)>(params)...);
-                auto&& v = residuals(fn, data);
-                auto zero = static_cast<std::remove_reference_t<decltype(v[0])>>(0);
-                return std::reduce(std::begin(v), std::end(v), zero, [](auto&& v1, auto&& v2) { return v1 + std::abs(v2); });
+                return residual_sum_of_abs(fn, soa);
             }, std::less<>{}, min_max_parameters ...);
 
         return opt;
     }
+
+    //----------------------------------------------------------------------------------------------
+    // direct least squares solvers
+    // models linear in parameters are solved with normal equations (Cholesky decomposition) or QR decomposition,
+    // nonlinear models are fitted with Levenberg-Marquardt algorithm using numeric Jacobian
+    // the models are the same as in least_squares_optimizer: fun(p...) -> function(x...)
+    //----------------------------------------------------------------------------------------------
+
+    enum class least_squares_method { cholesky, qr };
+
+    //----------------------------------------------------------------------------------------------
+    // result of nonlinear least squares fit
+    template<std::size_t N>
+    struct least_squares_fit
+    {
+        std::array<double, N> parameters;
+        double sum_of_squares;
+        std::size_t iterations;
+        bool converged; // the sum of squares stopped decreasing before max_iterations
+    };
+
+    namespace detail
+    {
+        //------------------------------------------------------------------------------------------
+        // normal equations x^T * x * p = x^T * y for the design matrix x, the columns of x are contiguous
+        inline auto normal_equations_solve(const container::matrix<double>& x, const container::matrix<double>& y)
+        {
+            auto rows = x.rows(), columns = x.columns();
+            container::matrix<double> a(columns, columns), b(columns, 1);
+            auto y_data = y.data().data();
+            for (std::size_t j = 0; j < columns; ++j)
+            {
+                auto xj = x.data().data() + j * rows;
+                for (std::size_t k = 0; k <= j; ++k)
+                {
+                    auto xk = x.data().data() + k * rows;
+                    a(j, k) = a(k, j) = std::inner_product(xj, xj + rows, xk, 0.);
+                }
+                b(j, 0) = std::inner_product(xj, xj + rows, y_data, 0.);
+            }
+            return container::cholesky_solve(std::move(a), std::move(b));
+        }
+
+        //------------------------------------------------------------------------------------------
+        // column matrix of the parameters
+        inline auto linear_solve(container::matrix<double>&& x, container::matrix<double>&& y, least_squares_method method)
+        {
+            util::gbassert(x.rows() >= x.columns(), "least squares: fewer observations than parameters");
+            return method == least_squares_method::cholesky ? normal_equations_solve(x, y) : container::qr_solve(std::move(x), std::move(y));
+        }
+
+        //------------------------------------------------------------------------------------------
+        // model function for the parameters in array
+        template<std::size_t N>
+        auto model_function(auto&& fun, const std::array<double, N>& p)
+        {
+            return std::apply([&](auto ...params) { return std::invoke(fun, params...); }, p);
+        }
+
+        // value of the model function for the arguments of the data point
+        inline double model_value(auto&& fn, auto&& d)
+        {
+            return static_cast<double>(std::apply([&](auto&& ...args) { return std::invoke(fn, args...); }, util::subtuple<1>(d)));
+        }
+
+        //------------------------------------------------------------------------------------------
+        // residuals y - f(p)(x) of the data written into r
+        template<std::size_t N>
+        auto fill_residuals(auto&& fun, const data_range auto& data, const std::array<double, N>& p, std::vector<double>& r)
+        {
+            auto fn = model_function(fun, p);
+            auto sum_of_squares = 0.;
+            for (std::size_t i = 0; auto&& d : data)
+            {
+                r[i] = static_cast<double>(std::get<0>(d)) - model_value(fn, d);
+                sum_of_squares += r[i] * r[i];
+                ++i;
+            }
+            return sum_of_squares;
+        }
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // linear least squares for design matrix x (a row for each observation) and column matrix y,
+    // returns column matrix of parameters
+    inline auto linear_least_squares(const container::matrix<double>& x, const container::matrix<double>& y,
+        least_squares_method method = least_squares_method::qr)
+    {
+        util::gbassert(y.rows() == x.rows() && y.columns() == 1);
+        return detail::linear_solve(container::matrix<double>(x), container::matrix<double>(y), method);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // least squares for model fun(p...) -> function(x...) linear in N parameters, e.g. a + b * x + c * x * x
+    // the model may have a constant part not depending on the parameters
+    // the design matrix columns are the model values for unit parameters less the constant part
+    template<std::size_t N>
+    auto linear_least_squares(auto fun, const data_range auto& data, least_squares_method method = least_squares_method::qr)
+    {
+        auto rows = static_cast<std::size_t>(std::ranges::distance(data));
+        container::matrix<double> x(rows, N), y(rows, 1);
+
+        auto zero_fn = detail::model_function(fun, std::array<double, N>{});
+        for (std::size_t i = 0; auto&& d : data)
+        {
+            y(i, 0) = static_cast<double>(std::get<0>(d)) - detail::model_value(zero_fn, d);
+            ++i;
+        }
+
+        for (std::size_t j = 0; j < N; ++j)
+        {
+            std::array<double, N> unit{};
+            unit[j] = 1;
+            auto unit_fn = detail::model_function(fun, unit);
+            for (std::size_t i = 0; auto&& d : data)
+            {
+                x(i, j) = detail::model_value(unit_fn, d) - detail::model_value(zero_fn, d);
+                ++i;
+            }
+        }
+
+        auto p = detail::linear_solve(std::move(x), std::move(y), method);
+        std::array<double, N> result{};
+        std::ranges::copy(p.data(), result.begin());
+        return result;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // Levenberg-Marquardt fit of model fun(p...) -> function(x...) with N parameters starting from initial
+    // Jacobian is calculated with forward differences, stops when the relative decrease of the sum of squares
+    // is below tolerance or after max_iterations
+    template<std::size_t N>
+    auto levenberg_marquardt(auto fun, const data_range auto& data, std::array<double, N> initial,
+        std::size_t max_iterations = 100, double tolerance = 1e-12)
+    {
+        auto rows = static_cast<std::size_t>(std::ranges::distance(data));
+        util::gbassert(rows >= N, "least squares: fewer observations than parameters");
+
+        least_squares_fit<N> fit{ initial, 0., 0, false };
+        std::vector<double> r(rows), r_step(rows);
+        container::matrix<double> jacobian(rows, N), a(N, N), b(N, 1);
+
+        fit.sum_of_squares = detail::fill_residuals(fun, data, fit.parameters, r);
+        auto lambda = 1e-3;
+        const auto h_scale = std::sqrt(std::numeric_limits<double>::epsilon());
+
+        for (; fit.iterations < max_iterations && !fit.converged; ++fit.iterations)
+        {
+            // Jacobian of the residuals
+            for (std::size_t j = 0; j < N; ++j)
+            {
+                auto p = fit.parameters;
+                auto h = h_scale * std::max(std::abs(p[j]), 1.);
+                p[j] += h;
+                detail::fill_residuals(fun, data, p, r_step);
+                for (std::size_t i = 0; i < rows; ++i)
+                    jacobian(i, j) = (r_step[i] - r[i]) / h;
+            }
+
+            // J^T * J and -J^T * r, the columns of the jacobian are contiguous
+            for (std::size_t j = 0; j < N; ++j)
+            {
+                auto jj = jacobian.data().data() + j * rows;
+                for (std::size_t k = 0; k <= j; ++k)
+                    a(j, k) = a(k, j) = std::inner_product(jj, jj + rows, jacobian.data().data() + k * rows, 0.);
+                b(j, 0) = -std::inner_product(jj, jj + rows, r.data(), 0.);
+            }
+
+            // increase damping until the step decreases the sum of squares
+            for (;;)
+            {
+                auto damped = a;
+                for (std::size_t j = 0; j < N; ++j)
+                    damped(j, j) += lambda * std::max(a(j, j), 1e-12);
+                auto delta = container::cholesky_solve(std::move(damped), b);
+
+                auto p = fit.parameters;
+                for (std::size_t j = 0; j < N; ++j)
+                    p[j] += delta(j, 0);
+
+                auto sum_of_squares = detail::fill_residuals(fun, data, p, r_step);
+                if (sum_of_squares < fit.sum_of_squares)
+                {
+                    fit.converged = fit.sum_of_squares - sum_of_squares <= tolerance * fit.sum_of_squares;
+                    fit.parameters = p;
+                    fit.sum_of_squares = sum_of_squares;
+                    r.swap(r_step);
+                    lambda = std::max(lambda / 10, 1e-12);
+                    break;
+                }
+
+                lambda *= 10;
+                if (lambda > 1e12)
+                {   // no step decreases the sum of squares, it's a minimum within the precision
+                    fit.converged = true;
+                    break;
+                }
+            }
+        }
+
+        return fit;
+    }
 }
@@ -49,8 +49,14 @@
 #include <span>
 #include <ranges>
 #include <expected>
+#include <algorithm>
+#include <stdexcept>
+#include <charconv>
+#include <memory>
+#include <typeindex>
 
 #include "../util/string_util.h"
+#include "../util/hash_util.h"
 #include "archive_traits.h"
 
 namespace gb::yadro::archive
@@ -66,16 +72,253 @@ namespace gb::yadro::archive
     }
     
     //---------------------------------------------------------------------
-    enum class archive_format_t { binary, text, custom };
+    // binary: raw data written in stream buffer
+    // text: formatted data, one value per line, elements of arrays are separated by spaces,
+    //  characters are written as is, numbers with to_chars in the shortest round-trip form
+    // custom: raw data written with stream read/write functions
+    // compact: like custom, but integers are LEB128 varints, signed integers are zigzag encoded
+    enum class archive_format_t { binary, text, custom, compact };
+
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        // compact encoding of integers
+        struct invalid_varint : std::runtime_error
+        {
+            invalid_varint() : std::runtime_error("invalid varint") {}
+        };
+
+        // single byte types are written as is
+        template<class T>
+        constexpr bool is_varint_v = (std::is_integral_v<T> || std::is_enum_v<T>) && sizeof(T) > 1;
+
+        template<class T>
+        struct varint_type { using type = std::make_unsigned_t<T>; };
+
+        template<class T> requires(std::is_enum_v<T>)
+        struct varint_type<T> { using type = std::make_unsigned_t<std::underlying_type_t<T>>; };
+
+        template<class T>
+        using varint_t = typename varint_type<T>::type;
+
+        template<class T>
+        constexpr auto zigzag_encode(T t)
+        {
+            using U = varint_t<T>;
+            if constexpr (std::is_enum_v<T>)
+                return zigzag_encode(static_cast<std::underlying_type_t<T>>(t));
+            else if constexpr (std::is_signed_v<T>)
+                return static_cast<U>((static_cast<U>(t) << 1) ^ static_cast<U>(t >> (sizeof(T) * 8 - 1)));
+            else
+                return static_cast<U>(t);
+        }
+
+        template<class T>
+        constexpr auto zigzag_decode(varint_t<T> u)
+        {
+            if constexpr (std::is_enum_v<T>)
+                return static_cast<T>(zigzag_decode<std::underlying_type_t<T>>(u));
+            else if constexpr (std::is_signed_v<T>)
+                return static_cast<T>((u >> 1) ^ (~(u & 1) + 1));
+            else
+                return static_cast<T>(u);
+        }
+
+        // max encoded size of T
+        template<class T>
+        constexpr std::size_t max_varint_size = (sizeof(T) * 8 + 6) / 7;
+
+        // encode t into buffer, returns the number of bytes written
+        template<class T, class C>
+        constexpr std::size_t encode_varint(T t, C* buf)
+        {
+            auto u = zigzag_encode(t);
+            std::size_t n = 0;
+            for (; u >= 0x80; u >>= 7)
+                buf[n++] = static_cast<C>(static_cast<std::uint8_t>(u) | 0x80);
+            buf[n++] = static_cast<C>(static_cast<std::uint8_t>(u));
+            return n;
+        }
+
+        // decode varint reading one byte at a time from stream
+        template<class T, class Stream>
+        T decode_varint(Stream& s)
+        {
+            using U = varint_t<T>;
+            U u{};
+            for (unsigned shift = 0; ; shift += 7)
+            {
+                typename Stream::char_type c{};
+                s.read(&c, 1);
+                auto b = static_cast<std::uint8_t>(c);
+                if (shift >= sizeof(U) * 8)
+                    throw invalid_varint();
+                u |= static_cast<U>(static_cast<U>(b & 0x7f) << shift);
+                if (!(b & 0x80))
+                    break;
+            }
+            return zigzag_decode<T>(u);
+        }
+
+        //---------------------------------------------------------------------
+        // text encoding with to_chars/from_chars, locale independent and round-trip exact
+        struct invalid_text : std::runtime_error
+        {
+            invalid_text() : std::runtime_error("invalid text archive value") {}
+        };
+
+        // character types are written as is, so strings keep their spaces and any bytes
+        template<class T>
+        constexpr bool is_text_char_v = std::is_same_v<T, char> || std::is_same_v<T, signed char>
+            || std::is_same_v<T, unsigned char> || std::is_same_v<T, char8_t>;
+
+        template<class T>
+        constexpr bool is_text_number_v = (std::is_arithmetic_v<T> || std::is_enum_v<T>) && !is_text_char_v<T>;
+
+        // the type used for to_chars/from_chars conversion
+        template<class T>
+        struct text_number_type { using type = T; };
+
+        template<class T> requires(std::is_enum_v<T>)
+        struct text_number_type<T> : text_number_type<std::underlying_type_t<T>> {};
+
+        template<class T> requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+        struct text_number_type<T>
+        {   // wchar_t, char16_t, char32_t are converted as integers of the same size
+            using type = std::conditional_t<std::is_signed_v<T>, std::make_signed_t<T>, std::make_unsigned_t<T>>;
+        };
+
+        template<class T> requires(std::is_same_v<T, bool>)
+        struct text_number_type<T> { using type = unsigned; };
+
+        // max length of a number in text form
+        inline constexpr std::size_t text_number_size = 128;
+
+        inline bool is_text_space(int c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+
+        // write count elements separated by spaces and terminated by new line, numbers are formatted
+        // into a local buffer, which is written to the stream buffer in large blocks
+        template<class T>
+        void text_write(auto& sbuf, const T* t, std::size_t count)
+        {
+            if constexpr (is_text_char_v<T>)
+                sbuf.sputn(reinterpret_cast<const char*>(t), static_cast<std::streamsize>(count));
+            else
+            {
+                using number_t = typename text_number_type<T>::type;
+                std::array<char, 4096> buf;
+                std::size_t size = 0;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    if (buf.size() - size <= text_number_size)
+                    {
+                        sbuf.sputn(buf.data(), static_cast<std::streamsize>(size));
+                        size = 0;
+                    }
+                    auto [ptr, ec] = std::to_chars(buf.data() + size, buf.data() + buf.size(), static_cast<number_t>(t[i]));
+                    size = static_cast<std::size_t>(ptr - buf.data());
+                    if (i + 1 < count)
+                        buf[size++] = ' ';
+                }
+                sbuf.sputn(buf.data(), static_cast<std::streamsize>(size));
+            }
+            sbuf.sputc('\n');
+        }
+
+        // read count elements written by text_write, characters are read as is,
+        // numbers are read as whitespace separated tokens
+        template<class T>
+        void text_read(auto& sbuf, T* t, std::size_t count)
+        {
+            using traits = std::char_traits<char>;
+            if constexpr (is_text_char_v<T>)
+            {
+                if (sbuf.sgetn(reinterpret_cast<char*>(t), static_cast<std::streamsize>(count)) != static_cast<std::streamsize>(count))
+                    throw invalid_text();
+            }
+            else
+            {
+                using number_t = typename text_number_type<T>::type;
+                char buf[text_number_size];
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    auto c = sbuf.sgetc();
+                    while (c != traits::eof() && is_text_space(c))
+                        c = sbuf.snextc();
+
+                    std::size_t size = 0;
+                    for (; c != traits::eof() && !is_text_space(c); c = sbuf.snextc())
+                    {
+                        if (size == text_number_size)
+                            throw invalid_text();
+                        buf[size++] = traits::to_char_type(c);
+                    }
+
+                    number_t value{};
+                    auto [ptr, ec] = std::from_chars(buf, buf + size, value);
+                    if (ec != std::errc{} || ptr != buf + size || size == 0)
+                        throw invalid_text();
+                    t[i] = static_cast<T>(value);
+
+                    if (i + 1 < count)
+                        sbuf.sbumpc();
+                }
+            }
+            // consume the line terminator, the last line may be not terminated
+            auto c = sbuf.sbumpc();
+            if (c != traits::eof() && !is_text_space(c))
+                throw invalid_text();
+        }
+    }
+
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        // objects referenced by shared pointers, every object is serialized once,
+        // the following pointers to the same object are serialized as its index
+        struct shared_objects
+        {
+            using key_type = std::pair<const void*, std::type_index>;
+            struct key_hash
+            {
+                std::size_t operator()(const key_type& key) const { return util::make_hash(key.first, key.second); }
+            };
+
+            // writing: object address and pointer type -> 1-based index
+            std::unordered_map<key_type, std::uint64_t, key_hash> ids;
+            // reading: index - 1 -> object and pointer type
+            std::vector<std::pair<std::shared_ptr<void>, std::type_index>> objects;
+        };
+
+        // created on first use, copied with the archive, so a copy continues from the same state
+        // independently of the original
+        struct shared_objects_ptr : std::unique_ptr<shared_objects>
+        {
+            shared_objects_ptr() = default;
+            shared_objects_ptr(shared_objects_ptr&&) = default;
+            shared_objects_ptr(const shared_objects_ptr& other)
+                : std::unique_ptr<shared_objects>(other ? std::make_unique<shared_objects>(*other) : nullptr) {}
+            shared_objects_ptr& operator=(shared_objects_ptr&&) = default;
+            shared_objects_ptr& operator=(const shared_objects_ptr& other)
+            {
+                if (this != &other)
+                    *this = shared_objects_ptr(other);
+                return *this;
+            }
+        };
+    }
+
     //---------------------------------------------------------------------
     // archive defined for in- and out-streams, but not for io-streams
     template<class Stream, archive_format_t fmt = archive_format_t::custom>
     class archive
     {
         Stream s;
+        detail::shared_objects_ptr _shared;
     public:
         using stream_type = std::remove_cvref_t<Stream>;
         using char_type = typename stream_type::char_type;
+        static constexpr archive_format_t format = fmt;
         static_assert(is_readable_v<stream_type> && !is_writable_v<stream_type>
             || !is_readable_v<stream_type> && is_writable_v<stream_type>,
             "stream must be readable or writable, but not both");
@@ -90,7 +333,24 @@ namespace gb::yadro::archive
         const auto& get_stream() const { return s; }
         
         //-----------------------------------
-        void reset(auto&&...args) { s.reset(std::forward<decltype(args)>(args)...); }
+        void reset(auto&&...args)
+        {
+            s.reset(std::forward<decltype(args)>(args)...);
+            _shared.reset();
+        }
+
+        //-----------------------------------
+        // shared pointers tracking, created on first use
+        auto& get_shared_objects()
+        {
+            if (!_shared)
+                _shared.reset(new detail::shared_objects);
+            return *_shared;
+        }
+
+        // shared pointers tracking state, swapped with a nested archive serializing a part of the same data,
+        // so the shared objects are identified across both archives
+        auto& shared_objects_state() { return _shared; }
 
         //-----------------------------------
         // read an array T
@@ -98,20 +358,33 @@ namespace gb::yadro::archive
         auto read(T& t, std::size_t count = 1)
         {
             static_assert(is_readable_v<stream_type>);
-            static_assert(std::is_trivial_v<T>);
+            static_assert(std::is_trivially_copyable_v<T>);
             if constexpr (fmt == archive_format_t::binary)
                 s.rdbuf()->sgetn(static_cast<char_type*>(static_cast<void*>(std::addressof(t))),
                     count * (sizeof(T) / sizeof(char_type)));
             else if constexpr (fmt == archive_format_t::text)
             {
-                for (size_t i = 0; i < count; ++i)
-                {   // TODO: spaces are skipped
+                if constexpr (std::is_same_v<char_type, char> && (detail::is_text_char_v<T> || detail::is_text_number_v<T>))
+                    detail::text_read(*s.rdbuf(), std::addressof(t), count);
+                else for (size_t i = 0; i < count; ++i)
+                {   // wide streams and other types are read with operator>>, spaces are skipped
                     s >> std::addressof(t)[i];
                 }
             }
             else if constexpr (fmt == archive_format_t::custom)
                 s.read(static_cast<char_type*>(static_cast<void*>(std::addressof(t))),
                     count * (sizeof(T) / sizeof(char_type)));
+            else if constexpr (fmt == archive_format_t::compact)
+            {
+                if constexpr (detail::is_varint_v<T>)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                        std::addressof(t)[i] = detail::decode_varint<T>(s);
+                }
+                else
+                    s.read(static_cast<char_type*>(static_cast<void*>(std::addressof(t))),
+                        count * (sizeof(T) / sizeof(char_type)));
+            }
         }
 
         //-----------------------------------
@@ -120,20 +393,43 @@ namespace gb::yadro::archive
         auto write(const T& t, std::size_t count = 1)
         {
             static_assert(is_writable_v<stream_type>);
-            static_assert(std::is_trivial_v<T>);
+            static_assert(std::is_trivially_copyable_v<T>);
 
             if constexpr (fmt == archive_format_t::binary)
                 s.rdbuf()->sputn(static_cast<const char_type*>(static_cast<const void*>(std::addressof(t))),
                     count * (sizeof(T) / sizeof(char_type)));
             else if constexpr (fmt == archive_format_t::text)
             {
-                for (size_t i = 0; i < count; ++i)
-                    s << std::addressof(t)[i];
-                s << '\n';
+                if constexpr (std::is_same_v<char_type, char> && (detail::is_text_char_v<T> || detail::is_text_number_v<T>))
+                    detail::text_write(*s.rdbuf(), std::addressof(t), count);
+                else
+                {
+                    for (size_t i = 0; i < count; ++i)
+                        s << std::addressof(t)[i];
+                    s << '\n';
+                }
             }
             else if constexpr (fmt == archive_format_t::custom)
                 s.write(static_cast<const char_type*>(static_cast<const void*>(std::addressof(t))),
                     count * (sizeof(T) / sizeof(char_type)));
+            else if constexpr (fmt == archive_format_t::compact)
+            {
+                if constexpr (detail::is_varint_v<T>)
+                {   // encode in batches to reduce the number of stream writes
+                    constexpr std::size_t batch = 64;
+                    char_type buf[batch * detail::max_varint_size<T>];
+                    for (size_t i = 0; i < count; i += batch)
+                    {
+                        std::size_t n = 0;
+                        for (size_t j = i; j < std::min(count, i + batch); ++j)
+                            n += detail::encode_varint(std::addressof(t)[j], buf + n);
+                        s.write(buf, static_cast<std::streamsize>(n));
+                    }
+                }
+                else
+                    s.write(static_cast<const char_type*>(static_cast<const void*>(std::addressof(t))),
+                        count * (sizeof(T) / sizeof(char_type)));
+            }
         }
 
         //-----------------------------------
@@ -153,7 +449,7 @@ namespace gb::yadro::archive
                     t.serialize(*this);
                 else if constexpr (is_free_serializable_v<archive, pure_type>)
                     serialize(*this, t);
-                else if constexpr (std::is_trivial_v<pure_type>)
+                else if constexpr (is_bitwise_v<archive, pure_type>)
                     read(t);
             }
             else
@@ -172,7 +468,7 @@ namespace gb::yadro::archive
                     const_cast<pure_type&>(t).serialize(*this); // symmetric non-const serialization only
                 else if constexpr (is_free_serializable_v<archive, pure_type>)
                     serialize(*this, const_cast<pure_type&>(t));
-                else if constexpr (std::is_trivial_v<pure_type>)
+                else if constexpr (is_bitwise_v<archive, pure_type>)
                     write(t);
             }
         }
@@ -206,35 +502,74 @@ namespace gb::yadro::archive
     };
 
     // calculate the size (in bytes) of buffer necessary to serialize binary data
+    // binary and custom formats have the same size, compact format size is calculated with compact encoding
+    template<archive_format_t fmt = archive_format_t::custom>
     inline auto serialization_size(auto&&... args)
     {
-        archive< archive_size_stream, archive_format_t::custom> ar;
+        static_assert(fmt != archive_format_t::text, "size of text archive isn't calculated");
+        archive< archive_size_stream, fmt == archive_format_t::compact ? fmt : archive_format_t::custom> ar;
         ar(std::forward<decltype(args)>(args)...);
         return ar.get_stream().get_size();
     }
     
     //---------------------------------------------------------------------
-    // archive_size_stream is archive proxy class for size calculation
-    struct archive_md5_stream
+    // archive_hash_stream is archive proxy class for hash calculation,
+    // small writes of individual fields are collected in a buffer to call hash update less often
+    template<class Hash>
+    struct archive_hash_stream
     {
         using char_type = std::uint8_t;
 
         void write(const char_type* c, std::streamsize size)
         {
-            _md5.update(c, (std::size_t)size);
+            auto n = static_cast<std::size_t>(size);
+            if (n > _buf.size() - _buf_size)
+            {
+                flush();
+                if (n >= _buf.size())
+                {
+                    _hash.update(c, n);
+                    return;
+                }
+            }
+            std::copy_n(c, n, _buf.data() + _buf_size);
+            _buf_size += n;
         }
 
-        auto& get_md5() { return _md5; }
+        auto& get_hash()
+        {
+            flush();
+            return _hash;
+        }
     private:
-        util::md5 _md5;
+        Hash _hash;
+        std::array<char_type, 4096> _buf;
+        std::size_t _buf_size{};
+
+        void flush()
+        {
+            if (_buf_size)
+                _hash.update(_buf.data(), _buf_size);
+            _buf_size = 0;
+        }
     };
 
-    // calculate the size (in bytes) of buffer necessary to serialize binary data
+    using archive_md5_stream = archive_hash_stream<util::md5>;
+
+    // calculate md5 of serialized data
     inline auto serialization_md5(auto&&... args)
     {
         archive< archive_md5_stream, archive_format_t::custom> ar;
         ar(std::forward<decltype(args)>(args)...);
-        return ar.get_stream().get_md5().finalize().to_string();
+        return ar.get_stream().get_hash().finalize().to_string();
+    }
+
+    // calculate fast non-cryptographic 128-bit hash of serialized data
+    inline auto serialization_hash(auto&&... args)
+    {
+        archive< archive_hash_stream<util::hash128>, archive_format_t::custom> ar;
+        ar(std::forward<decltype(args)>(args)...);
+        return ar.get_stream().get_hash().finalize().to_string();
     }
 
     //---------------------------------------------------------------------
@@ -249,11 +584,35 @@ namespace gb::yadro::archive
 
         void reset() { _buf.resize(0); } // reset position to start writing from the beginning
 
+        // reserve space for additional size elements, avoiding reallocations in subsequent writes
+        void reserve(std::size_t size)
+        {
+            if constexpr (requires { _buf.reserve(size); })
+                _buf.reserve(_buf.size() + size);
+        }
+
         void write(const char_type* c, std::streamsize size)
         {
-            auto prev_size = _buf.size();
-            _buf.resize(static_cast<decltype(prev_size)>(prev_size + size));
-            std::copy_n(c, size, _buf.begin() + prev_size);
+            if constexpr (requires { _buf.insert(_buf.end(), c, c + size); })
+            {   // range insert grows geometrically and copies without value-initializing new elements
+                _buf.insert(_buf.end(), c, c + size);
+            }
+            else
+            {
+                auto prev_size = _buf.size();
+                _buf.resize(static_cast<decltype(prev_size)>(prev_size + size));
+                std::copy_n(c, size, _buf.begin() + prev_size);
+            }
+        }
+
+        const auto& get_buffer() const { return _buf; }
+
+        // position of the next write, the data written after it can be overwritten by patch
+        auto tellp() const { return _buf.size(); }
+        void patch(std::size_t pos, const char_type* c, std::streamsize size)
+        {
+            assert(pos + size <= _buf.size());
+            std::copy_n(c, size, std::next(_buf.begin(), pos));
         }
     private:
         container_t _buf;
@@ -268,14 +627,21 @@ namespace gb::yadro::archive
         using omem_t = omem_stream< container_t>;
         explicit imem_stream(omem_t&& om) : _buf(std::move(om._buf)) {}
         explicit imem_stream(const omem_t& om) : _buf(om._buf) {}
-        explicit imem_stream(archive<omem_t, archive_format_t::custom>&& oma) : imem_stream(std::move(oma.get_stream())) {}
-        explicit imem_stream(const archive<omem_t, archive_format_t::custom>& oma) : imem_stream(oma.get_stream()) {}
+        template<archive_format_t fmt>
+        explicit imem_stream(archive<omem_t, fmt>&& oma) : imem_stream(std::move(oma.get_stream())) {}
+        template<archive_format_t fmt>
+        explicit imem_stream(const archive<omem_t, fmt>& oma) : imem_stream(oma.get_stream()) {}
 
         void reset() { _read_pos = 0; } // reset position to start reading from the beginning
         void reset(omem_t&& om) { _buf = std::move(om._buf); reset(); }
         void reset(const omem_t& om) { _buf = om._buf; reset(); }
-        void reset(archive<omem_t, archive_format_t::custom>&& oma) { reset(std::move(oma.get_stream())); }
-        void reset(const archive<omem_t, archive_format_t::custom>& oma) { reset(oma.get_stream()); }
+        template<archive_format_t fmt>
+        void reset(archive<omem_t, fmt>&& oma) { reset(std::move(oma.get_stream())); }
+        template<archive_format_t fmt>
+        void reset(const archive<omem_t, fmt>& oma) { reset(oma.get_stream()); }
+
+        // position of the next read
+        auto tellg() const { return _read_pos; }
 
         void read(char_type* c, std::streamsize size)
         {
@@ -302,6 +668,49 @@ namespace gb::yadro::archive
     template<std::ranges::sized_range container_t = std::vector<char>>
     using omem_archive = archive<omem_stream<container_t>, archive_format_t::custom>;
 
+    template<std::ranges::sized_range container_t = std::vector<char>>
+    using icompact_archive = archive<imem_stream<container_t>, archive_format_t::compact>;
+
+    template<std::ranges::sized_range container_t = std::vector<char>>
+    using ocompact_archive = archive<omem_stream<container_t>, archive_format_t::compact>;
+
+    //---------------------------------------------------------------------
+    // serialize into a new memory archive, the buffer is reserved from the size pass
+    // so the serialization makes a single allocation and a single copy per field
+    template<std::ranges::sized_range container_t = std::vector<char>>
+    auto make_omem_archive(auto&&... args)
+    {
+        omem_archive<container_t> ma;
+        ma.get_stream().reserve(static_cast<std::size_t>(serialization_size(args...)));
+        ma(std::forward<decltype(args)>(args)...);
+        return ma;
+    }
+
+    //---------------------------------------------------------------------
+    // md5 of every object of the range, the same as serialization_md5 of each object,
+    // the objects are hashed together with multi-buffer md5
+    inline auto serialization_md5_many(std::ranges::input_range auto&& objects)
+    {
+        // objects are serialized back to back into one buffer
+        omem_archive<std::vector<std::uint8_t>> ma;
+        std::vector<std::size_t> ends;
+        for (auto&& object : objects)
+        {
+            ma(object);
+            ends.push_back(ma.get_stream().get_buffer().size());
+        }
+        auto& buf = ma.get_stream().get_buffer();
+        std::vector<std::span<const std::uint8_t>> messages;
+        for (std::size_t i = 0, first = 0; i < ends.size(); first = ends[i++])
+            messages.emplace_back(buf.data() + first, ends[i] - first);
+
+        std::vector<std::string> result;
+        result.reserve(messages.size());
+        for (auto&& digest : util::md5_many(messages))
+            result.push_back(util::to_hex(digest));
+        return result;
+    }
+
     //---------------------------------------------------------------------
     // serialize through conversion to type As
     template<class As, class T>
@@ -379,6 +788,18 @@ namespace gb::yadro::archive
         }
     }
 
+    namespace detail
+    {
+        // contiguous ranges of bitwise elements can be read/written as a single block of memory
+        // text archives are excluded, because they format every element separately,
+        // compact archives encode arrays of arithmetic types only, other types are serialized by fields
+        template<class Archive, class Range, class T>
+        constexpr bool is_bulk_serializable_v = std::ranges::contiguous_range<Range>
+            && std::remove_cvref_t<Archive>::format != archive_format_t::text
+            && (std::remove_cvref_t<Archive>::format != archive_format_t::compact || std::is_arithmetic_v<T>)
+            && is_bitwise_v<Archive, T>;
+    }
+
     //---------------------------------------------------------------------
     // serialization of sequences of non-trivial types
     template<class Archive, class T>
@@ -403,7 +824,20 @@ namespace gb::yadro::archive
                 a(serialize_as<std::uint64_t>(std::size(t)));
             }
         }
-        for (auto&& v : t)
+
+        using value_type = std::remove_cvref_t<std::ranges::range_value_t<T>>;
+
+        if constexpr (detail::is_bulk_serializable_v<Archive, T, value_type>)
+        {   // contiguous sequence of bitwise elements is serialized with a single read/write
+            if (std::size(t))
+            {
+                if constexpr (is_iarchive_v<Archive>)
+                    a.read(*std::begin(t), std::size(t));
+                else
+                    a.write(*std::begin(t), std::size(t));
+            }
+        }
+        else for (auto&& v : t)
         {
             a(v);
         }
@@ -668,7 +1102,12 @@ namespace gb::yadro::archive
     auto serialize(Archive&& a, std::array<T, N>& t) requires(is_iarchive_v<Archive>)
     {
         static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
-        for (std::size_t i = 0; i < N; ++i)
+        if constexpr (detail::is_bulk_serializable_v<Archive, std::array<T, N>, T>)
+        {
+            if constexpr (N != 0)
+                a.read(t[0], N);
+        }
+        else for (std::size_t i = 0; i < N; ++i)
             a(t[i]);
     }
     //---------------------------------------------------------------------
@@ -677,7 +1116,12 @@ namespace gb::yadro::archive
     auto serialize(Archive&& a, const std::array<T, N>& t) requires(is_oarchive_v<Archive>)
     {
         static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
-        for (std::size_t i = 0; i < N; ++i)
+        if constexpr (detail::is_bulk_serializable_v<Archive, std::array<T, N>, T>)
+        {
+            if constexpr (N != 0)
+                a.write(t[0], N);
+        }
+        else for (std::size_t i = 0; i < N; ++i)
             a(t[i]);
     }
     //---------------------------------------------------------------------
@@ -686,7 +1130,12 @@ namespace gb::yadro::archive
     auto serialize(Archive&& a, std::span<T, Extent>& s) requires(is_iarchive_v<Archive>)
     {
         static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
-        for (auto it = s.begin(); it != s.end(); ++it)
+        if constexpr (detail::is_bulk_serializable_v<Archive, std::span<T, Extent>, T>)
+        {
+            if (!s.empty())
+                a.read(s.front(), s.size());
+        }
+        else for (auto it = s.begin(); it != s.end(); ++it)
             a(*it);
     }
     //---------------------------------------------------------------------
@@ -695,7 +1144,12 @@ namespace gb::yadro::archive
     auto serialize(Archive&& a, const std::span<T, Extent>& s) requires(is_oarchive_v<Archive>)
     {
         static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
-        for (auto it = s.begin(); it != s.end(); ++it)
+        if constexpr (detail::is_bulk_serializable_v<Archive, std::span<T, Extent>, std::remove_const_t<T>>)
+        {
+            if (!s.empty())
+                a.write(s.front(), s.size());
+        }
+        else for (auto it = s.begin(); it != s.end(); ++it)
             a(*it);
     }
     //---------------------------------------------------------------------
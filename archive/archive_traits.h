@@ -34,6 +34,7 @@
 #include <array>
 #include <valarray>
 #include <variant>
+#include <utility>
 
 #include "../util/traits.h"
 
@@ -115,9 +116,120 @@ namespace gb::yadro::archive
         || is_detected_v<detail::serialize_fn, A, std::add_lvalue_reference_t<T>> // A&&, T&
         || is_detected_v<detail::serialize_fn, std::add_lvalue_reference_t<A>, std::add_lvalue_reference_t<T>>; // A&, T&
 
-    // serializable types are: trivial or have member serialilize or free serialize functions
+    namespace detail
+    {
+        // initializes any non-aggregate element of an aggregate, nested aggregates and arrays are brace elided
+        struct any_element_t
+        {
+            template<class T> requires(!std::is_aggregate_v<T>)
+            operator T& () const;
+        };
+
+        template<std::size_t>
+        using any_element = any_element_t;
+
+        // initializes pointer elements only
+        struct pointer_element_t
+        {
+            template<class T> requires(std::is_pointer_v<T> || std::is_member_pointer_v<T> || std::is_null_pointer_v<T>)
+            operator T () const;
+        };
+
+        // T can be initialized by N elements, the last one is Last
+        template<class T, class Last, std::size_t N>
+        constexpr bool is_initializable_v = []<std::size_t... I>(std::index_sequence<I...>) {
+            return requires { T{ any_element<I>{}..., Last{} }; };
+        }(std::make_index_sequence<N - 1>{});
+
+        // larger aggregates aren't inspected and are treated as unsafe
+        constexpr std::size_t max_inspected_elements = 64;
+
+        template<class T, std::size_t N = 0>
+        constexpr bool is_pointer_free_aggregate()
+        {
+            if constexpr (N >= max_inspected_elements)
+                return false;
+            else if constexpr (!is_initializable_v<T, any_element_t, N + 1>)
+                return true;
+            else if constexpr (is_initializable_v<T, pointer_element_t, N + 1>)
+                return false;
+            else
+                return is_pointer_free_aggregate<T, N + 1>();
+        }
+
+        // initializes elements of type U only
+        template<class U>
+        struct exact_element_t
+        {
+            template<class T> requires std::is_same_v<T, U>
+            operator T () const;
+        };
+
+        // size of the element N - 1 of T if it is one of the listed types, 0 otherwise
+        template<class T, std::size_t N, class... U>
+        constexpr std::size_t listed_element_size_v = ((is_initializable_v<T, exact_element_t<U>, N> ? sizeof(U) : 0) + ...);
+
+        // arithmetic types without padding bits, long double is not listed
+        template<class T, std::size_t N>
+        constexpr std::size_t arithmetic_element_size_v = listed_element_size_v<T, N, bool, char, signed char, unsigned char,
+            wchar_t, char8_t, char16_t, char32_t, short, unsigned short, int, unsigned, long, unsigned long, long long,
+            unsigned long long, float, double>;
+
+        // total size of the aggregate elements, 0 if some of them aren't arithmetic
+        template<class T, std::size_t N = 0>
+        constexpr std::size_t arithmetic_elements_size(std::size_t size = 0)
+        {
+            if constexpr (N >= max_inspected_elements)
+                return 0;
+            else if constexpr (!is_initializable_v<T, any_element_t, N + 1>)
+                return size;
+            else if constexpr (arithmetic_element_size_v<T, N + 1> == 0)
+                return 0;
+            else
+                return arithmetic_elements_size<T, N + 1>(size + arithmetic_element_size_v<T, N + 1>);
+        }
+
+        // arithmetic types, enums and trivially copyable aggregates of them without padding,
+        // the layout of other classes is unknown
+        // floating point values don't have unique representations, so aggregates holding them
+        // are checked for padding by adding up the element sizes
+        template<class T>
+        constexpr bool is_packed_pointer_free()
+        {
+            if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+                return true;
+            else if constexpr (std::is_class_v<T> && std::is_aggregate_v<T> && std::is_trivially_copyable_v<T>
+                && std::is_default_constructible_v<T>)
+            {
+                if constexpr (!is_pointer_free_aggregate<T>())
+                    return false;
+                else
+                    return std::has_unique_object_representations_v<T> || arithmetic_elements_size<T>() == sizeof(T);
+            }
+            else
+                return false;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------------
+    // bitwise serializable types are written and read as raw memory, contiguous sequences of them
+    // are serialized with a single write/read
+    // by default these are arithmetic types, enums and trivially copyable aggregates of them without padding and pointers
+    // other types (views, spans, classes with private members) must opt in by specializing is_bitwise_serializable,
+    // the opt-in type must be trivially copyable and its memory layout must be the same as its field by field
+    // serialization (no padding, no pointers)
+    template<class T>
+    struct is_bitwise_serializable : std::bool_constant<detail::is_packed_pointer_free<T>()> {};
+
+    template<class T>
+    constexpr bool is_bitwise_serializable_v = is_bitwise_serializable<std::remove_cvref_t<T>>::value;
+
+    template<class A, class T>
+    constexpr bool is_bitwise_v = is_bitwise_serializable_v<T>;
+
+    // serializable types are: bitwise or have member serialilize or free serialize functions
     template<class A, class T>
-    constexpr bool is_serializable_v = std::is_trivial_v<T> || is_mem_serializable_v<A, T> || is_free_serializable_v<A, T>;
+    constexpr bool is_serializable_v = is_bitwise_v<A, T> || is_mem_serializable_v<A, T> || is_free_serializable_v<A, T>;
 
     template<class S>
     constexpr bool is_readable_v = is_detected_v<detail::read_fn, S>;
@@ -155,19 +267,19 @@ namespace gb::yadro::archive
     constexpr bool is_fixed_array_v = is_fixed_array<T>::value;
 
     //-----------------------------------------------------------------------------------------
-    // contiguous sequences of trivial types can be serialized as a single write/read
+    // contiguous sequences of trivial types without pointers can be serialized as a single write/read
     //-----------------------------------------------------------------------------------------
     template<class T>
     struct is_trivial_sequence : std::false_type {};
 
     template<class T, class A>
-    struct is_trivial_sequence<std::vector<T, A>> : std::bool_constant<std::is_trivial_v<T>> {};
+    struct is_trivial_sequence<std::vector<T, A>> : std::bool_constant<std::is_trivial_v<T> && detail::is_packed_pointer_free<T>()> {};
 
     template<class T, class Traits, class A>
-    struct is_trivial_sequence <std::basic_string<T, Traits, A>> : std::bool_constant<std::is_trivial_v<T>> {};
+    struct is_trivial_sequence <std::basic_string<T, Traits, A>> : std::bool_constant<std::is_trivial_v<T> && detail::is_packed_pointer_free<T>()> {};
 
     template<class T>
-    struct is_trivial_sequence <std::valarray<T>> : std::bool_constant<std::is_trivial_v<T>> {};
+    struct is_trivial_sequence <std::valarray<T>> : std::bool_constant<std::is_trivial_v<T> && detail::is_packed_pointer_free<T>()> {};
 
     template<class T>
     constexpr bool is_trivial_sequence_v = is_trivial_sequence<std::remove_cvref_t<T>>::value;
@@ -0,0 +1,542 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2022, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+#include "archive.h"
+#include "../async/threadpool.h"
+
+//-----------------------------------------------------------------------------
+// compressed streams: block based LZ compression of archive data
+//  stream layout: header {magic, flags, block size}, blocks, end marker
+//  block layout: uncompressed size, stored size (high bit set if stored uncompressed),
+//  optional adler32 checksum of uncompressed data, stored data
+//  end marker is a block with zero sizes
+//  blocks are compressed and decompressed in parallel if threadpool is supplied
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::archive
+{
+    //---------------------------------------------------------------------
+    struct compression_error : std::runtime_error
+    {
+        compression_error(const std::string& msg) : std::runtime_error("compression error: " + msg) {}
+    };
+
+    //---------------------------------------------------------------------
+    struct compression_options
+    {
+        std::size_t block_size = 1 << 18;
+        bool checksum = true;
+        async::threadpool<>* pool = nullptr; // compress blocks in parallel if not null
+    };
+
+    namespace detail
+    {
+        inline constexpr std::uint32_t compressed_magic = 0x315a4c59; // "YLZ1"
+        inline constexpr std::uint32_t checksum_flag = 1;
+        inline constexpr std::uint32_t stored_raw_flag = 0x80000000;
+
+        //---------------------------------------------------------------------
+        inline std::uint32_t adler32(const std::uint8_t* data, std::size_t size)
+        {
+            constexpr std::uint32_t mod = 65521;
+            constexpr std::size_t nmax = 5552; // max bytes before sums overflow
+            std::uint32_t a = 1, b = 0;
+            while (size)
+            {
+                auto n = std::min(size, nmax);
+                size -= n;
+                for (; n; --n)
+                {
+                    a += *data++;
+                    b += a;
+                }
+                a %= mod;
+                b %= mod;
+            }
+            return (b << 16) | a;
+        }
+
+        //---------------------------------------------------------------------
+        // LZ codec, sequences of literals and matches in LZ4 block style:
+        //  token (literal length: 4 bits, match length - 4: 4 bits), literal length extension,
+        //  literals, 16-bit match offset, match length extension
+        //  the last sequence has literals only
+        inline constexpr std::size_t lz_min_match = 4;
+        inline constexpr std::size_t lz_max_offset = 65535;
+        inline constexpr unsigned lz_hash_bits = 14;
+
+        inline std::uint32_t lz_read32(const std::uint8_t* p)
+        {
+            std::uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline std::uint32_t lz_hash(std::uint32_t v) { return (v * 2654435761u) >> (32 - lz_hash_bits); }
+
+        inline std::uint8_t* lz_write_length(std::uint8_t* op, std::size_t len)
+        {
+            for (; len >= 255; len -= 255)
+                *op++ = 255;
+            *op++ = static_cast<std::uint8_t>(len);
+            return op;
+        }
+
+        // upper bound of the sequence size
+        inline std::size_t lz_sequence_size(std::size_t literals, std::size_t match)
+        {
+            return 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1;
+        }
+
+        // compress src into dst, returns compressed size or 0 if it doesn't fit in dst capacity
+        inline std::size_t lz_compress(const std::uint8_t* src, std::size_t size, std::uint8_t* dst, std::size_t capacity)
+        {
+            thread_local std::vector<std::uint32_t> table;
+            table.assign(std::size_t(1) << lz_hash_bits, 0);
+
+            auto op = dst;
+            auto op_end = dst + capacity;
+            std::size_t ip = 0, anchor = 0;
+
+            while (ip + lz_min_match <= size)
+            {
+                auto seq = lz_read32(src + ip);
+                auto h = lz_hash(seq);
+                std::size_t ref = table[h];
+                table[h] = static_cast<std::uint32_t>(ip);
+
+                if (ref >= ip || ip - ref > lz_max_offset || lz_read32(src + ref) != seq)
+                {   // skip faster through incompressible data
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+
+                auto len = lz_min_match;
+                while (ip + len < size && src[ref + len] == src[ip + len])
+                    ++len;
+
+                auto literals = ip - anchor;
+                auto match = len - lz_min_match;
+                if (lz_sequence_size(literals, match) > static_cast<std::size_t>(op_end - op))
+                    return 0;
+
+                auto token = op++;
+                *token = static_cast<std::uint8_t>((std::min<std::size_t>(literals, 15) << 4) | std::min<std::size_t>(match, 15));
+                if (literals >= 15)
+                    op = lz_write_length(op, literals - 15);
+                std::memcpy(op, src + anchor, literals);
+                op += literals;
+
+                auto offset = ip - ref;
+                *op++ = static_cast<std::uint8_t>(offset);
+                *op++ = static_cast<std::uint8_t>(offset >> 8);
+                if (match >= 15)
+                    op = lz_write_length(op, match - 15);
+
+                ip += len;
+                anchor = ip;
+            }
+
+            // last literals
+            auto literals = size - anchor;
+            if (lz_sequence_size(literals, 0) > static_cast<std::size_t>(op_end - op))
+                return 0;
+            *op++ = static_cast<std::uint8_t>(std::min<std::size_t>(literals, 15) << 4);
+            if (literals >= 15)
+                op = lz_write_length(op, literals - 15);
+            std::memcpy(op, src + anchor, literals);
+            op += literals;
+
+            return static_cast<std::size_t>(op - dst);
+        }
+
+        // decompress src into dst of known size, returns false if data is corrupt
+        inline bool lz_decompress(const std::uint8_t* src, std::size_t size, std::uint8_t* dst, std::size_t dst_size)
+        {
+            std::size_t ip = 0, op = 0;
+
+            auto read_length = [&](std::size_t& len)
+            {
+                std::uint8_t b;
+                do
+                {
+                    if (ip >= size)
+                        return false;
+                    b = src[ip++];
+                    len += b;
+                } while (b == 255);
+                return true;
+            };
+
+            while (ip < size)
+            {
+                auto token = src[ip++];
+
+                std::size_t literals = token >> 4;
+                if (literals == 15 && !read_length(literals))
+                    return false;
+                if (literals > size - ip || literals > dst_size - op)
+                    return false;
+                std::memcpy(dst + op, src + ip, literals);
+                ip += literals;
+                op += literals;
+
+                if (ip == size)
+                    break; // the last sequence
+
+                if (ip + 2 > size)
+                    return false;
+                std::size_t offset = src[ip] | (std::size_t(src[ip + 1]) << 8);
+                ip += 2;
+
+                std::size_t len = token & 15;
+                if (len == 15 && !read_length(len))
+                    return false;
+                len += lz_min_match;
+
+                if (offset == 0 || offset > op || len > dst_size - op)
+                    return false;
+
+                if (offset >= len)
+                    std::memcpy(dst + op, dst + op - offset, len);
+                else for (std::size_t i = 0; i < len; ++i) // overlapping match repeats the pattern
+                    dst[op + i] = dst[op - offset + i];
+                op += len;
+            }
+
+            return op == dst_size;
+        }
+
+        //---------------------------------------------------------------------
+        struct compressed_block
+        {
+            std::uint32_t size{};   // uncompressed size
+            bool raw{};             // stored uncompressed
+            std::optional<std::uint32_t> checksum;
+            std::vector<char> data;
+        };
+
+        // compress block into its stored representation with block header
+        inline std::vector<char> compress_block(const char* data, std::size_t size, bool checksum)
+        {
+            auto src = reinterpret_cast<const std::uint8_t*>(data);
+            std::size_t header_size = 2 * sizeof(std::uint32_t) + (checksum ? sizeof(std::uint32_t) : 0);
+
+            std::vector<char> result(header_size + size);
+            auto compressed = lz_compress(src, size, reinterpret_cast<std::uint8_t*>(result.data()) + header_size, size);
+            auto stored = static_cast<std::uint32_t>(compressed ? compressed : size);
+            if (!compressed)
+                std::memcpy(result.data() + header_size, data, size);
+            result.resize(header_size + stored);
+
+            std::uint32_t header[3] = { static_cast<std::uint32_t>(size), compressed ? stored : stored | stored_raw_flag };
+            if (checksum)
+                header[2] = adler32(src, size);
+            std::memcpy(result.data(), header, header_size);
+            return result;
+        }
+
+        inline std::vector<char> decompress_block(const compressed_block& block)
+        {
+            std::vector<char> result;
+            if (block.raw)
+                result = block.data;
+            else
+            {
+                result.resize(block.size);
+                if (!lz_decompress(reinterpret_cast<const std::uint8_t*>(block.data.data()), block.data.size(),
+                    reinterpret_cast<std::uint8_t*>(result.data()), result.size()))
+                    throw compression_error("corrupt block");
+            }
+
+            if (block.checksum && *block.checksum != adler32(reinterpret_cast<const std::uint8_t*>(result.data()), result.size()))
+                throw compression_error("checksum mismatch");
+            return result;
+        }
+
+        //---------------------------------------------------------------------
+        template<class Stream>
+        void write_bytes(Stream& s, const void* data, std::size_t size)
+        {
+            using char_type = typename std::remove_cvref_t<Stream>::char_type;
+            static_assert(sizeof(char_type) == 1);
+            s.write(static_cast<const char_type*>(data), static_cast<std::streamsize>(size));
+        }
+
+        template<class Stream>
+        void read_bytes(Stream& s, void* data, std::size_t size)
+        {
+            using char_type = typename std::remove_cvref_t<Stream>::char_type;
+            static_assert(sizeof(char_type) == 1);
+            s.read(static_cast<char_type*>(data), static_cast<std::streamsize>(size));
+            if constexpr (requires { s.gcount(); })
+            {
+                if (static_cast<std::size_t>(s.gcount()) != size)
+                    throw compression_error("unexpected end of stream");
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------
+    // compressing output stream, wraps any output stream (e.g. ostream or omem_stream)
+    // compressed data is complete after finish() or destruction
+    template<class Stream>
+    class ocompressed_stream
+    {
+        Stream _s;
+        compression_options _opt;
+        std::vector<char> _block;
+        std::deque<std::future<std::vector<char>>> _pending; // blocks compressed in threadpool
+        bool _finished{ false };
+
+    public:
+        using char_type = char;
+
+        explicit ocompressed_stream(compression_options opt = {}) requires(std::is_default_constructible_v<Stream>)
+            : _opt(opt)
+        {
+            init();
+        }
+
+        explicit ocompressed_stream(auto&& s, compression_options opt = {})
+            requires(!std::is_same_v<std::remove_cvref_t<decltype(s)>, compression_options>)
+        : _s(std::forward<decltype(s)>(s)), _opt(opt)
+        {
+            init();
+        }
+
+        ocompressed_stream(const ocompressed_stream&) = delete;
+
+        // call finish() explicitly to get the errors
+        ~ocompressed_stream()
+        {
+            try { finish(); }
+            catch (...) {}
+        }
+
+        void write(const char_type* c, std::streamsize size)
+        {
+            assert(!_finished);
+            while (size > 0)
+            {
+                auto n = std::min(static_cast<std::size_t>(size), _opt.block_size - _block.size());
+                _block.insert(_block.end(), c, c + n);
+                c += n;
+                size -= static_cast<std::streamsize>(n);
+                if (_block.size() == _opt.block_size)
+                    flush_block();
+            }
+        }
+
+        // compress the remaining data and write the end marker
+        void finish()
+        {
+            if (_finished)
+                return;
+            _finished = true;
+            if (!_block.empty())
+                flush_block();
+            drain(0);
+            std::uint32_t end[2]{};
+            detail::write_bytes(_s, end, sizeof(end));
+        }
+
+        auto& get_stream() { return _s; }
+        const auto& get_stream() const { return _s; }
+
+    private:
+        void init()
+        {
+            assert(_opt.block_size > 0 && _opt.block_size < detail::stored_raw_flag);
+            std::uint32_t header[3] = { detail::compressed_magic, _opt.checksum ? detail::checksum_flag : 0,
+                static_cast<std::uint32_t>(_opt.block_size) };
+            detail::write_bytes(_s, header, sizeof(header));
+            _block.reserve(_opt.block_size);
+        }
+
+        void flush_block()
+        {
+            if (_opt.pool)
+            {
+                _pending.push_back((*_opt.pool)([checksum = _opt.checksum](const std::vector<char>& block)
+                    {
+                        return detail::compress_block(block.data(), block.size(), checksum);
+                    }, std::move(_block)));
+                _block = {};
+                _block.reserve(_opt.block_size);
+                drain(2 * _opt.pool->max_thread_count()); // limit memory used by pending blocks
+            }
+            else
+            {
+                auto stored = detail::compress_block(_block.data(), _block.size(), _opt.checksum);
+                detail::write_bytes(_s, stored.data(), stored.size());
+                _block.clear();
+            }
+        }
+
+        // write compressed blocks in order until no more than max_pending blocks remain
+        void drain(std::size_t max_pending)
+        {
+            while (_pending.size() > max_pending)
+            {
+                auto stored = _pending.front().get();
+                _pending.pop_front();
+                detail::write_bytes(_s, stored.data(), stored.size());
+            }
+        }
+    };
+
+    //---------------------------------------------------------------------
+    // decompressing input stream, wraps any input stream (e.g. istream or imem_stream)
+    template<class Stream>
+    class icompressed_stream
+    {
+        Stream _s;
+        async::threadpool<>* _pool;
+        bool _checksum{};
+        std::size_t _block_size{}; // max uncompressed size of a block
+        std::vector<char> _block;
+        std::size_t _pos{};
+        bool _end{ false };
+        std::deque<std::future<std::vector<char>>> _pending; // blocks decompressed in threadpool
+
+    public:
+        using char_type = char;
+
+        explicit icompressed_stream(auto&& s, async::threadpool<>* pool = nullptr)
+            : _s(std::forward<decltype(s)>(s)), _pool(pool)
+        {
+            std::uint32_t header[3]{};
+            detail::read_bytes(_s, header, sizeof(header));
+            if (header[0] != detail::compressed_magic)
+                throw compression_error("invalid header");
+            _checksum = header[1] & detail::checksum_flag;
+            _block_size = header[2];
+            if (_block_size == 0 || _block_size >= detail::stored_raw_flag)
+                throw compression_error("invalid block size");
+        }
+
+        icompressed_stream(const icompressed_stream&) = delete;
+
+        void read(char_type* c, std::streamsize size)
+        {
+            while (size > 0)
+            {
+                if (_pos == _block.size())
+                    next_block();
+                auto n = std::min(static_cast<std::size_t>(size), _block.size() - _pos);
+                std::copy_n(_block.data() + _pos, n, c);
+                _pos += n;
+                c += n;
+                size -= static_cast<std::streamsize>(n);
+            }
+        }
+
+        auto& get_stream() { return _s; }
+        const auto& get_stream() const { return _s; }
+
+    private:
+        // read stored block, returns nullopt at the end marker
+        std::optional<detail::compressed_block> read_block()
+        {
+            if (_end)
+                return std::nullopt;
+
+            std::uint32_t header[2]{};
+            detail::read_bytes(_s, header, sizeof(header));
+            if (!header[0] && !header[1])
+            {
+                _end = true;
+                return std::nullopt;
+            }
+
+            // sizes are validated before allocation, the stored data is never larger than the uncompressed data
+            detail::compressed_block block;
+            block.size = header[0];
+            block.raw = header[1] & detail::stored_raw_flag;
+            auto stored = header[1] & ~detail::stored_raw_flag;
+            if (block.size > _block_size || stored > block.size || block.raw && stored != block.size)
+                throw compression_error("invalid block size");
+            if (_checksum)
+            {
+                std::uint32_t checksum{};
+                detail::read_bytes(_s, &checksum, sizeof(checksum));
+                block.checksum = checksum;
+            }
+            block.data.resize(stored);
+            detail::read_bytes(_s, block.data.data(), block.data.size());
+            return block;
+        }
+
+        void next_block()
+        {
+            if (_pool)
+            {   // read ahead and decompress in parallel
+                while (_pending.size() < 2 * _pool->max_thread_count())
+                {
+                    auto block = read_block();
+                    if (!block)
+                        break;
+                    _pending.push_back((*_pool)([](const detail::compressed_block& block)
+                        {
+                            return detail::decompress_block(block);
+                        }, std::move(*block)));
+                }
+                if (_pending.empty())
+                    throw compression_error("read past the end of stream");
+                _block = _pending.front().get();
+                _pending.pop_front();
+            }
+            else
+            {
+                auto block = read_block();
+                if (!block)
+                    throw compression_error("read past the end of stream");
+                _block = detail::decompress_block(*block);
+            }
+            _pos = 0;
+        }
+    };
+
+    template<class Stream>
+    using ocompressed_archive = archive<ocompressed_stream<Stream>, archive_format_t::custom>;
+
+    template<class Stream>
+    using icompressed_archive = archive<icompressed_stream<Stream>, archive_format_t::custom>;
+}
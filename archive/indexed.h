@@ -0,0 +1,410 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2022, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <span>
+#include <variant>
+#include <optional>
+#include <filesystem>
+#include <system_error>
+#include "archive.h"
+#include "versioned.h"
+#include "../util/gbwin.h"
+
+#ifndef GBWINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// indexed archive: random access to the objects of an archive
+//  layout: header {magic, format}, serialized objects, index footer
+//  footer: offsets of all objects and the end of data, object count, footer offset, magic
+//  the footer is at the fixed distance from the end, so the reader locates any object
+//  without reading the objects before it; combined with memory mapped files only the pages
+//  of the objects that are actually deserialized are loaded
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::archive
+{
+    inline constexpr std::uint32_t indexed_archive_magic = 0x58494459; // "YDIX"
+
+    //---------------------------------------------------------------------
+    // read-only memory mapped file
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        explicit mapped_file(const std::filesystem::path& path)
+        {
+#ifdef GBWINDOWS
+            _file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (_file == INVALID_HANDLE_VALUE)
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "cannot open " + path.string());
+            LARGE_INTEGER size{};
+            GetFileSizeEx(_file, &size);
+            _size = static_cast<std::size_t>(size.QuadPart);
+            if (_size)
+            {
+                _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (_mapping)
+                    _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+                if (!_data)
+                {
+                    auto error = static_cast<int>(GetLastError());
+                    close();
+                    throw std::system_error(error, std::system_category(), "cannot map " + path.string());
+                }
+            }
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::system_error(errno, std::system_category(), "cannot open " + path.string());
+            struct stat st{};
+            if (::fstat(fd, &st) == 0)
+                _size = static_cast<std::size_t>(st.st_size);
+            if (_size)
+            {
+                auto p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED)
+                {
+                    auto error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::system_category(), "cannot map " + path.string());
+                }
+                _data = static_cast<const char*>(p);
+            }
+            ::close(fd); // the mapping keeps the file open
+#endif
+        }
+
+        mapped_file(mapped_file&& other) noexcept { swap(other); }
+        mapped_file& operator= (mapped_file&& other) noexcept
+        {
+            mapped_file tmp(std::move(other));
+            swap(tmp);
+            return *this;
+        }
+        ~mapped_file() { close(); }
+
+        const char* data() const { return _data; }
+        std::size_t size() const { return _size; }
+        explicit operator bool() const { return _data; }
+
+        void swap(mapped_file& other) noexcept
+        {
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+#ifdef GBWINDOWS
+            std::swap(_file, other._file);
+            std::swap(_mapping, other._mapping);
+#endif
+        }
+
+    private:
+        const char* _data{};
+        std::size_t _size{};
+#ifdef GBWINDOWS
+        HANDLE _file{ INVALID_HANDLE_VALUE };
+        HANDLE _mapping{};
+
+        void close()
+        {
+            if (_data)
+                UnmapViewOfFile(_data);
+            if (_mapping)
+                CloseHandle(_mapping);
+            if (_file != INVALID_HANDLE_VALUE)
+                CloseHandle(_file);
+            _data = nullptr;
+            _mapping = nullptr;
+            _file = INVALID_HANDLE_VALUE;
+        }
+#else
+        void close()
+        {
+            if (_data)
+                ::munmap(const_cast<char*>(_data), _size);
+            _data = nullptr;
+        }
+#endif
+    };
+
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        // output stream proxy counting written bytes
+        template<class Stream>
+        struct counting_stream
+        {
+            using char_type = typename std::remove_cvref_t<Stream>::char_type;
+            explicit counting_stream(auto&& ... args) : s(std::forward<decltype(args)>(args)...) {}
+
+            void write(const char_type* c, std::streamsize size)
+            {
+                s.write(c, size);
+                _pos += static_cast<std::uint64_t>(size) * sizeof(char_type);
+            }
+
+            auto get_pos() const { return _pos; }
+            auto& get() { return s; }
+        private:
+            Stream s;
+            std::uint64_t _pos{};
+        };
+
+        //---------------------------------------------------------------------
+        // input stream over a non-owning range of bytes
+        struct ispan_stream
+        {
+            using char_type = char;
+            explicit ispan_stream(std::span<const char> data) : _data(data) {}
+
+            void read(char_type* c, std::streamsize size)
+            {
+                if (static_cast<std::size_t>(size) > _data.size() - _pos)
+                    throw invalid_archive("read past the end of object");
+                std::memcpy(c, _data.data() + _pos, static_cast<std::size_t>(size));
+                _pos += static_cast<std::size_t>(size);
+            }
+        private:
+            std::span<const char> _data;
+            std::size_t _pos{};
+        };
+
+        // footer fields are raw integers in all formats
+        template<class T>
+        T read_raw(std::span<const char> data, std::size_t pos)
+        {
+            T t{};
+            std::memcpy(&t, data.data() + pos, sizeof(T));
+            return t;
+        }
+    }
+
+    //---------------------------------------------------------------------
+    // writes objects and the index of their offsets,
+    // the index is written by finish() or destructor
+    template<class Stream, archive_format_t fmt = archive_format_t::custom>
+    class oindexed_archive
+    {
+        static_assert(fmt == archive_format_t::custom || fmt == archive_format_t::compact,
+            "indexed archive supports custom and compact formats");
+        archive<detail::counting_stream<Stream>, fmt> _ar;
+        std::vector<std::uint64_t> _offsets;
+        bool _finished{};
+
+        template<class T>
+        void write_raw(const T& t) { _ar.get_stream().write(reinterpret_cast<const char*>(&t), sizeof(T)); }
+
+    public:
+        explicit oindexed_archive(auto&& ... args) : _ar(std::forward<decltype(args)>(args)...)
+        {
+            write_raw(indexed_archive_magic);
+            write_raw(static_cast<std::uint32_t>(fmt));
+        }
+
+        ~oindexed_archive()
+        {
+            try { finish(); }
+            catch (...) {}
+        }
+
+        oindexed_archive(const oindexed_archive&) = delete;
+        oindexed_archive& operator= (const oindexed_archive&) = delete;
+
+        // serialize object, returns its index
+        template<class T>
+        std::size_t add(T&& t)
+        {
+            assert(!_finished);
+            _offsets.push_back(_ar.get_stream().get_pos());
+            _ar(std::forward<T>(t));
+            return _offsets.size() - 1;
+        }
+
+        // every argument is a separate object
+        template<class... Ts>
+        void operator()(Ts&&... ts)
+        {
+            (add(std::forward<Ts>(ts)), ...);
+        }
+
+        auto size() const { return _offsets.size(); }
+
+        // write the index, no objects can be added after that
+        void finish()
+        {
+            if (_finished)
+                return;
+            _finished = true;
+            auto index_pos = _ar.get_stream().get_pos();
+            for (auto offset : _offsets)
+                write_raw(offset);
+            write_raw(index_pos); // end of the last object
+            write_raw(static_cast<std::uint64_t>(_offsets.size()));
+            write_raw(index_pos);
+            write_raw(indexed_archive_magic);
+        }
+
+        auto& get_stream() { return _ar.get_stream().get(); }
+    };
+
+    //---------------------------------------------------------------------
+    template<class T>
+    class lazy;
+
+    // reads objects from indexed archive in any order,
+    // the data are either memory mapped file, owned buffer or non-owning span
+    class iindexed_archive
+    {
+        std::variant<std::monostate, std::vector<char>, mapped_file> _storage;
+        std::span<const char> _data;
+        archive_format_t _format{};
+        std::vector<std::uint64_t> _offsets; // object offsets and the end of the last object
+
+        static constexpr std::size_t header_size = 2 * sizeof(std::uint32_t);
+        static constexpr std::size_t footer_size = 2 * sizeof(std::uint64_t) + sizeof(std::uint32_t);
+
+        void read_index()
+        {
+            using detail::read_raw;
+            if (_data.size() < header_size + footer_size + sizeof(std::uint64_t)
+                || read_raw<std::uint32_t>(_data, 0) != indexed_archive_magic
+                || read_raw<std::uint32_t>(_data, _data.size() - sizeof(std::uint32_t)) != indexed_archive_magic)
+                throw invalid_archive("not an indexed archive");
+
+            _format = static_cast<archive_format_t>(read_raw<std::uint32_t>(_data, sizeof(std::uint32_t)));
+            if (_format != archive_format_t::custom && _format != archive_format_t::compact)
+                throw invalid_archive("unsupported indexed archive format");
+
+            auto footer = _data.size() - footer_size;
+            auto count = read_raw<std::uint64_t>(_data, footer);
+            auto index_pos = read_raw<std::uint64_t>(_data, footer + sizeof(std::uint64_t));
+            if (index_pos < header_size || index_pos > footer || (footer - index_pos) % sizeof(std::uint64_t) != 0
+                || count == std::numeric_limits<std::uint64_t>::max() || (footer - index_pos) / sizeof(std::uint64_t) != count + 1)
+                throw invalid_archive("corrupted index");
+
+            _offsets.resize(static_cast<std::size_t>(count + 1));
+            std::memcpy(_offsets.data(), _data.data() + index_pos, _offsets.size() * sizeof(std::uint64_t));
+            if (!std::ranges::is_sorted(_offsets) || _offsets.front() < header_size || _offsets.back() != index_pos)
+                throw invalid_archive("corrupted index");
+        }
+
+    public:
+        explicit iindexed_archive(std::span<const char> data) : _data(data) { read_index(); }
+        explicit iindexed_archive(std::vector<char> buf) : _storage(std::move(buf))
+        {
+            auto& v = std::get<std::vector<char>>(_storage);
+            _data = { v.data(), v.size() };
+            read_index();
+        }
+        explicit iindexed_archive(mapped_file file) : _storage(std::move(file))
+        {
+            auto& f = std::get<mapped_file>(_storage);
+            _data = { f.data(), f.size() };
+            read_index();
+        }
+
+        // memory map the file
+        static iindexed_archive open(const std::filesystem::path& path) { return iindexed_archive(mapped_file(path)); }
+
+        iindexed_archive(iindexed_archive&&) = default;
+        iindexed_archive& operator= (iindexed_archive&&) = default;
+
+        auto size() const { return _offsets.size() - 1; }
+        auto format() const { return _format; }
+
+        // serialized data of the object
+        std::span<const char> object_data(std::size_t i) const
+        {
+            assert(i < size());
+            return _data.subspan(static_cast<std::size_t>(_offsets[i]), static_cast<std::size_t>(_offsets[i + 1] - _offsets[i]));
+        }
+
+        template<class T>
+        void read(std::size_t i, T& t) const
+        {
+            detail::ispan_stream s(object_data(i));
+            if (_format == archive_format_t::compact)
+            {
+                archive<detail::ispan_stream&, archive_format_t::compact> ia(s);
+                ia(t);
+            }
+            else
+            {
+                archive<detail::ispan_stream&, archive_format_t::custom> ia(s);
+                ia(t);
+            }
+        }
+
+        template<class T>
+        T get(std::size_t i) const
+        {
+            T t{};
+            read(i, t);
+            return t;
+        }
+
+        // handle deserializing the object on the first access
+        template<class T>
+        lazy<T> get_lazy(std::size_t i) const { return lazy<T>(*this, i); }
+    };
+
+    //---------------------------------------------------------------------
+    // object of indexed archive deserialized on the first access,
+    // the archive must outlive the handle; not thread safe
+    template<class T>
+    class lazy
+    {
+        const iindexed_archive* _ar;
+        std::size_t _index;
+        mutable std::optional<T> _value;
+    public:
+        lazy(const iindexed_archive& ar, std::size_t index) : _ar(&ar), _index(index) {}
+
+        const T& get() const
+        {
+            if (!_value)
+                _value.emplace(_ar->get<T>(_index));
+            return *_value;
+        }
+        const T& operator*() const { return get(); }
+        const T* operator->() const { return &get(); }
+
+        bool is_loaded() const { return _value.has_value(); }
+        void unload() { _value.reset(); }
+    };
+}
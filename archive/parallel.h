@@ -0,0 +1,273 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2022, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <span>
+#include <future>
+#include <iterator>
+#include <exception>
+#include <algorithm>
+#include "archive.h"
+#include "versioned.h"
+#include "../async/threadpool.h"
+
+//-----------------------------------------------------------------------------
+// parallel serialization of large containers
+//  container is partitioned in chunks, each chunk is serialized in a separate memory archive
+//  on threadpool, deserialization of chunks is also done on threadpool
+//  layout: element count, chunk count, {element count, size in bytes} of every chunk, chunk data
+//  random access containers are read in place, other containers are read in temporary vectors
+//  and inserted in order
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::archive
+{
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        // type used to read container element, maps are read as pairs with non-const key
+        template<class T>
+        struct element_type { using type = typename T::value_type; };
+
+        template<class T> requires requires { typename T::mapped_type; }
+        struct element_type<T> { using type = std::pair<typename T::key_type, typename T::mapped_type>; };
+
+        // chunks use the same encoding as the parent archive
+        template<archive_format_t fmt>
+        constexpr auto chunk_format = fmt == archive_format_t::compact ? archive_format_t::compact : archive_format_t::custom;
+
+        //---------------------------------------------------------------------
+        // wait for all futures, even if some fail, since tasks reference local data
+        template<class T>
+        auto get_all(std::vector<std::future<T>>& futures)
+        {
+            using result_t = std::conditional_t<std::is_void_v<T>, char, T>;
+            std::vector<result_t> results;
+            results.reserve(futures.size());
+            std::exception_ptr error;
+            for (auto&& f : futures)
+            {
+                try
+                {
+                    if constexpr (std::is_void_v<T>)
+                        f.get();
+                    else
+                        results.push_back(f.get());
+                }
+                catch (...)
+                {
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+            if (error)
+                std::rethrow_exception(error);
+            if constexpr (!std::is_void_v<T>)
+                return results;
+        }
+    }
+
+    //---------------------------------------------------------------------
+    // wrapper for parallel serialization of container
+    template<class T>
+    class parallel_t
+    {
+        T t;
+        async::threadpool<>& _pool;
+        std::size_t _chunks;
+        using container_t = std::remove_cvref_t<T>;
+
+        auto chunk_count(std::size_t size) const
+        {
+            auto chunks = _chunks ? _chunks : 4 * std::max<std::size_t>(_pool.max_thread_count(), 1);
+            return std::max<std::size_t>(std::min(chunks, size), 1);
+        }
+
+    public:
+        // chunks: number of chunks, 0 to use 4 chunks per thread
+        parallel_t(T&& t, async::threadpool<>& pool, std::size_t chunks = 0)
+            : t(std::forward<T>(t)), _pool(pool), _chunks(chunks)
+        {}
+
+        template<class Ar>
+        auto serialize(Ar& a) const requires(is_oarchive_v<Ar>)
+        {
+            constexpr auto fmt = detail::chunk_format<std::remove_cvref_t<Ar>::format>;
+            static_assert(std::remove_cvref_t<Ar>::format != archive_format_t::text);
+
+            std::size_t size = std::size(t);
+            auto chunks = chunk_count(size);
+
+            // chunk boundaries
+            std::vector<decltype(std::begin(t))> bounds{ std::begin(t) };
+            std::vector<std::size_t> counts;
+            for (std::size_t i = 0; i < chunks; ++i)
+            {
+                counts.push_back(size * (i + 1) / chunks - size * i / chunks);
+                bounds.push_back(std::next(bounds.back(), counts.back()));
+            }
+
+            std::vector<std::future<omem_stream<std::vector<char>>>> futures;
+            for (std::size_t i = 0; i < chunks; ++i)
+            {
+                futures.push_back(_pool([&, i]
+                    {
+                        archive<omem_stream<std::vector<char>>, fmt> ca;
+                        if constexpr (std::ranges::contiguous_range<container_t>)
+                            ca(std::span(std::to_address(bounds[i]), counts[i]));
+                        else for (auto first = bounds[i]; first != bounds[i + 1]; ++first)
+                            ca(*first);
+                        return std::move(ca.get_stream());
+                    }));
+            }
+            auto streams = detail::get_all(futures);
+
+            a(serialize_as<std::uint64_t>(size), serialize_as<std::uint64_t>(chunks));
+            for (std::size_t i = 0; i < chunks; ++i)
+                a(serialize_as<std::uint64_t>(counts[i]), serialize_as<std::uint64_t>(streams[i].get_buffer().size()));
+            for (auto&& s : streams)
+            {
+                if (!s.get_buffer().empty())
+                    a.write(s.get_buffer()[0], s.get_buffer().size());
+            }
+        }
+
+        template<class Ar>
+        auto serialize(Ar& a) requires(is_iarchive_v<Ar>)
+        {
+            constexpr auto fmt = detail::chunk_format<std::remove_cvref_t<Ar>::format>;
+            static_assert(std::remove_cvref_t<Ar>::format != archive_format_t::text);
+            using chunk_archive = archive<imem_stream<std::vector<char>>, fmt>;
+
+            // the header is validated before anything is allocated from it, the writer always stores
+            // 1..max(size, 1) chunks whose counts add up to size, and every element takes at least a byte
+            std::size_t size{}, chunks{};
+            a(serialize_as<std::uint64_t>(size), serialize_as<std::uint64_t>(chunks));
+            if (chunks == 0 || chunks > std::max<std::size_t>(size, 1))
+                throw invalid_archive("invalid parallel chunk count");
+            if constexpr (std::ranges::random_access_range<container_t> && !is_resizable_v<container_t>)
+            {
+                if (std::size(t) != size)
+                    throw invalid_archive("parallel container size mismatch");
+            }
+
+            // counts and sizes are read one by one, so a truncated stream fails before a large allocation
+            std::vector<std::size_t> counts, bytes;
+            for (std::size_t i = 0, total = 0; i < chunks; ++i)
+            {
+                std::size_t count{}, byte_count{};
+                a(serialize_as<std::uint64_t>(count), serialize_as<std::uint64_t>(byte_count));
+                if (count > size - total || count > byte_count)
+                    throw invalid_archive("invalid parallel chunk");
+                total += count;
+                if (i + 1 == chunks && total != size)
+                    throw invalid_archive("invalid parallel chunk");
+                counts.push_back(count);
+                bytes.push_back(byte_count);
+            }
+
+            // chunk data are read in bounded blocks for the same reason
+            constexpr std::size_t max_block = std::size_t(1) << 20;
+            std::vector<std::vector<char>> buffers(chunks);
+            for (std::size_t i = 0; i < chunks; ++i)
+            {
+                for (std::size_t pos = 0; pos < bytes[i]; pos = buffers[i].size())
+                {
+                    buffers[i].resize(pos + std::min(bytes[i] - pos, max_block));
+                    a.read(buffers[i][pos], buffers[i].size() - pos);
+                }
+            }
+
+            // every chunk must be consumed exactly
+            auto check_consumed = [&](const chunk_archive& ca, std::size_t i)
+                {
+                    if (ca.get_stream().tellg() != bytes[i])
+                        throw invalid_archive("parallel chunk size mismatch");
+                };
+
+            if constexpr (std::ranges::random_access_range<container_t>)
+            {   // read in place
+                if constexpr (is_resizable_v<container_t>)
+                {
+                    t.clear();
+                    t.resize(size);
+                }
+                std::vector<std::future<void>> futures;
+                for (std::size_t i = 0, first = 0; i < chunks; first += counts[i++])
+                {
+                    futures.push_back(_pool([&, i, first]
+                        {
+                            chunk_archive ca(omem_stream<std::vector<char>>(std::move(buffers[i])));
+                            if constexpr (std::ranges::contiguous_range<container_t>)
+                                ca(std::span(std::ranges::data(t) + first, counts[i]));
+                            else for (std::size_t j = first; j < first + counts[i]; ++j)
+                                ca(t[j]);
+                            check_consumed(ca, i);
+                        }));
+                }
+                detail::get_all(futures);
+            }
+            else
+            {   // read chunks in temporary vectors and insert them in order
+                using element_t = typename detail::element_type<container_t>::type;
+                std::vector<std::future<std::vector<element_t>>> futures;
+                for (std::size_t i = 0; i < chunks; ++i)
+                {
+                    futures.push_back(_pool([&, i]
+                        {
+                            chunk_archive ca(omem_stream<std::vector<char>>(std::move(buffers[i])));
+                            std::vector<element_t> elements(counts[i]);
+                            ca(std::span(elements));
+                            check_consumed(ca, i);
+                            return elements;
+                        }));
+                }
+                auto chunk_elements = detail::get_all(futures);
+
+                t.clear();
+                if constexpr (requires { t.reserve(size); })
+                    t.reserve(size);
+                for (auto&& elements : chunk_elements)
+                    for (auto&& e : elements)
+                        t.insert(t.end(), std::move(e));
+            }
+        }
+    };
+
+    template<class T>
+    parallel_t(T&& t, async::threadpool<>&, std::size_t = 0)->parallel_t<T>;
+
+    template<class T>
+    auto parallel(T&& t, async::threadpool<>& pool, std::size_t chunks = 0)
+    {
+        return parallel_t<T>(std::forward<T>(t), pool, chunks);
+    }
+}
@@ -0,0 +1,248 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2022, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <stdexcept>
+#include <string>
+#include "archive.h"
+
+//-----------------------------------------------------------------------------
+// serialization of smart pointers and polymorphic types
+//  unique_ptr<T>: null flag and the object
+//  shared_ptr<T>: 0 for null, otherwise 1-based index of the object in the archive,
+//  the index of a new object is followed by the object, the objects already serialized
+//  through the same pointer type are referenced by index only, so shared objects stay shared
+//  polymorphic hierarchy is registered by specializing polymorphic_types<Base> with a tuple
+//  of the concrete types, type id is 1-based index in the tuple and replaces the null flag,
+//  new types must be appended to the end to keep the ids of the existing archives
+//  writing finds type id by typeid in a hash table, reading dispatches by id through a static table
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::archive
+{
+    //---------------------------------------------------------------------
+    // registry of polymorphic types, specialize for the base class:
+    //  template<> struct polymorphic_types<Base> { using types = std::tuple<Derived1, Derived2>; };
+    template<class Base>
+    struct polymorphic_types {};
+
+    template<class T>
+    constexpr bool is_polymorphic_registered_v = requires { typename polymorphic_types<T>::types; };
+
+    //---------------------------------------------------------------------
+    struct polymorphic_error : std::runtime_error
+    {
+        polymorphic_error(const std::string& msg) : std::runtime_error("polymorphic serialization: " + msg) {}
+    };
+
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        template<class Base, class Types>
+        struct polymorphic_ids;
+
+        template<class Base, class... Ds>
+        struct polymorphic_ids<Base, std::tuple<Ds...>>
+        {
+            static_assert(std::is_polymorphic_v<Base>, "base type must be polymorphic");
+            static_assert((std::derived_from<Ds, Base> && ...), "registered types must be derived from base");
+
+            static std::uint32_t type_id(const Base& b)
+            {
+                static const auto ids = [] {
+                    std::unordered_map<std::type_index, std::uint32_t> ids;
+                    std::uint32_t id = 0;
+                    (ids.emplace(typeid(Ds), ++id), ...);
+                    return ids;
+                }();
+
+                auto it = ids.find(typeid(b));
+                if (it == ids.end())
+                    throw polymorphic_error(std::string("unregistered type ") + typeid(b).name());
+                return it->second;
+            }
+        };
+
+        //---------------------------------------------------------------------
+        // dispatch tables indexed by type id - 1
+        template<class Archive, class Base, class Types>
+        struct polymorphic_table;
+
+        template<class Archive, class Base, class... Ds>
+        struct polymorphic_table<Archive, Base, std::tuple<Ds...>>
+        {
+            static void write(Archive& a, std::uint32_t id, const Base& b)
+            {
+                using writer_t = void(*)(Archive&, const Base&);
+                static constexpr writer_t writers[] = { [](Archive& a, const Base& b) { a(static_cast<const Ds&>(b)); }... };
+                writers[id - 1](a, b);
+            }
+
+            static std::unique_ptr<Base> read(Archive& a, std::uint32_t id)
+            {
+                using reader_t = std::unique_ptr<Base>(*)(Archive&);
+                static constexpr reader_t readers[] = { [](Archive& a) -> std::unique_ptr<Base> {
+                    auto p = std::make_unique<Ds>();
+                    a(*p);
+                    return p;
+                }... };
+                if (id == 0 || id > sizeof...(Ds))
+                    throw polymorphic_error("invalid type id " + std::to_string(id));
+                return readers[id - 1](a);
+            }
+        };
+
+        //---------------------------------------------------------------------
+        // write the object pointed by p, preceded by null flag or type id
+        template<class Archive, class T>
+        void write_pointee(Archive& a, const T* p)
+        {
+            if constexpr (is_polymorphic_registered_v<T>)
+            {
+                using types = typename polymorphic_types<T>::types;
+                std::uint32_t id = p ? polymorphic_ids<T, types>::type_id(*p) : 0;
+                a(serialize_as<std::uint32_t>(id));
+                if (p)
+                    polymorphic_table<Archive, T, types>::write(a, id, *p);
+            }
+            else
+            {
+                a(serialize_as<char>(p != nullptr));
+                if (p)
+                    a(*p);
+            }
+        }
+
+        // read the object written by write_pointee
+        template<class T, class Archive>
+        std::unique_ptr<T> read_pointee(Archive& a)
+        {
+            if constexpr (is_polymorphic_registered_v<T>)
+            {
+                std::uint32_t id{};
+                a(serialize_as<std::uint32_t>(id));
+                if (id == 0)
+                    return {};
+                return polymorphic_table<Archive, T, typename polymorphic_types<T>::types>::read(a, id);
+            }
+            else
+            {
+                auto has_value = false;
+                a(serialize_as<char>(has_value));
+                if (!has_value)
+                    return {};
+                static_assert(std::is_default_constructible_v<T>);
+                auto p = std::make_unique<T>();
+                a(*p);
+                return p;
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------
+    // serialization of unique_ptr
+    template<class Archive, class T>
+    auto serialize(Archive&& a, std::unique_ptr<T>& p) requires(is_iarchive_v<Archive>)
+    {
+        static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
+        p = detail::read_pointee<T>(a);
+    }
+
+    template<class Archive, class T>
+    auto serialize(Archive&& a, const std::unique_ptr<T>& p) requires(is_oarchive_v<Archive>)
+    {
+        static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
+        detail::write_pointee(a, p.get());
+    }
+
+    //---------------------------------------------------------------------
+    // serialization of shared_ptr
+    template<class Archive, class T>
+    auto serialize(Archive&& a, std::shared_ptr<T>& p) requires(is_iarchive_v<Archive>)
+    {
+        static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
+        std::uint64_t index{};
+        a(serialize_as<std::uint64_t>(index));
+        if (index == 0)
+        {
+            p.reset();
+            return;
+        }
+
+        auto& objects = a.get_shared_objects().objects;
+        if (index == objects.size() + 1)
+        {   // new object, the slot is taken before reading, because the object may contain shared pointers
+            objects.emplace_back(nullptr, typeid(T));
+            std::shared_ptr<T> object = detail::read_pointee<T>(a);
+            if (!object)
+                throw polymorphic_error("null shared object");
+            objects[index - 1].first = object;
+            p = std::move(object);
+        }
+        else if (index <= objects.size())
+        {
+            auto& [object, type] = objects[index - 1];
+            if (type != typeid(T))
+                throw polymorphic_error("shared object type mismatch");
+            if (!object)
+                throw polymorphic_error("cyclic shared object reference");
+            p = std::static_pointer_cast<T>(object);
+        }
+        else
+            throw polymorphic_error("invalid shared object index " + std::to_string(index));
+    }
+
+    template<class Archive, class T>
+    auto serialize(Archive&& a, const std::shared_ptr<T>& p) requires(is_oarchive_v<Archive>)
+    {
+        static_assert(!std::is_const_v<std::remove_reference_t<Archive>>);
+        if (!p)
+        {
+            a(serialize_as<std::uint64_t>(0));
+            return;
+        }
+
+        // the object is identified by the address of the most derived object
+        const void* address = p.get();
+        if constexpr (std::is_polymorphic_v<T>)
+            address = dynamic_cast<const void*>(p.get());
+
+        auto& ids = a.get_shared_objects().ids;
+        auto [it, inserted] = ids.try_emplace({ address, typeid(T) }, ids.size() + 1);
+        a(serialize_as<std::uint64_t>(it->second));
+        if (inserted)
+            detail::write_pointee(a, static_cast<const T*>(p.get()));
+    }
+}
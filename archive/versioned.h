@@ -0,0 +1,247 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2022, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "archive.h"
+
+//-----------------------------------------------------------------------------
+// versioned archive format
+//  archive header: magic number and format version, written once at the beginning of a file
+//  versioned object: type version, size of serialized data in bytes, serialized data
+//  type version is taken from static member T::serialization_version (0 if not defined)
+//  types that need to read old versions define serialize(archive, version) member
+//  objects of the current version are read directly from the stream, as fast as unversioned data,
+//  objects of other versions are buffered, so the fields unknown to the reader are skipped
+//  writing serializes the object once: memory and seekable streams get a size placeholder patched after
+//  the data, other streams and compact archives (varint size) get the object buffered in memory first
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::archive
+{
+    inline constexpr std::uint32_t archive_magic = 0x4f524459; // "YDRO"
+    inline constexpr std::uint32_t archive_format_version = 1;
+
+    //---------------------------------------------------------------------
+    struct invalid_archive : std::runtime_error
+    {
+        invalid_archive(const std::string& msg) : std::runtime_error("invalid archive: " + msg) {}
+    };
+
+    //---------------------------------------------------------------------
+    // version of serialized type
+    template<class T>
+    constexpr std::uint32_t serialization_version_v = [] {
+        if constexpr (requires { T::serialization_version; })
+            return static_cast<std::uint32_t>(T::serialization_version);
+        else
+            return std::uint32_t{ 0 };
+    }();
+
+    //---------------------------------------------------------------------
+    // write archive header
+    inline void write_header(auto&& a)
+    {
+        static_assert(is_oarchive_v<decltype(a)>);
+        a(archive_magic, archive_format_version);
+    }
+
+    // read archive header and return format version,
+    // returns nullopt if the archive doesn't start with the header (only the magic number is read in this case)
+    inline std::optional<std::uint32_t> read_header(auto&& a)
+    {
+        static_assert(is_iarchive_v<decltype(a)>);
+        std::uint32_t magic{}, version{};
+        a(magic);
+        if (magic != archive_magic)
+            return std::nullopt;
+
+        a(version);
+        if (version > archive_format_version)
+            throw invalid_archive("unsupported format version " + std::to_string(version));
+        return version;
+    }
+
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        template<class Archive, class T>
+        void serialize_version(Archive&& a, T& t, std::uint32_t version)
+        {
+            if constexpr (requires { t.serialize(a, version); })
+                t.serialize(a, version);
+            else
+                a(t);
+        }
+
+        //---------------------------------------------------------------------
+        // memory archive of the same byte format, it takes the shared objects of the outer archive for its lifetime
+        template<class Archive, class Stream>
+        struct nested_archive
+        {
+            using outer_type = std::remove_cvref_t<Archive>;
+            archive<Stream, outer_type::format == archive_format_t::compact ? archive_format_t::compact : archive_format_t::custom> a;
+            outer_type& outer;
+
+            explicit nested_archive(outer_type& outer, auto&&... args) : a(std::forward<decltype(args)>(args)...), outer(outer)
+            {
+                std::swap(a.shared_objects_state(), outer.shared_objects_state());
+            }
+            ~nested_archive() { std::swap(a.shared_objects_state(), outer.shared_objects_state()); }
+            nested_archive(const nested_archive&) = delete;
+            nested_archive& operator=(const nested_archive&) = delete;
+        };
+
+        //---------------------------------------------------------------------
+        // write the size of serialized t in bytes, followed by t
+        template<class Archive, class T>
+        void write_sized(Archive& a, const T& t)
+        {
+            using archive_type = std::remove_cvref_t<Archive>;
+            using char_type = typename archive_type::char_type;
+            auto& s = a.get_stream();
+
+            if constexpr (std::is_same_v<typename archive_type::stream_type, archive_size_stream>)
+            {   // the size is only counted, its place doesn't matter
+                auto start = s.get_size();
+                a(t);
+                a(serialize_as<std::uint64_t>(s.get_size() - start));
+                return;
+            }
+            else if constexpr (archive_type::format != archive_format_t::compact)
+            {   // fixed size placeholder, patched after the data
+                auto patch_size = [](auto start, auto end, auto&& patch)
+                {
+                    auto size = static_cast<std::uint64_t>(end - start) * sizeof(char_type);
+                    patch(static_cast<const char_type*>(static_cast<const void*>(&size)),
+                        static_cast<std::streamsize>(sizeof(size) / sizeof(char_type)));
+                };
+
+                if constexpr (requires { s.patch(s.tellp(), static_cast<const char_type*>(nullptr), std::streamsize{}); })
+                {   // memory stream
+                    auto pos = s.tellp();
+                    a(serialize_as<std::uint64_t>(0));
+                    auto start = s.tellp();
+                    a(t);
+                    patch_size(start, s.tellp(), [&](auto c, auto size) { s.patch(pos, c, size); });
+                    return;
+                }
+                else if constexpr (requires { s.seekp(s.tellp()); })
+                {   // seekable std::ostream, pipes and sockets report -1 position
+                    auto pos = s.tellp();
+                    if (pos != decltype(pos)(-1))
+                    {
+                        a(serialize_as<std::uint64_t>(0));
+                        auto start = s.tellp();
+                        a(t);
+                        auto end = s.tellp();
+                        patch_size(start, end, [&](auto c, auto size) { s.seekp(pos).write(c, size); });
+                        s.seekp(end);
+                        return;
+                    }
+                }
+            }
+
+            // the stream can't be patched, t is serialized into memory once
+            nested_archive<Archive, omem_stream<std::vector<char_type>>> na(a);
+            na.a(t);
+            auto& buf = na.a.get_stream().get_buffer();
+            a(serialize_as<std::uint64_t>(buf.size() * sizeof(char_type)));
+            if (!buf.empty())
+                a.write(buf[0], buf.size());
+        }
+    }
+
+    //---------------------------------------------------------------------
+    // wrapper serializing type version and data size before the data
+    template<class T>
+    class versioned_t
+    {
+        T t;
+        using pure_type = std::remove_cvref_t<T>;
+    public:
+        explicit versioned_t(auto&& ... args) : t(std::forward<decltype(args)>(args)...) {}
+        const auto& get() const { return t; }
+        auto& get() { return t; }
+
+        template<class Ar>
+        auto serialize(Ar& a) requires(is_iarchive_v<Ar>)
+        {
+            static_assert(std::remove_cvref_t<Ar>::format != archive_format_t::text);
+
+            std::uint32_t version{};
+            std::uint64_t size{};
+            a(version, size);
+
+            if (version == serialization_version_v<pure_type>)
+            {   // unchanged schema
+                detail::serialize_version(a, t, version);
+            }
+            else
+            {   // different schema, the reader may consume less than written
+                // the size isn't trusted, the data are read in bounded blocks, so a truncated stream
+                // fails before a large allocation
+                using char_type = typename std::remove_cvref_t<Ar>::char_type;
+                if (size % sizeof(char_type) != 0)
+                    throw invalid_archive("invalid versioned object size");
+                constexpr std::size_t max_block = std::size_t(1) << 20;
+                auto count = static_cast<std::size_t>(size / sizeof(char_type));
+                std::vector<char_type> buf;
+                for (std::size_t pos = 0; pos < count; pos = buf.size())
+                {
+                    buf.resize(pos + std::min(count - pos, max_block));
+                    a.read(buf[pos], buf.size() - pos);
+                }
+
+                detail::nested_archive<Ar, imem_stream<std::vector<char_type>>> ia(a, omem_stream<std::vector<char_type>>(std::move(buf)));
+                detail::serialize_version(ia.a, t, version);
+            }
+        }
+
+        template<class Ar>
+        auto serialize(Ar& a) const requires(is_oarchive_v<Ar>)
+        {
+            static_assert(std::remove_cvref_t<Ar>::format != archive_format_t::text);
+
+            a(serialization_version_v<pure_type>);
+            detail::write_sized(a, t);
+        }
+    };
+
+    template<class T>
+    versioned_t(T&& t)->versioned_t<T>;
+
+    template<class T>
+    auto versioned(T&& t) { return versioned_t<T>(std::forward<T>(t)); }
+}
@@ -0,0 +1,269 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2022, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// archive benchmark: encode/decode throughput and heap allocations
+//  of every archive format for representative data shapes
+//  usage: yadro_bench [repetitions]
+//  output is CSV, one line per format and shape:
+//  format,shape,bytes,encode_mb_s,decode_mb_s,encode_allocs,decode_allocs
+//  throughput is calculated from the best repetition, allocations are per repetition
+//-----------------------------------------------------------------------------
+
+#include "../archive/archive.h"
+#include "../container/graph.h"
+#include "../container/tensor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#pragma comment(lib, "yadro")
+
+//-----------------------------------------------------------------------------
+// allocation counting
+namespace
+{
+    std::atomic<std::uint64_t> allocations{};
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+    using namespace gb::yadro::archive;
+    namespace container = gb::yadro::container;
+
+    //-------------------------------------------------------------------------
+    // data shapes
+    struct pod
+    {
+        std::int32_t id{};
+        float x{}, y{}, z{};
+        double w{};
+
+        auto operator==(const pod&) const -> bool = default;
+
+        // field by field serialization for text archives, the other formats read/write vectors of pods in bulk
+        template<class Ar>
+        void serialize(Ar& a) { a(id, x, y, z, w); }
+    };
+    static_assert(is_bitwise_serializable_v<pod>);
+
+    using nested_t = std::tuple<int, std::variant<std::int64_t, double, std::string>, std::tuple<float, std::string, std::optional<int>>>;
+
+    auto make_pods(std::mt19937_64& rng)
+    {
+        std::uniform_real_distribution<float> f(-100.f, 100.f);
+        std::vector<pod> v(1'000'000);
+        for (std::int32_t i = 0; auto& p : v)
+            p = pod{ i++, f(rng), f(rng), f(rng), f(rng) * 1e3 };
+        return v;
+    }
+
+    auto make_doubles(std::mt19937_64& rng)
+    {
+        std::uniform_real_distribution<double> d(-1e6, 1e6);
+        std::vector<double> v(1'000'000);
+        for (auto& x : v)
+            x = d(rng);
+        return v;
+    }
+
+    auto make_string(std::mt19937_64& rng, std::size_t min_size, std::size_t max_size)
+    {
+        std::uniform_int_distribution<std::size_t> size(min_size, max_size);
+        std::uniform_int_distribution<int> c('a', 'z');
+        std::string s(size(rng), ' ');
+        for (auto& ch : s)
+            ch = static_cast<char>(c(rng));
+        return s;
+    }
+
+    auto make_string_map(std::mt19937_64& rng)
+    {
+        std::map<std::string, std::string> m;
+        while (m.size() < 100'000)
+            m.emplace(make_string(rng, 8, 24), make_string(rng, 0, 64));
+        return m;
+    }
+
+    auto make_nested(std::mt19937_64& rng)
+    {
+        std::vector<nested_t> v(200'000);
+        for (int i = 0; auto& t : v)
+        {
+            std::variant<std::int64_t, double, std::string> var;
+            switch (i % 3)
+            {
+            case 0: var = static_cast<std::int64_t>(rng()); break;
+            case 1: var = static_cast<double>(rng()) / 3; break;
+            default: var = make_string(rng, 0, 16); break;
+            }
+            t = nested_t{ i, std::move(var), { static_cast<float>(i) / 7, make_string(rng, 0, 8),
+                i % 2 ? std::optional<int>(i) : std::nullopt } };
+            ++i;
+        }
+        return v;
+    }
+
+    auto make_graph(std::mt19937_64& rng)
+    {
+        constexpr std::size_t nodes = 100'000;
+        container::graph<int, double> g(nodes, 0);
+        std::uniform_int_distribution<std::size_t> node(0, nodes - 1);
+        for (std::size_t i = 0; i < 3 * nodes; ++i)
+            g.add_edge(node(rng), node(rng), static_cast<double>(i) / 3);
+        return g;
+    }
+
+    auto make_tensor(std::mt19937_64& rng)
+    {
+        std::uniform_real_distribution<double> d(-1.0, 1.0);
+        container::tensor<double> t(64, 64, 64);
+        for (auto& x : t.data())
+            x = d(rng);
+        return t;
+    }
+
+    //-------------------------------------------------------------------------
+    // formats
+    template<archive_format_t fmt>
+    struct stream_format
+    {
+        static auto encode(const auto& t)
+        {
+            archive<std::ostringstream, fmt> oa;
+            oa(t);
+            return std::move(oa.get_stream()).str();
+        }
+        static auto make_reader(const std::string& data) { return archive<std::istringstream, fmt>(data); }
+        static auto size(const std::string& data) { return data.size(); }
+    };
+
+    template<archive_format_t fmt>
+    struct memory_format
+    {
+        static auto encode(const auto& t)
+        {
+            archive<omem_stream<std::vector<char>>, fmt> oa;
+            oa(t);
+            return std::move(oa.get_stream());
+        }
+        static auto make_reader(const omem_stream<std::vector<char>>& data) { return archive<imem_stream<std::vector<char>>, fmt>(data); }
+        static auto size(const omem_stream<std::vector<char>>& data) { return data.get_buffer().size(); }
+    };
+
+    //-------------------------------------------------------------------------
+    template<class Format, class T>
+    void bench(const char* format_name, const char* shape_name, const T& t, int repetitions)
+    {
+        using clock = std::chrono::steady_clock;
+        auto best_encode = clock::duration::max(), best_decode = clock::duration::max();
+        std::uint64_t encode_allocs{}, decode_allocs{}, bytes{};
+
+        for (int r = 0; r < repetitions; ++r)
+        {
+            auto allocs = allocations.load();
+            auto t0 = clock::now();
+            auto data = Format::encode(t);
+            auto t1 = clock::now();
+            encode_allocs += allocations.load() - allocs;
+            best_encode = std::min(best_encode, t1 - t0);
+            bytes = Format::size(data);
+
+            auto reader = Format::make_reader(data);
+            T t2{};
+            allocs = allocations.load();
+            t0 = clock::now();
+            reader(t2);
+            t1 = clock::now();
+            decode_allocs += allocations.load() - allocs;
+            best_decode = std::min(best_decode, t1 - t0);
+
+            if (!(t2 == t))
+                throw std::runtime_error(std::string(format_name) + " " + shape_name + ": decoded data differ");
+        }
+
+        auto mb_s = [&](auto dt) { return bytes / std::max(std::chrono::duration<double>(dt).count(), 1e-9) / 1e6; };
+        std::cout << format_name << ',' << shape_name << ',' << bytes << ','
+            << mb_s(best_encode) << ',' << mb_s(best_decode) << ','
+            << encode_allocs / repetitions << ',' << decode_allocs / repetitions << std::endl;
+    }
+
+    template<class T>
+    void bench_formats(const char* shape_name, const T& t, int repetitions)
+    {
+        bench<stream_format<archive_format_t::binary>>("binary", shape_name, t, repetitions);
+        bench<stream_format<archive_format_t::custom>>("custom", shape_name, t, repetitions);
+        bench<stream_format<archive_format_t::text>>("text", shape_name, t, repetitions);
+        bench<memory_format<archive_format_t::custom>>("memory", shape_name, t, repetitions);
+        bench<memory_format<archive_format_t::compact>>("compact", shape_name, t, repetitions);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    auto repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+    std::mt19937_64 rng(20240708);
+
+    try
+    {
+        std::cout << "format,shape,bytes,encode_mb_s,decode_mb_s,encode_allocs,decode_allocs" << std::endl;
+        bench_formats("vector_pod", make_pods(rng), repetitions);
+        bench_formats("vector_double", make_doubles(rng), repetitions);
+        bench_formats("map_string", make_string_map(rng), repetitions);
+        bench_formats("nested_tuple_variant", make_nested(rng), repetitions);
+        bench_formats("graph", make_graph(rng), repetitions);
+        bench_formats("tensor", make_tensor(rng), repetitions);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
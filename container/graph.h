@@ -42,6 +42,7 @@
 #include <set>
 #include <optional>
 #include "../archive/archive.h"
+#include "../archive/parallel.h"
 
 namespace gb::yadro::container
 {
@@ -200,6 +201,21 @@ namespace gb::yadro::container
         }
     };
 
+    namespace detail
+    {
+        //-------------------------------------------------------------------------
+        // edge/node is serialized as data followed by index fields, which matches its memory layout
+        // if data is bitwise and there is no padding, so containers of them can be copied as raw memory
+        template<class T, std::size_t IndexCount, class Wrapper>
+        constexpr bool is_packed_v = [] {
+            if constexpr (std::is_void_v<T>)
+                return std::is_trivially_copyable_v<Wrapper> && sizeof(Wrapper) == IndexCount * sizeof(index_t);
+            else
+                return archive::is_bitwise_serializable_v<T> && std::is_trivially_copyable_v<Wrapper>
+                    && sizeof(Wrapper) == sizeof(T) + IndexCount * sizeof(index_t);
+        }();
+    }
+
     //-------------------------------------------------------------------------
     template<class NodeT = void, class EdgeT = void>
     class graph
@@ -213,6 +229,8 @@ namespace gb::yadro::container
             : nodes(node_count, node<NodeT>(invalid_index, invalid_index, init...))
         {}
 
+        graph() = default;
+
         template<class Archive>
         explicit graph(Archive&& a) requires(gb::yadro::archive::is_iarchive_v<Archive>)
         {
@@ -361,12 +379,22 @@ namespace gb::yadro::container
             return std::optional<path_t>();
         }
 
+        // graph is stored with archive::versioned(g) to detect format changes
+        static constexpr std::uint32_t serialization_version = 1;
+
         template<class Archive>
         void serialize(Archive&& a)
         {
             a(edges, nodes);
         }
 
+        // parallel serialization of large graphs, edges and nodes are serialized in chunks on the threadpool
+        template<class Archive>
+        void serialize(Archive&& a, async::threadpool<>& pool)
+        {
+            a(archive::parallel(edges, pool), archive::parallel(nodes, pool));
+        }
+
         auto& dump_nodes(std::ostream& os) const
         {
             for (std::size_t n = 0; n < nodes.size(); ++n)
@@ -403,3 +431,16 @@ namespace gb::yadro::container
 
     };
 }
+
+namespace gb::yadro::archive
+{
+    //-------------------------------------------------------------------------
+    // graph edges and nodes without padding are serialized in bulk
+    template<class T>
+    struct is_bitwise_serializable<container::edge<T>>
+        : std::bool_constant<container::detail::is_packed_v<T, 4, container::edge<T>>> {};
+
+    template<class T>
+    struct is_bitwise_serializable<container::node<T>>
+        : std::bool_constant<container::detail::is_packed_v<T, 2, container::node<T>>> {};
+}
@@ -30,6 +30,12 @@
 
 #include "matrix.h"
 #include "../util/misc.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
 
 namespace gb::yadro::container
 {
@@ -254,6 +260,200 @@ namespace gb::yadro::container
         return solve(m, identity_matrix< typename m_type::data_type>(m.rows()));
     }
 
+    //---------------------------------------------------------------------------------------------
+    // decompositions work on the storage of a dense copy, matrix<T> keeps the columns contiguous:
+    // element (row, col) is data()[row + col * rows()]
+    //---------------------------------------------------------------------------------------------
+    namespace detail
+    {
+        template<class T>
+        inline auto dense_matrix(matrix_c auto&& m)
+        {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(m)>, matrix<T>>)
+                return matrix<T>(std::forward<decltype(m)>(m));
+            else
+            {
+                matrix<T> result(m.rows(), m.columns());
+                for (std::size_t col = 0; col < m.columns(); ++col)
+                    for (std::size_t row = 0; row < m.rows(); ++row)
+                        result(row, col) = m(row, col);
+                return result;
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // solve m * x = rh for symmetric positive definite m by Cholesky decomposition m = L * L^T
+    inline auto cholesky_solve(matrix_c auto&& m, matrix_c auto&& rh)
+    {
+        using data_type = typename matrix_traits<decltype(m)>::data_type;
+        gb::yadro::util::gbassert(m.columns() == m.rows() && rh.rows() == m.rows());
+        const auto n = m.rows();
+        auto l_matrix = detail::dense_matrix<data_type>(std::forward<decltype(m)>(m));
+        auto result = detail::dense_matrix<data_type>(std::forward<decltype(rh)>(rh));
+        auto l = [n, data = l_matrix.data().data()](std::size_t row, std::size_t col) -> data_type& { return data[row + col * n]; };
+
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            auto diagonal = l(j, j);
+            for (std::size_t k = 0; k < j; ++k)
+                diagonal -= l(j, k) * l(j, k);
+            gb::yadro::util::gbassert(diagonal > 0, "cholesky_solve: matrix is not positive definite");
+            diagonal = std::sqrt(diagonal);
+            l(j, j) = diagonal;
+
+            for (std::size_t i = j + 1; i < n; ++i)
+            {
+                auto value = l(i, j);
+                for (std::size_t k = 0; k < j; ++k)
+                    value -= l(i, k) * l(j, k);
+                l(i, j) = value / diagonal;
+            }
+        }
+
+        for (std::size_t col = 0, cols = result.columns(); col < cols; ++col)
+        {
+            auto b = result.data().data() + col * n;
+            for (std::size_t i = 0; i < n; ++i)
+            {   // L * z = b
+                for (std::size_t k = 0; k < i; ++k)
+                    b[i] -= l(i, k) * b[k];
+                b[i] /= l(i, i);
+            }
+            for (std::size_t i = n; i-- != 0;)
+            {   // L^T * x = z
+                for (std::size_t k = i + 1; k < n; ++k)
+                    b[i] -= l(k, i) * b[k];
+                b[i] /= l(i, i);
+            }
+        }
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // least squares solution of m * x = rh for m with at least as many rows as columns,
+    // by Householder QR decomposition m = Q * R, then R * x = Q^T * rh
+    inline auto qr_solve(matrix_c auto&& m, matrix_c auto&& rh)
+    {
+        using data_type = typename matrix_traits<decltype(m)>::data_type;
+        const auto rows = m.rows(), columns = m.columns();
+        gb::yadro::util::gbassert(rh.rows() == rows);
+        gb::yadro::util::gbassert(rows >= columns, "qr_solve: fewer rows than columns");
+        auto r_matrix = detail::dense_matrix<data_type>(std::forward<decltype(m)>(m));
+        auto rh_matrix = detail::dense_matrix<data_type>(std::forward<decltype(rh)>(rh));
+        auto column = [rows](auto& dense, std::size_t col) { return dense.data().data() + col * rows; };
+        data_type max_diagonal{};
+
+        for (std::size_t k = 0; k < columns; ++k)
+        {
+            auto xk = column(r_matrix, k);
+            auto norm = std::sqrt(std::inner_product(xk + k, xk + rows, xk + k, data_type{}));
+            if (norm == 0)
+                continue; // zero column, detected as zero diagonal below
+
+            // reflect the column k to (alpha, 0, ...), v is stored in place of the column
+            auto alpha = xk[k] > 0 ? -norm : norm;
+            xk[k] -= alpha;
+            auto v_norm2 = std::inner_product(xk + k, xk + rows, xk + k, data_type{});
+
+            auto reflect = [&](data_type* c)
+                {
+                    auto factor = 2 * std::inner_product(xk + k, xk + rows, c + k, data_type{}) / v_norm2;
+                    for (std::size_t i = k; i < rows; ++i)
+                        c[i] -= factor * xk[i];
+                };
+
+            for (std::size_t j = k + 1; j < columns; ++j)
+                reflect(column(r_matrix, j));
+            for (std::size_t j = 0, rh_columns = rh_matrix.columns(); j < rh_columns; ++j)
+                reflect(column(rh_matrix, j));
+
+            xk[k] = alpha; // R diagonal, the rest of the column isn't used anymore
+            max_diagonal = std::max(max_diagonal, std::abs(alpha));
+        }
+
+        matrix<data_type> result(columns, rh_matrix.columns());
+        for (std::size_t col = 0, cols = rh_matrix.columns(); col < cols; ++col)
+        {
+            auto b = column(rh_matrix, col);
+            auto x = result.data().data() + col * columns;
+            for (std::size_t i = columns; i-- != 0;)
+            {
+                auto diagonal = column(r_matrix, i)[i];
+                gb::yadro::util::gbassert(std::abs(diagonal) > max_diagonal * rows * std::numeric_limits<data_type>::epsilon(),
+                    "qr_solve: matrix is rank deficient");
+                auto value = b[i];
+                for (std::size_t j = i + 1; j < columns; ++j)
+                    value -= column(r_matrix, j)[i] * x[j];
+                x[i] = value / diagonal;
+            }
+        }
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------------------
+    // cyclic Jacobi eigen decomposition of symmetric matrix m,
+    // returns the eigenvalues and the matrix with the corresponding eigenvectors in its columns
+    inline auto symmetric_eigen(matrix_c auto&& m)
+    {
+        using data_type = typename matrix_traits<decltype(m)>::data_type;
+        gb::yadro::util::gbassert(m.columns() == m.rows());
+        const auto n = m.rows();
+        auto a_matrix = detail::dense_matrix<data_type>(std::forward<decltype(m)>(m));
+        auto e_matrix = identity_matrix<data_type>(n);
+        auto a = [n, data = a_matrix.data().data()](std::size_t row, std::size_t col) -> data_type& { return data[row + col * n]; };
+        auto e = [n, data = e_matrix.data().data()](std::size_t row, std::size_t col) -> data_type& { return data[row + col * n]; };
+
+        for (int sweep = 0; sweep < 50; ++sweep)
+        {
+            data_type off{}, diagonal{};
+            for (std::size_t p = 0; p < n; ++p)
+            {
+                diagonal += a(p, p) * a(p, p);
+                for (std::size_t q = p + 1; q < n; ++q)
+                    off += a(p, q) * a(p, q);
+            }
+            if (off <= 1e-24 * diagonal)
+                break;
+
+            for (std::size_t p = 0; p < n; ++p)
+                for (std::size_t q = p + 1; q < n; ++q)
+                {
+                    auto apq = a(p, q);
+                    if (apq == 0)
+                        continue;
+
+                    auto theta = (a(q, q) - a(p, p)) / (2 * apq);
+                    auto t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                    auto c = 1 / std::sqrt(t * t + 1), s = t * c;
+
+                    for (std::size_t k = 0; k < n; ++k)
+                    {   // columns p and q
+                        auto akp = a(k, p), akq = a(k, q);
+                        a(k, p) = c * akp - s * akq;
+                        a(k, q) = s * akp + c * akq;
+                    }
+                    for (std::size_t k = 0; k < n; ++k)
+                    {   // rows p and q
+                        auto apk = a(p, k), aqk = a(q, k);
+                        a(p, k) = c * apk - s * aqk;
+                        a(q, k) = s * apk + c * aqk;
+                    }
+                    for (std::size_t k = 0; k < n; ++k)
+                    {
+                        auto ekp = e(k, p), ekq = e(k, q);
+                        e(k, p) = c * ekp - s * ekq;
+                        e(k, q) = s * ekp + c * ekq;
+                    }
+                }
+        }
+
+        std::vector<data_type> eigenvalues(n);
+        for (std::size_t i = 0; i < n; ++i)
+            eigenvalues[i] = a(i, i);
+        return std::pair{ std::move(eigenvalues), std::move(e_matrix) };
+    }
+
     //---------------------------------------------------------------------------------------------
     // returns a new sime dimensions matrix with every element being a transformation of every element 
     // of other matrixes by invoking transform_fn(row, col, values...)
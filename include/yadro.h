@@ -30,6 +30,11 @@
 
 #include "../algorithm/gbalgorithm.h"
 #include "../archive/archive.h"
+#include "../archive/versioned.h"
+#include "../archive/compressed_stream.h"
+#include "../archive/parallel.h"
+#include "../archive/indexed.h"
+#include "../archive/polymorphic.h"
 #include "../async/threadpool.h"
 #include "../container/gbcontainer.h"
 #include "../util/gbutil.h"
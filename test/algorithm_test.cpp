@@ -30,9 +30,13 @@
 #include "../util/misc.h"
 #include "../archive/archive.h"
 #include "../algorithm/genetic_optimization.h"
+#include "../algorithm/island_optimization.h"
+#include "../algorithm/population_optimization.h"
 #include "../algorithm/regression_analysis.h"
 #include <iostream>
 #include <thread>
+#include <future>
+#include <sstream>
 
 namespace
 {
@@ -204,6 +208,14 @@ namespace
             }
 #endif
         }
+        {// threads exchange solutions on every loop
+            optimizer.clear();
+            optimizer.set_sync_interval(1, 0ms);
+            gb::yadro::async::threadpool<> tp;
+            auto [stat, opt_map] = optimizer.optimize(tp, 100ms, 5);
+            gbassert(!opt_map.empty() && opt_map.size() <= 5);
+            gbassert(stat.unique_param_count + stat.repetition_count == stat.loop_count);
+        }
     }
 
     //--------------------------------------------------------------------------------------------
@@ -228,6 +240,25 @@ namespace
         gbassert(opt_map.size() == 5);
         gbassert(opt_map.begin()->first < 0.01); // may fail on very slow machines
 #endif
+        // save/load versioned file and load legacy file without header
+        auto state = [](auto&& opt) { gb::yadro::archive::omem_archive<> ma; ma(opt); return ma.get_stream().get_buffer(); };
+        auto path = std::filesystem::temp_directory_path() / "yadro_genetic_opt_serialization_test.bin";
+        tmp_file_cleaner_t::add(path);
+
+        auto saved = state(optimizer);
+        optimizer.save(path);
+        optimizer.clear();
+        optimizer.load(path);
+        gbassert(state(optimizer) == saved);
+
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            gb::yadro::archive::bin_archive ar(ofs);
+            ar(optimizer);
+        }
+        optimizer.clear();
+        optimizer.load(path);
+        gbassert(state(optimizer) == saved);
 
 #if defined(GB_DEBUGGING)
         std::cout << "\n" << stat << "\n";
@@ -240,6 +271,438 @@ namespace
 #endif
     }
 
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, genetic_opt_visited_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+
+        {// bounded exact set forgets the oldest hashes
+            gb::yadro::algorithm::detail::sharded_hash_set visited;
+            visited.set_limit(128);
+            for (std::size_t i = 0; i < 1000; ++i)
+                gbassert(visited.insert(i));
+            gbassert(visited.size() <= 128);
+            gbassert(!visited.insert(999));
+
+            // the limit is exact, even when it's smaller than the number of shards
+            visited.set_limit(10);
+            for (std::size_t i = 0; i < 1000; ++i)
+                visited.insert(i);
+            gbassert(visited.size() <= 10);
+
+            // the size read from a corrupted stream doesn't allocate
+            using gb::yadro::archive::archive_format_t;
+            gb::yadro::archive::archive<std::ostringstream, archive_format_t::custom> oa(std::ios::binary);
+            oa(std::uint64_t(1) << 60, std::uint64_t(1) << 60, std::size_t(1));
+            std::istringstream is(oa.get_stream().str(), std::ios::binary);
+            is.exceptions(std::ios::failbit | std::ios::badbit); // the missing hashes end the reading
+            gb::yadro::archive::archive<std::istringstream&, archive_format_t::custom> ia(is);
+            auto is_bad_alloc = false;
+            try { ia(visited); }
+            catch (std::bad_alloc&) { is_bad_alloc = true; }
+            catch (...) {}
+            gbassert(!is_bad_alloc);
+        }
+        {// bloom filter rejects about false_positive_rate of the new hashes
+            gb::yadro::algorithm::detail::blocked_bloom_filter filter(10'000, 0.01);
+            std::size_t rejected = 0;
+            for (std::size_t i = 0; i < 10'000; ++i)
+                rejected += !filter.insert(gb::yadro::util::make_hash(i));
+            gbassert(rejected < 300);
+            for (std::size_t i = 0; i < 10'000; ++i)
+                gbassert(!filter.insert(gb::yadro::util::make_hash(i)));
+            must_throw([] { gb::yadro::algorithm::detail::blocked_bloom_filter(10, 0.); });
+        }
+
+        genetic_optimization_t optimizer([](auto x, auto y, auto z, auto v)
+            { return x * x + y * y + std::exp(z) / 2 + std::exp(-z) / 2 - 1 + (v + std::sin(v)) * (v + std::sin(v)); },
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.));
+        auto state = [](auto&& opt) { gb::yadro::archive::omem_archive<> ma; ma(opt); return ma.get_stream().get_buffer(); };
+
+        for (auto use_filter : { false, true })
+        {
+            if (use_filter)
+                optimizer.set_visited_filter(100'000, 0.001);
+            else
+                optimizer.set_visited_limit(1000);
+
+            auto [stat, opt_map] = optimizer.optimize(20ms, 5);
+            gbassert(opt_map.size() == 5);
+            gbassert(stat.visited_memory > 0);
+
+            gb::yadro::archive::omem_archive<> oma;
+            oma(optimizer);
+            auto saved = oma.get_stream().get_buffer();
+            optimizer.set_visited_limit(-1);
+            gb::yadro::archive::imem_archive ima(std::move(oma));
+            ima(optimizer);
+            gbassert(state(optimizer) == saved);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, genetic_opt_batch_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+        using params_t = std::tuple<unsigned, long long, float, double>;
+
+        std::atomic<std::size_t> max_batch{};
+        genetic_optimization_t optimizer([&](std::span<const params_t> batch)
+            {
+                max_batch = std::max(max_batch.load(), batch.size());
+                std::vector<double> targets;
+                for (auto&& [x, y, z, v] : batch)
+                    targets.push_back(x * x + y * y + std::exp(z) / 2 + std::exp(-z) / 2 - 1 + (v + std::sin(v)) * (v + std::sin(v)));
+                return targets;
+            },
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.));
+        static_assert(std::same_as<decltype(optimizer)::target_t, double>);
+
+        optimizer.add_solution(1u, 0LL, 1e-2f, 1e-3);
+        optimizer.set_batch_size(8);
+        {
+            auto [stat, opt_map] = optimizer.optimize(50ms, 5);
+            gbassert(opt_map.size() == 5);
+            gbassert(max_batch > 1 && max_batch <= 8);
+#if defined(NDEBUG)
+            gbassert(opt_map.begin()->first < 0.01); // may fail on very slow machines
+#endif
+        }
+        {
+            optimizer.clear();
+            gb::yadro::async::threadpool<> tp;
+            auto [stat, opt_map] = optimizer.optimize(tp, 50ms, 5);
+            gbassert(!opt_map.empty());
+            gbassert(stat.unique_param_count + stat.repetition_count == stat.loop_count);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, genetic_opt_steady_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+
+        // evaluation time varies from 0 to 2ms
+        genetic_optimization_t optimizer([](auto x, auto y, auto z, auto v)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(std::abs(y) * 200));
+                return x * x + y * y + std::exp(z) / 2 + std::exp(-z) / 2 - 1 + (v + std::sin(v)) * (v + std::sin(v));
+            },
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.));
+
+        gb::yadro::async::threadpool<> tp(4);
+        {
+            auto [stat, opt_map] = optimizer.optimize_steady(tp, 200ms, 5);
+            gbassert(opt_map.size() == 5);
+            gbassert(stat.unique_param_count + stat.repetition_count == stat.loop_count);
+            gbassert(std::ranges::is_sorted(opt_map | std::views::keys));
+#if defined(NDEBUG)
+            gbassert(opt_map.begin()->first < 1); // may fail on very slow machines
+#endif
+        }
+        {
+            auto [stat, opt_map] = optimizer.optimize_steady(tp, 1e10, 1s, 5);
+            gbassert(stat.unique_param_count <= 8); // the first result is acceptable, nothing else is submitted
+        }
+        {// exceptions of target function are rethrown
+            genetic_optimization_t failing([](int x) { if (x > 5) throw std::runtime_error("failed"); return x; }, std::tuple(0, 10));
+            must_throw([&] { failing.optimize_steady(tp, 1s); });
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, genetic_opt_cache_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+
+        std::atomic<std::size_t> evaluations{};
+        auto fn = [&](auto x, auto y, auto z)
+            {
+                ++evaluations;
+                return x * x + y * y + (z - 1) * (z - 1);
+            };
+        genetic_optimization_t optimizer(fn, std::tuple(-10, 10), std::tuple(-10., 10.), std::tuple(-10.f, 10.f));
+        optimizer.set_cache(true);
+        optimizer.set_grid(0, 0.5, 0.25f);
+
+        auto [stat, opt_map] = optimizer.optimize(20ms, 5);
+        gbassert(opt_map.size() == 5);
+        for (auto&& [target, params] : opt_map)
+        {
+            auto [x, y, z] = params;
+            gbassert(std::fmod(y + 10, 0.5) == 0 && std::fmod(z + 10, 0.25f) == 0);
+            gbassert(optimizer.cached_target(params) == target);
+        }
+        // the grid has 21 * 41 * 81 points, the cache keeps all tried parameters, so no parameters are evaluated twice
+        gbassert(evaluations == stat.unique_param_count);
+        gbassert(evaluations <= 21 * 41 * 81);
+
+        // the cache is saved with the state
+        gb::yadro::archive::omem_archive<> oma;
+        oma(optimizer);
+        auto saved = oma.get_stream().get_buffer();
+        genetic_optimization_t restored(fn, std::tuple(-10, 10), std::tuple(-10., 10.), std::tuple(-10.f, 10.f));
+        gb::yadro::archive::imem_archive ima(std::move(oma));
+        ima(restored);
+        gbassert(restored.cached_target(opt_map.begin()->second) == opt_map.begin()->first);
+        gb::yadro::archive::omem_archive<> oma2;
+        oma2(restored);
+        gbassert(oma2.get_stream().get_buffer() == saved);
+
+        // the tried parameters are not evaluated again in the next run
+        evaluations = 0;
+        auto [stat2, opt_map2] = restored.optimize(20ms, 5);
+        gbassert(evaluations == stat2.unique_param_count);
+        gbassert(opt_map2.begin()->first <= opt_map.begin()->first);
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, genetic_opt_telemetry_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+
+        genetic_optimization_t optimizer([](auto x, auto y, auto z, auto v)
+            { return x * x + y * y + std::exp(z) / 2 + std::exp(-z) / 2 - 1 + (v + std::sin(v)) * (v + std::sin(v)); },
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.));
+        using sample_t = telemetry_sample<double>;
+
+        auto check = [](const std::vector<sample_t>& samples, const stats& stat)
+            {
+                gbassert(!samples.empty() && samples.back().is_final);
+                gbassert(samples.back().total.unique_param_count == stat.unique_param_count);
+                gbassert(samples.back().total.improvement_count == stat.improvement_count);
+                gbassert(stat.genetic_success <= stat.genetic_count && stat.gradient_success <= stat.gradient_count
+                    && stat.mutation_success <= stat.mutation_count);
+                for (std::size_t i = 1; i < samples.size(); ++i)
+                {
+                    gbassert(samples[i - 1].time <= samples[i].time);
+                    gbassert(*samples[i].best_target <= *samples[i - 1].best_target);
+                    gbassert(samples[i].utilization >= 0 && samples[i].utilization <= 1);
+                }
+            };
+
+        std::vector<sample_t> samples;
+        optimizer.set_telemetry([&](const sample_t& sample) { samples.push_back(sample); }, 5ms);
+        gb::yadro::async::threadpool<> tp(4);
+        {
+            auto [stat, opt_map] = optimizer.optimize(tp, 50ms, 5);
+            check(samples, stat);
+        }
+        {
+            samples.clear();
+            optimizer.clear();
+            auto [stat, opt_map] = optimizer.optimize_steady(tp, 50ms, 5);
+            check(samples, stat);
+        }
+        {// compact trace file, one line per sample after the header
+            auto path = std::filesystem::temp_directory_path() / "yadro_genetic_opt_telemetry_test.dat";
+            tmp_file_cleaner_t::add(path);
+            {
+                telemetry_trace<double> trace(path);
+                optimizer.set_telemetry(std::ref(trace), 5ms);
+                optimizer.clear();
+                optimizer.optimize(20ms, 5);
+                gbassert(!trace.best_targets().empty());
+                optimizer.set_telemetry(nullptr);
+
+                std::ifstream ifs(path);
+                std::size_t lines = 0;
+                for (std::string line; std::getline(ifs, line); ++lines);
+                gbassert(lines == trace.best_targets().size() + 1);
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, genetic_opt_adaptive_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+
+        {// the learning of two threads is merged into the shared state
+            using gb::yadro::algorithm::detail::adaptive_operators;
+            adaptive_operators shared;
+            shared.step(1);
+            auto first = shared, second = shared;
+            first.quality = { 0.2, 0., 0. };
+            first.steps = { 0.05, 0.1 };
+            second.quality = { 0., 0.3, 0. };
+            second.steps = { 0.1, 0.2, 0.4 };
+
+            auto base = shared;
+            shared.merge(first, base);
+            shared.merge(second, base);
+            gbassert(std::abs(shared.quality[0] - 0.2) < 1e-12 && std::abs(shared.quality[1] - 0.3) < 1e-12 && shared.quality[2] == 0);
+            gbassert(shared.steps.size() == 3);
+            gbassert(std::abs(shared.steps[0] - 0.05) < 1e-12 && std::abs(shared.steps[1] - 0.2) < 1e-12 && std::abs(shared.steps[2] - 0.4) < 1e-12);
+        }
+
+        // shifted sphere, the minimum is 0 at n = 3, v[i] = i / 10
+        genetic_optimization_t optimizer([](int n, const std::vector<double>& v)
+            {
+                auto sum = (n - 3.) * (n - 3.);
+                for (std::size_t i = 0; i < v.size(); ++i)
+                    sum += (v[i] - i / 10.) * (v[i] - i / 10.);
+                return sum;
+            },
+            std::tuple(-100, 100), std::tuple(std::vector<double>(10, -10.), std::vector<double>(10, 10.)));
+        optimizer.set_adaptive(true);
+
+        auto [stat, opt_map] = optimizer.optimize(100ms, 5);
+        gbassert(opt_map.size() == 5);
+#if defined(NDEBUG)
+        gbassert(opt_map.begin()->first < 0.01); // may fail on very slow machines
+#endif
+        const auto& state = optimizer.adaptive_state();
+        auto p = state.probabilities();
+        gbassert(std::abs(p[0] + p[1] + p[2] - 1) < 1e-9);
+        gbassert(std::ranges::all_of(p, [&](auto v) { return v >= state.min_probability - 1e-9; }));
+        gbassert(state.steps.size() == 11);
+        gbassert(std::ranges::any_of(state.steps, [&](auto step) { return step < state.initial_step; }));
+
+        {// steady state optimization learns the same state
+            gb::yadro::async::threadpool<> tp(4);
+            optimizer.clear();
+            gbassert(optimizer.adaptive_state().steps.empty());
+            auto [stat, opt_map] = optimizer.optimize_steady(tp, 50ms, 5);
+            gbassert(opt_map.size() == 5);
+            gbassert(!optimizer.adaptive_state().steps.empty());
+        }
+#if defined(GB_DEBUGGING)
+        std::cout << "\n" << stat << "\nprobabilities: " << p[0] << ", " << p[1] << ", " << p[2] << "\n";
+#endif
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, population_optimization_test, std::launch::async)
+    {
+        using namespace std::chrono_literals;
+
+        {// parameters are mapped to the unit hypercube
+            gb::yadro::algorithm::detail::unit_codec_t<int, double, std::vector<float>> codec{
+                { { 0, 10 }, { -1., 1. }, { std::vector{ 0.f, 0.f }, std::vector{ 2.f, 4.f } } } };
+            gbassert(codec.dimension() == 4);
+            auto x = codec.encode({ 5, 0.5, { 1.f, 1.f } });
+            gbassert((x == std::vector{ 0.5, 0.75, 0.5, 0.25 }));
+            gbassert(codec.decode(std::vector{ 0.26, 1.5, 0., 1. }) == std::tuple(3, 1., std::vector{ 0.f, 4.f }));
+        }
+
+        auto target = [](auto x, auto y, auto z, auto v)
+            { return x * x + y * y + std::exp(z) / 2 + std::exp(-z) / 2 - 1 + (v + std::sin(v)) * (v + std::sin(v)); };
+        auto check = [&](auto&& optimizer)
+            {
+                auto [stat, opt_map] = optimizer.optimize(1s, 5, 200);
+                gbassert(opt_map.size() == 5);
+                gbassert(stat.generation_count > 0 && stat.evaluation_count > stat.generation_count);
+#if defined(NDEBUG)
+                gbassert(opt_map.begin()->first < 0.01); // may fail on very slow machines
+#endif
+                // parallel evaluation continues from the same population
+                gb::yadro::async::threadpool<> tp;
+                auto [stat1, opt_map1] = optimizer.optimize(tp, 0.001, 1s, 5, 20);
+                gbassert(stat1.evaluation_count > 0);
+                gbassert(!opt_map.key_comp()(opt_map.begin()->first, opt_map1.begin()->first));
+
+                // save/load
+                auto state = [](auto&& opt) { gb::yadro::archive::omem_archive<> ma; ma(opt); return ma.get_stream().get_buffer(); };
+                auto path = std::filesystem::temp_directory_path() / "yadro_population_optimization_test.bin";
+                tmp_file_cleaner_t::add(path);
+                auto saved = state(optimizer);
+                optimizer.save(path);
+                optimizer.clear();
+                gbassert(optimizer.best_solutions(5).empty());
+                optimizer.load(path);
+                gbassert(state(optimizer) == saved);
+                gbassert(optimizer.best_solutions(5).size() == 5);
+            };
+
+        check(population_optimization_t(tournament_ga_t{}, target,
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.)));
+        check(population_optimization_t(differential_evolution_t{}, target,
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.)));
+        check(population_optimization_t(cma_es_t{}, target,
+            std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.)));
+
+        {// high dimensional problem, range parameter
+            population_optimization_t optimizer(cma_es_t{}, [](const std::vector<double>& x)
+                {
+                    auto sum = 0.;
+                    for (std::size_t i = 0; i < x.size(); ++i)
+                        sum += (i + 1) * (x[i] - 1) * (x[i] - 1);
+                    return sum;
+                },
+                std::tuple(std::vector(20, -5.), std::vector(20, 5.)));
+            auto [stat, opt_map] = optimizer.optimize(2s, 1, 2000);
+            gbassert(opt_map.size() == 1);
+#if defined(NDEBUG)
+            gbassert(opt_map.begin()->first < 1e-3); // may fail on very slow machines
+#endif
+        }
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, island_hub_test, std::launch::async)
+    {
+        island_hub_t<double, std::tuple<int, int>> hub(3);
+        gbassert(hub.exchange(0, { { 1., { 1, 1 } }, { 2., { 2, 2 } } }, 5).empty()); // no other islands yet
+
+        auto immigrants = hub.exchange(1, { { 0.5, { 3, 3 } }, { 1., { 1, 1 } } }, 5); // duplicate is ignored
+        gbassert(immigrants.size() == 2);
+        gbassert(immigrants[0] == std::tuple{ 1., std::tuple{ 1, 1 } });
+        gbassert(immigrants[1] == std::tuple{ 2., std::tuple{ 2, 2 } });
+
+        hub.exchange(1, { { 0.1, { 4, 4 } } }, 0); // the worst solution is dropped
+        auto best = hub.best(5);
+        gbassert(best.size() == 3);
+        gbassert(std::get<0>(best[0]) == 0.1 && std::get<0>(best[1]) == 0.5 && std::get<0>(best[2]) == 1.);
+        gbassert(hub.exchange(0, {}, 1) == std::vector{ std::tuple{ 0.1, std::tuple{ 4, 4 } } });
+    }
+
+    //--------------------------------------------------------------------------------------------
+    // islands in separate processes exchange solutions through the hub
+    GB_TEST(algorithm, island_optimization_test, std::launch::async)
+    {
+#if !defined(GBWINDOWS)
+        using namespace std::chrono_literals;
+        const std::string path = "/tmp/yadro_island_optimization_test";
+
+        auto target = [](auto x, auto y, auto z, auto v)
+            { return x * x + y * y + std::exp(z) / 2 + std::exp(-z) / 2 - 1 + (v + std::sin(v)) * (v + std::sin(v)); };
+        auto make_optimizer = [&]
+            {
+                return genetic_optimization_t(target, std::tuple(0u, 10u), std::tuple(-10LL, 10LL), std::tuple(-10.f, 10.f), std::tuple(-10., 10.));
+            };
+
+        island_hub_for<decltype(make_optimizer())> hub(10);
+        auto f = std::async(std::launch::async, [&] { hub.run(path); });
+
+        // each island is a thread with its own optimizer and hub connection, as a separate process would have
+        constexpr std::uint32_t islands = 3;
+        std::vector<std::future<bool>> workers;
+        for (std::uint32_t island = 0; island < islands; ++island)
+            workers.push_back(std::async(std::launch::async, [&, island]
+                {
+                    auto optimizer = make_optimizer();
+                    unix_socket_client_t hub_client(path, 500);
+                    auto [stat, opt_map] = optimize_island(optimizer, hub_client, island, 20ms, 5, 3, 5);
+                    return !opt_map.empty();
+                }));
+        for (auto&& w : workers)
+            gbassert(w.get());
+
+        {
+            unix_socket_client_t client(path, 50);
+            auto best = client.request<std::vector<std::tuple<double, std::tuple<unsigned, long long, float, double>>>>(island_best, std::size_t{ 5 });
+            gbassert(best && best->size() == 5);
+            gbassert(std::ranges::is_sorted(*best, std::less<>{}, [](auto&& s) { return std::get<0>(s); }));
+#if defined(NDEBUG)
+            gbassert(std::get<0>(best->front()) < 0.01); // may fail on very slow machines
+#endif
+        }
+        gbassert(shutdown_server(path, 10));
+        f.get();
+#endif
+    }
+
     //--------------------------------------------------------------------------------------------
     GB_TEST(algorithm, regression_test, std::launch::async)
     {
@@ -296,4 +759,90 @@ namespace
             gbassert(almost_equal(b, 1., 0.1));
         }
     }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, residual_sum_test, std::launch::async)
+    {
+        std::vector<std::tuple<double, double, int>> data;
+        for (int i = 0; i < 100'000; ++i)
+            data.emplace_back(std::sin(i / 1000.), i / 1000., i % 7);
+        auto fn = [](double x, int k) { return x / 100 + k * 0.01; };
+
+        auto r = residuals(fn, data);
+        auto squares = std::accumulate(r.begin(), r.end(), 0., [](auto sum, auto v) { return sum + v * v; });
+        auto abs_sum = std::accumulate(r.begin(), r.end(), 0., [](auto sum, auto v) { return sum + std::abs(v); });
+
+        auto soa = make_soa_data(data);
+        static_assert(std::same_as<decltype(soa), soa_data<double, double, int>>);
+        gbassert(soa.size() == data.size());
+
+        gb::yadro::async::threadpool<> tp(4);
+        for (auto sum : { residual_sum_of_squares(fn, data), residual_sum_of_squares(fn, soa), residual_sum_of_squares(fn, soa, tp, 1000) })
+            gbassert(almost_equal(sum, squares, 1e-9 * squares));
+        for (auto sum : { residual_sum_of_abs(fn, data), residual_sum_of_abs(fn, soa), residual_sum_of_abs(fn, soa, tp, 1000) })
+            gbassert(almost_equal(sum, abs_sum, 1e-9 * abs_sum));
+
+        // small data is reduced in the calling thread
+        std::vector<std::tuple<double, double, int>> small(data.begin(), data.begin() + 5);
+        gbassert(residual_sum_of_squares(fn, make_soa_data(small), tp) == residual_sum_of_squares(fn, make_soa_data(small)));
+    }
+
+    //--------------------------------------------------------------------------------------------
+    GB_TEST(algorithm, least_squares_test, std::launch::async)
+    {
+        // y = 1 + 2 * x - 0.5 * x^2 + 3 * sin(x)
+        std::vector<std::tuple<double, double>> data;
+        for (int i = 0; i < 50; ++i)
+        {
+            auto x = i / 5.;
+            data.emplace_back(1 + 2 * x - 0.5 * x * x + 3 * std::sin(x), x);
+        }
+        auto model = [](auto a, auto b, auto c, auto d) { return [=](auto x) { return a + b * x + c * x * x + d * std::sin(x); }; };
+
+        for (auto method : { least_squares_method::cholesky, least_squares_method::qr })
+        {
+            auto p = linear_least_squares<4>(model, data, method);
+            gbassert(almost_equal(p[0], 1., 1e-8) && almost_equal(p[1], 2., 1e-8));
+            gbassert(almost_equal(p[2], -0.5, 1e-8) && almost_equal(p[3], 3., 1e-8));
+        }
+
+        {// constant part of the model is not fitted
+            auto p = linear_least_squares<3>([](auto b, auto c, auto d) { return [=](auto x) { return 1 + b * x + c * x * x + d * std::sin(x); }; }, data);
+            gbassert(almost_equal(p[0], 2., 1e-8) && almost_equal(p[1], -0.5, 1e-8) && almost_equal(p[2], 3., 1e-8));
+        }
+
+        {// design matrix
+            gb::yadro::container::matrix<double> x(3, 2), y(3, 1);
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                x(i, 0) = 1;
+                x(i, 1) = static_cast<double>(i);
+                y(i, 0) = 2 + 3. * i;
+            }
+            for (auto method : { least_squares_method::cholesky, least_squares_method::qr })
+            {
+                auto p = linear_least_squares(x, y, method);
+                gbassert(p.rows() == 2 && almost_equal(p(0, 0), 2., 1e-10) && almost_equal(p(1, 0), 3., 1e-10));
+            }
+
+            // linearly dependent columns
+            for (std::size_t i = 0; i < 3; ++i)
+                x(i, 1) = 2;
+            must_throw([&] { linear_least_squares(x, y, least_squares_method::cholesky); });
+            must_throw([&] { linear_least_squares(x, y, least_squares_method::qr); });
+        }
+
+        {// nonlinear model y = 2 * exp(-0.5 * x) + 0.1
+            std::vector<std::tuple<double, double>> exp_data;
+            for (int i = 0; i < 30; ++i)
+                exp_data.emplace_back(2 * std::exp(-0.5 * i / 3.) + 0.1, i / 3.);
+
+            auto fit = levenberg_marquardt([](auto a, auto b, auto c) { return [=](auto x) { return a * std::exp(b * x) + c; }; },
+                exp_data, std::array{ 1., -0.1, 0. });
+            gbassert(fit.converged);
+            gbassert(fit.sum_of_squares < 1e-16);
+            gbassert(almost_equal(fit.parameters[0], 2., 1e-6) && almost_equal(fit.parameters[1], -0.5, 1e-6)
+                && almost_equal(fit.parameters[2], 0.1, 1e-6));
+        }
+    }
 }
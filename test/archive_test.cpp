@@ -28,7 +28,23 @@
 
 #include "../util/gbtest.h"
 #include "../archive/archive.h"
+#include "../archive/versioned.h"
+#include "../archive/compressed_stream.h"
+#include "../archive/parallel.h"
+#include "../archive/indexed.h"
+#include "../archive/polymorphic.h"
+#include "../util/gbmemory.h"
+#include "../util/misc.h"
 #include <sstream>
+#include <list>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <array>
 
 namespace
 {
@@ -239,4 +255,765 @@ namespace
                 std::string("Hello World"),
                 123, 3.14, 2.7f) == "2e44ca1b103d900c0d7d9c08b58e9194");
     }
-}
\ No newline at end of file
+
+    GB_TEST(yadro, omem_archive_reserve, std::launch::async)
+    {
+        std::vector<std::tuple<int, std::string, std::vector<double>>> v;
+        for (int i = 0; i < 100; ++i)
+            v.emplace_back(i, std::string(i, 'x'), std::vector<double>(i, i * 0.5));
+        std::map<int, std::string> m{ {1, "one"}, {2, "two"}, {3, "three"} };
+
+        // single allocation from the size pass
+        auto ma = make_omem_archive(v, m, 123);
+        auto size = serialization_size(v, m, 123);
+        gbassert(ma.get_stream().get_buffer().size() == size);
+        gbassert(ma.get_stream().get_buffer().capacity() >= size);
+
+        // the writes after reserve don't reallocate
+        omem_archive<> ma2;
+        ma2.get_stream().reserve(static_cast<std::size_t>(size));
+        auto data = ma2.get_stream().get_buffer().data();
+        ma2(v, m, 123);
+        gbassert(ma2.get_stream().get_buffer().data() == data);
+
+        // the same content as serialization without reservation
+        omem_archive<> ma1;
+        ma1(v, m, 123);
+        gbassert(ma1.get_stream().get_buffer() == ma.get_stream().get_buffer());
+
+        decltype(v) vv;
+        decltype(m) mm;
+        int i{};
+        imem_archive<> ia(std::move(ma));
+        ia(vv, mm, i);
+        gbassert(vv == v);
+        gbassert(mm == m);
+        gbassert(i == 123);
+    }
+}
+namespace
+{
+    // trivially copyable without padding and without serialize functions, detected as bitwise
+    struct point { std::int32_t x{}, y{}, z{}; auto operator<=>(const point&) const = default; };
+
+    // trivial, but its raw memory is an address
+    struct pointer_holder { int* p; };
+
+    // floating point values without padding are detected as well, member serialize writes
+    // the same bytes as the memory layout
+    struct sample
+    {
+        double t{}, v{};
+        auto operator<=>(const sample&) const = default;
+        void serialize(auto&& a) { a(t, v); }
+        void serialize(auto&& a) const { a(t, v); }
+    };
+
+    // padding bytes are never written as raw memory
+    struct padded { char c{}; std::int32_t i{}; };
+    struct padded_double { float f{}; double d{}; };
+}
+
+namespace
+{
+    GB_TEST(yadro, bitwise_serialization, std::launch::async)
+    {
+        static_assert(!std::is_trivial_v<point> && is_bitwise_v<omem_archive<>, point>);
+        static_assert(is_bitwise_v<omem_archive<>, sample>);
+        static_assert(!is_bitwise_v<omem_archive<>, padded> && !is_bitwise_v<omem_archive<>, padded_double>);
+        static_assert(!is_bitwise_v<omem_archive<>, std::tuple<int, double>>);
+        static_assert(is_bitwise_v<omem_archive<>, std::array<std::int32_t, 4>>);
+
+        // pointers and types holding them are never detected as bitwise
+        static_assert(!is_bitwise_v<omem_archive<>, std::string_view> && !is_serializable_v<omem_archive<>, std::string_view>);
+        static_assert(!is_bitwise_v<omem_archive<>, std::span<const int>>);
+        static_assert(!is_bitwise_v<omem_archive<>, pointer_holder> && !is_serializable_v<omem_archive<>, pointer_holder>);
+        static_assert(!is_bitwise_v<omem_archive<>, int*> && !is_trivial_sequence_v<std::vector<int*>>);
+
+        std::vector<point> vp(100);
+        for (std::size_t i = 0; i < vp.size(); ++i)
+            vp[i] = { int(i), 2 * int(i), 3 * int(i) };
+        std::vector<sample> vx(100);
+        for (std::size_t i = 0; i < vx.size(); ++i)
+            vx[i] = { i * 0.5, -1. * i };
+        std::array<point, 3> ap{ point{ 1, 2, 3 }, point{ 4, 5, 6 }, point{ 7, 8, 9 } };
+
+        omem_archive<> ma;
+        ma(vp, vx, ap);
+        gbassert(ma.get_stream().get_buffer().size() == 2 * sizeof(std::uint64_t) + 100 * (sizeof(point) + sizeof(sample)) + sizeof(ap));
+
+        // bulk write produces the same bytes as element by element serialization
+        omem_archive<> ml;
+        ml(std::list<point>(vp.begin(), vp.end()), std::list<sample>(vx.begin(), vx.end()), ap);
+        gbassert(ml.get_stream().get_buffer() == ma.get_stream().get_buffer());
+
+        std::vector<point> vp1;
+        std::vector<sample> vx1;
+        std::array<point, 3> ap1;
+        imem_archive<> ia(std::move(ma));
+        ia(vp1, vx1, ap1);
+        gbassert(vp1 == vp);
+        gbassert(vx1 == vx);
+        gbassert(ap1 == ap);
+    }
+}
+
+namespace
+{
+    // the same type in two schema versions
+    struct record_v1
+    {
+        static constexpr std::uint32_t serialization_version = 1;
+        int id{};
+        std::string name;
+        void serialize(auto&& a) { a(id, name); }
+    };
+
+    struct record_v2
+    {
+        static constexpr std::uint32_t serialization_version = 2;
+        int id{};
+        std::string name;
+        std::vector<double> values{ 1., 2. }; // added in version 2
+        void serialize(auto&& a) { a(id, name, values); }
+        void serialize(auto&& a, std::uint32_t version)
+        {
+            a(id, name);
+            if (version >= 2)
+                a(values);
+        }
+    };
+
+    // versioned object nested in a versioned object, sharing a pointer with the enclosing data
+    struct holder_v1
+    {
+        static constexpr std::uint32_t serialization_version = 1;
+        std::shared_ptr<std::string> p;
+        record_v1 r;
+        void serialize(auto&& a) { a(p, versioned(r)); }
+    };
+
+    struct holder_v2
+    {
+        static constexpr std::uint32_t serialization_version = 2;
+        std::shared_ptr<std::string> p;
+        record_v2 r;
+        int extra{};
+        void serialize(auto&& a) { a(p, versioned(r), extra); }
+    };
+
+    // string buffer of a stream that can't be positioned, like pipes and sockets
+    struct unseekable_buf : std::stringbuf
+    {
+        pos_type seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override { return pos_type(off_type(-1)); }
+        pos_type seekpos(pos_type, std::ios_base::openmode) override { return pos_type(off_type(-1)); }
+    };
+
+    GB_TEST(yadro, versioned_serialization, std::launch::async)
+    {
+        // header
+        omem_archive<> mh;
+        write_header(mh);
+        mh(123);
+        imem_archive<> ih(std::move(mh));
+        gbassert(read_header(ih) == archive_format_version);
+        omem_archive<> mn;
+        mn(123, 456);
+        imem_archive<> in(std::move(mn));
+        gbassert(!read_header(in));
+
+        // newer version is read by older reader, unknown trailing fields are skipped
+        omem_archive<> m2;
+        m2(versioned(record_v2{ 1, "two", { 3., 4., 5. } }), 777);
+        record_v1 r1;
+        int i{};
+        imem_archive<> i2(std::move(m2));
+        i2(versioned(r1), i);
+        gbassert(r1.id == 1 && r1.name == "two" && i == 777);
+
+        // older version is read by newer reader
+        omem_archive<> m1;
+        m1(versioned(record_v1{ 2, "one" }), 888);
+        record_v2 r2;
+        imem_archive<> i1(std::move(m1));
+        i1(versioned(r2), i);
+        gbassert(r2.id == 2 && r2.name == "one" && r2.values == std::vector{ 1., 2. } && i == 888);
+
+        // the same version is read directly
+        omem_archive<> m3;
+        m3(versioned(record_v2{ 3, "three", { 6. } }));
+        gbassert(m3.get_stream().get_buffer().size() == sizeof(std::uint32_t) + sizeof(std::uint64_t) 
+            + serialization_size(record_v2{ 3, "three", { 6. } }));
+        imem_archive<> i3(std::move(m3));
+        i3(versioned(r2));
+        gbassert(r2.id == 3 && r2.name == "three" && r2.values == std::vector{ 6. });
+
+        // the object is serialized once, the size prefix is patched in memory and seekable streams,
+        // other streams and compact archives buffer it, shared pointers are tracked across the nested objects
+        auto shared = std::make_shared<std::string>("shared");
+        holder_v2 h{ shared, record_v2{ 4, "four", { 7. } }, 99 };
+        auto check = [&](auto&& ia)
+        {
+            std::shared_ptr<std::string> shared1;
+            holder_v1 h1;
+            int i1{};
+            ia(shared1, versioned(h1), i1);
+            gbassert(shared1 && *shared1 == "shared" && h1.p == shared1);
+            gbassert(h1.r.id == 4 && h1.r.name == "four" && i1 == 555);
+        };
+
+        omem_archive<> mv;
+        mv(shared, versioned(h), 555);
+        gbassert(mv.get_stream().get_buffer().size() == serialization_size(shared, versioned(h), 555));
+        check(imem_archive<>(mv));
+
+        ocompact_archive<> cv;
+        cv(shared, versioned(h), 555);
+        gbassert(cv.get_stream().get_buffer().size() == serialization_size<archive_format_t::compact>(shared, versioned(h), 555));
+        check(icompact_archive<>(cv));
+
+        bin_archive<std::ostringstream> sv(std::ios::binary);
+        sv(shared, versioned(h), 555);
+        gbassert(sv.get_stream().str() == std::string(mv.get_stream().get_buffer().begin(), mv.get_stream().get_buffer().end()));
+        check(bin_archive<std::istringstream>(sv.get_stream().str(), std::ios::binary));
+
+        unseekable_buf ub;
+        std::ostream us(&ub);
+        archive<std::ostream&> uv(us);
+        uv(shared, versioned(h), 555);
+        gbassert(ub.str() == sv.get_stream().str());
+
+        // a huge size of a different version fails on the truncated stream, not on the allocation
+        archive<std::ostringstream, archive_format_t::custom> hv(std::ios::binary);
+        hv(serialization_version_v<record_v2>, std::uint64_t(1) << 40, 1, 2, 3);
+        std::istringstream hs(hv.get_stream().str(), std::ios::binary);
+        hs.exceptions(std::ios::failbit | std::ios::badbit);
+        archive<std::istringstream&, archive_format_t::custom> ihv(hs);
+        try
+        {
+            ihv(versioned(r1));
+            gbassert(!"truncated versioned object not detected");
+        }
+        catch (const std::ios_base::failure&) {}
+
+        // get returns the wrapped object, not a copy
+        const auto vr = versioned(record_v1{ 5, "five" });
+        static_assert(std::is_same_v<decltype(vr.get()), const record_v1&>);
+        gbassert(&vr.get() == &vr.get() && vr.get().id == 5);
+    }
+}
+
+namespace
+{
+    GB_TEST(yadro, compact_archive, std::launch::async)
+    {
+        using namespace gb::yadro::archive::detail;
+        static_assert(zigzag_encode(0) == 0 && zigzag_encode(-1) == 1 && zigzag_encode(1) == 2 && zigzag_encode(-2) == 3);
+        static_assert(zigzag_decode<int>(3) == -2 && zigzag_decode<std::int64_t>(zigzag_encode(INT64_MIN)) == INT64_MIN);
+
+        // small indices and short strings, as in graphs
+        std::vector<std::tuple<std::size_t, std::size_t, int>> edges;
+        std::vector<std::string> names;
+        for (int i = 0; i < 1000; ++i)
+        {
+            edges.emplace_back(i, i + 1, -i);
+            names.push_back("n" + std::to_string(i));
+        }
+        std::vector<std::int64_t> extremes{ INT64_MIN, INT64_MAX, 0, -1, 1 };
+        std::vector<std::uint16_t> shorts{ 0, 127, 128, 65535 };
+        enum class color_t : std::int32_t { red = -1, green = 1000 } color{ color_t::red };
+        std::map<int, double> m{ { -100, 1.5 }, { 100, 2.5 } };
+
+        ocompact_archive<> ca;
+        ca(edges, names, extremes, shorts, color, m);
+        omem_archive<> ma;
+        ma(edges, names, extremes, shorts, color, m);
+
+        auto compact_size = ca.get_stream().get_buffer().size();
+        gbassert(compact_size == serialization_size<archive_format_t::compact>(edges, names, extremes, shorts, color, m));
+        gbassert(ma.get_stream().get_buffer().size() == serialization_size(edges, names, extremes, shorts, color, m));
+        gbassert(compact_size * 3 < ma.get_stream().get_buffer().size());
+
+        decltype(edges) edges1;
+        decltype(names) names1;
+        decltype(extremes) extremes1;
+        decltype(shorts) shorts1;
+        color_t color1{};
+        decltype(m) m1;
+        icompact_archive<> ica(std::move(ca));
+        ica(edges1, names1, extremes1, shorts1, color1, m1);
+        gbassert(edges1 == edges);
+        gbassert(names1 == names);
+        gbassert(extremes1 == extremes);
+        gbassert(shorts1 == shorts);
+        gbassert(color1 == color);
+        gbassert(m1 == m);
+
+#if defined(GB_DEBUGGING)
+        // encoded size and throughput compared to custom format
+        auto bench = [&](auto oarchive, auto iarchive_type)
+        {
+            constexpr int n = 100;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i)
+            {
+                oarchive.get_stream().reset();
+                oarchive(edges, names);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            for (int i = 0; i < n; ++i)
+            {
+                typename decltype(iarchive_type)::type ia(oarchive.get_stream());
+                ia(edges1, names1);
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            auto size = oarchive.get_stream().get_buffer().size();
+            auto mbs = [&](auto dt) { return n * size / std::chrono::duration<double>(dt).count() / 1e6; };
+            std::cout << "size: " << size << ", write: " << mbs(t1 - t0) << " MB/s, read: " << mbs(t2 - t1) << " MB/s\n";
+        };
+        std::cout << "custom  "; bench(omem_archive<>{}, std::type_identity<imem_archive<>>{});
+        std::cout << "compact "; bench(ocompact_archive<>{}, std::type_identity<icompact_archive<>>{});
+#endif
+    }
+}
+
+namespace
+{
+    GB_TEST(yadro, compressed_stream, std::launch::async)
+    {
+        std::vector<std::tuple<int, std::string, double>> v;
+        for (int i = 0; i < 20000; ++i)
+            v.emplace_back(i, "value " + std::to_string(i % 100), i * 0.25);
+        std::vector<std::uint64_t> noise(10000);
+        std::mt19937_64 gen(12345);
+        for (auto& n : noise)
+            n = gen();
+
+        auto round_trip = [&](compression_options opt, gb::yadro::async::threadpool<>* pool)
+        {
+            ocompressed_archive<omem_stream<std::vector<char>>> oa(opt);
+            oa(v, noise);
+            oa.get_stream().finish();
+            auto buf = oa.get_stream().get_stream().get_buffer();
+
+            decltype(v) v1;
+            decltype(noise) noise1;
+            icompressed_archive<imem_stream<std::vector<char>>> ia(std::move(oa.get_stream().get_stream()), pool);
+            ia(v1, noise1);
+            gbassert(v1 == v);
+            gbassert(noise1 == noise);
+            return buf;
+        };
+
+        // compressed data is smaller, incompressible blocks are stored as is
+        auto buf = round_trip({}, nullptr);
+        gbassert(buf.size() < serialization_size(v) / 2 + serialization_size(noise) + 100);
+
+        // small blocks without checksums, compressed and decompressed in parallel
+        gb::yadro::async::threadpool<> tp(4);
+        round_trip({ .block_size = 1000, .checksum = false, .pool = &tp }, &tp);
+
+        // the same output with parallel compression
+        gbassert(round_trip({ .pool = &tp }, &tp) == buf);
+
+        // ostream/istream
+        std::ostringstream os;
+        {
+            ocompressed_archive<std::ostringstream&> oa(os);
+            oa(v);
+        }
+        decltype(v) v1;
+        std::istringstream is(os.str());
+        icompressed_archive<std::istringstream&> ia(is);
+        ia(v1);
+        gbassert(v1 == v);
+
+        // corrupted data is detected by checksum or decoder
+        auto corrupted = os.str();
+        corrupted[corrupted.size() / 2] ^= 0x55;
+        std::istringstream cis(corrupted);
+        icompressed_archive<std::istringstream&> cia(cis);
+        try
+        {
+            cia(v1);
+            gbassert(!"corruption not detected");
+        }
+        catch (const compression_error&) {}
+
+        // block sizes larger than the block size of the stream are rejected before allocation
+        auto check_invalid = [](std::string data)
+        {
+            try
+            {
+                std::istringstream is(data);
+                icompressed_archive<std::istringstream&> ia(is);
+                std::vector<std::tuple<int, std::string, double>> v1;
+                ia(v1);
+                gbassert(!"invalid block size not detected");
+            }
+            catch (const compression_error&) {}
+        };
+        auto set_u32 = [](std::string data, std::size_t pos, std::uint32_t value)
+        {
+            std::memcpy(data.data() + pos, &value, sizeof(value));
+            return data;
+        };
+        constexpr std::size_t header_size = 3 * sizeof(std::uint32_t);
+        check_invalid(set_u32(os.str(), 2 * sizeof(std::uint32_t), 0));
+        check_invalid(set_u32(os.str(), header_size, 0x7fffffff));
+        check_invalid(set_u32(os.str(), header_size + sizeof(std::uint32_t), 0x7fffffff));
+        check_invalid(set_u32(os.str(), header_size + sizeof(std::uint32_t), 0xffffffff));
+    }
+}
+
+namespace
+{
+    GB_TEST(yadro, parallel_serialization, std::launch::async)
+    {
+        std::vector<std::string> vs;
+        std::deque<std::tuple<int, std::string>> dq;
+        std::list<double> lst;
+        std::multimap<double, std::tuple<int, std::string>> mm;
+        std::vector<int> vi(12345);
+        for (int i = 0; i < 10000; ++i)
+        {
+            vs.push_back(std::to_string(i));
+            dq.emplace_back(i, std::to_string(-i));
+            lst.push_back(i * 0.5);
+            mm.emplace(i % 100 * 0.1, std::tuple{ i, std::to_string(i) });
+        }
+        std::iota(vi.begin(), vi.end(), 0);
+        std::vector<int> empty;
+
+        gb::yadro::async::threadpool<> tp(4);
+        omem_archive<> ma;
+        ma(parallel(vs, tp), parallel(dq, tp, 3), parallel(lst, tp), parallel(mm, tp), parallel(vi, tp, 7), parallel(empty, tp));
+
+        decltype(vs) vs1;
+        decltype(dq) dq1;
+        decltype(lst) lst1;
+        decltype(mm) mm1;
+        decltype(vi) vi1;
+        decltype(empty) empty1{ 1, 2 };
+        imem_archive<> ia(std::move(ma));
+        ia(parallel(vs1, tp), parallel(dq1, tp), parallel(lst1, tp), parallel(mm1, tp), parallel(vi1, tp), parallel(empty1, tp));
+        gbassert(vs1 == vs);
+        gbassert(dq1 == dq);
+        gbassert(lst1 == lst);
+        gbassert(mm1 == mm);
+        gbassert(vi1 == vi);
+        gbassert(empty1.empty());
+
+        // compact chunks
+        ocompact_archive<> ca;
+        ca(parallel(vi, tp));
+        icompact_archive<> ica(std::move(ca));
+        vi1.clear();
+        ica(parallel(vi1, tp));
+        gbassert(vi1 == vi);
+
+        // corrupted headers: element count, chunk count, {element count, size in bytes} of every chunk, chunk data
+        auto corrupted = [&](std::vector<std::uint64_t> header, auto container)
+            {
+                omem_archive<> ba;
+                for (auto h : header)
+                    ba(h);
+                ba(std::vector<char>(16));
+                imem_archive<> iba(std::move(ba));
+                try
+                {
+                    iba(parallel(container, tp));
+                    gbassert(!"corrupted parallel archive not detected");
+                }
+                catch (const invalid_archive&) {}
+            };
+        corrupted({ 2, 0 }, std::vector<int>{});                      // no chunks
+        corrupted({ 2, 3, 1, 4, 1, 4, 0, 0 }, std::vector<int>{});    // more chunks than elements
+        corrupted({ 3, 2, 1, 4, 1, 4 }, std::vector<int>{});          // counts don't add up to size
+        corrupted({ 2, 1, 2, 1 }, std::vector<int>{});                // more elements than bytes
+        corrupted({ 1, 1, 1, 8 }, std::vector<int>{});                // chunk not consumed
+        corrupted({ 1, 1, 1, 8 }, std::list<int>{});
+        corrupted({ 2, 1, 2, 8 }, std::array<int, 3>{});              // fixed size mismatch
+    }
+}
+
+namespace
+{
+    GB_TEST(yadro, indexed_archive, std::launch::async)
+    {
+        std::vector<double> matrix(100000);
+        std::iota(matrix.begin(), matrix.end(), 0.5);
+        std::map<std::string, int> names{ { "one", 1 }, { "two", 2 } };
+        std::string comment = "checkpoint";
+
+        auto path = std::filesystem::temp_directory_path() / "yadro_indexed_archive.bin";
+        tmp_file_cleaner_t::add(path);
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            oindexed_archive<std::ofstream&> oa(ofs);
+            oa(123, matrix, names);
+            gbassert(oa.add(comment) == 3);
+        }
+
+        {
+            auto ia = iindexed_archive::open(path);
+            gbassert(ia.size() == 4);
+            gbassert(ia.object_data(1).size() == serialization_size(matrix));
+
+            // objects are read in any order
+            gbassert(ia.get<std::string>(3) == comment);
+            gbassert(ia.get<std::map<std::string, int>>(2) == names);
+            gbassert(ia.get<int>(0) == 123);
+
+            auto lazy_matrix = ia.get_lazy<std::vector<double>>(1);
+            gbassert(!lazy_matrix.is_loaded());
+            gbassert(lazy_matrix->size() == matrix.size());
+            gbassert(lazy_matrix.is_loaded());
+            gbassert(*lazy_matrix == matrix);
+        }
+
+        // compact format in memory
+        std::vector<char> buf;
+        {
+            oindexed_archive<omem_stream<std::vector<char>>, archive_format_t::compact> oa;
+            oa(names, std::vector<int>{ 1, -2, 300 }, comment);
+            oa.finish();
+            buf = oa.get_stream().get_buffer();
+        }
+        iindexed_archive ia(std::move(buf));
+        gbassert(ia.format() == archive_format_t::compact);
+        gbassert((ia.get<std::vector<int>>(1) == std::vector<int>{ 1, -2, 300 }));
+        gbassert(ia.get<std::string>(2) == comment);
+
+        // empty archive
+        oindexed_archive<omem_stream<std::vector<char>>> oe;
+        oe.finish();
+        auto empty_buf = oe.get_stream().get_buffer();
+        gbassert(iindexed_archive(std::span<const char>(empty_buf)).size() == 0);
+
+        // not an indexed archive
+        try
+        {
+            iindexed_archive bad(std::vector<char>(100, 'x'));
+            gbassert(!"invalid archive not detected");
+        }
+        catch (const invalid_archive&) {}
+
+        // corrupted footer: the object count overflows or the index isn't a whole number of offsets
+        auto corrupt_footer = [](std::vector<char> bad, std::uint64_t count, std::int64_t index_shift)
+        {
+            auto footer = bad.size() - 2 * sizeof(std::uint64_t) - sizeof(std::uint32_t);
+            auto index_pos = footer + index_shift;
+            std::memcpy(bad.data() + footer, &count, sizeof(count));
+            std::memcpy(bad.data() + footer + sizeof(count), &index_pos, sizeof(index_pos));
+            try
+            {
+                iindexed_archive ia(std::move(bad));
+                gbassert(!"corrupted index not detected");
+            }
+            catch (const invalid_archive&) {}
+        };
+        corrupt_footer(empty_buf, std::numeric_limits<std::uint64_t>::max(), 0);
+        oindexed_archive<omem_stream<std::vector<char>>> o1;
+        o1(1);
+        o1.finish();
+        corrupt_footer(o1.get_stream().get_buffer(), 0, -static_cast<std::int64_t>(sizeof(std::uint64_t) + 1));
+    }
+}
+
+namespace
+{
+    GB_TEST(yadro, serialization_hashing, std::launch::async)
+    {
+        std::vector<std::tuple<int, std::string, std::vector<double>>> objects;
+        for (int i = 0; i < 50; ++i)
+            objects.emplace_back(i, std::string(i * 3, 'x'), std::vector<double>(i, 0.5 * i));
+
+        // buffered md5 stream gives the same md5 as md5 of serialized data
+        omem_archive<std::vector<std::uint8_t>> ma;
+        ma(objects);
+        gbassert(serialization_md5(objects) == md5string(ma.get_stream().get_buffer()));
+
+        // multi-buffer md5 of many objects
+        auto md5s = serialization_md5_many(objects);
+        gbassert(md5s.size() == objects.size());
+        for (std::size_t i = 0; i < objects.size(); ++i)
+            gbassert(md5s[i] == serialization_md5(objects[i]));
+
+        // fast 128-bit hash
+        auto h = serialization_hash(objects);
+        gbassert(h.size() == 32);
+        gbassert(h == hash128string(ma.get_stream().get_buffer()));
+        std::get<2>(objects[10])[3] = 0.25;
+        gbassert(serialization_hash(objects) != h);
+    }
+}
+
+namespace
+{
+    GB_TEST(yadro, text_archive_round_trip, std::launch::async)
+    {
+        enum class enum_type { one = 1, two };
+        std::string s{ " spaces and\nnew lines\t" };
+        std::vector<double> vd{ 0.1, 1.0 / 3, -2.5e300, 1e-300, std::numeric_limits<double>::infinity() };
+        std::vector<std::uint8_t> bytes{ 0, 10, 32, 255 };
+        std::vector<int> vi{ 1, -2, 3 };
+        float f{ 0.1f };
+
+        text_archive<std::ostringstream> oarch;
+        oarch(s, vd, bytes, vi, f, true, std::string(), 'x', std::optional<int>(7), enum_type::two);
+        gbassert(oarch.get_stream().str().starts_with("22\n spaces and\nnew lines\t\n5\n0.1 0.3333333333333333 -2.5e+300 1e-300 inf\n"));
+
+        text_archive<std::istringstream> iarch{ oarch.get_stream().str() };
+        std::string s1, empty{ "not empty" };
+        std::vector<double> vd1;
+        std::vector<std::uint8_t> bytes1;
+        std::vector<int> vi1;
+        float f1{};
+        bool b1{};
+        char c{};
+        std::optional<int> opt;
+        enum_type e{};
+        iarch(s1, vd1, bytes1, vi1, f1, b1, empty, c, opt, e);
+        gbassert(s1 == s);
+        gbassert(vd1 == vd);
+        gbassert(bytes1 == bytes);
+        gbassert(vi1 == vi);
+        gbassert(f1 == f);
+        gbassert(b1);
+        gbassert(empty.empty());
+        gbassert(c == 'x');
+        gbassert(opt == 7);
+        gbassert(e == enum_type::two);
+
+        try
+        {
+            text_archive<std::istringstream> bad{ std::string("12x\n") };
+            int i{};
+            bad(i);
+            gbassert(false);
+        }
+        catch (const std::runtime_error&) {}
+    }
+}
+
+namespace
+{
+    struct shape
+    {
+        int id{};
+        shape() = default;
+        explicit shape(int id) : id(id) {}
+        virtual ~shape() = default;
+        virtual double area() const = 0;
+        template<class Ar> void serialize(Ar& a) { a(id); }
+        template<class Ar> void serialize(Ar& a) const { a(id); }
+    };
+
+    struct circle : shape
+    {
+        double r{};
+        circle() = default;
+        circle(int id, double r) : shape(id), r(r) {}
+        double area() const override { return 3.14159 * r * r; }
+        template<class Ar> void serialize(Ar& a) { a(static_cast<shape&>(*this), r); }
+        template<class Ar> void serialize(Ar& a) const { a(static_cast<const shape&>(*this), r); }
+    };
+
+    struct square : shape
+    {
+        double side{};
+        std::vector<std::shared_ptr<shape>> children;
+        square() = default;
+        square(int id, double side) : shape(id), side(side) {}
+        double area() const override { return side * side; }
+        template<class Ar> void serialize(Ar& a) { a(static_cast<shape&>(*this), side, children); }
+        template<class Ar> void serialize(Ar& a) const { a(static_cast<const shape&>(*this), side, children); }
+    };
+
+    struct triangle : shape
+    {
+        double area() const override { return 0; }
+    };
+}
+
+template<>
+struct gb::yadro::archive::polymorphic_types<shape> { using types = std::tuple<circle, square>; };
+
+namespace
+{
+    GB_TEST(yadro, polymorphic_serialization, std::launch::async)
+    {
+        std::vector<std::unique_ptr<shape>> shapes;
+        shapes.push_back(create_unique<shape, circle>(1, 2.0));
+        shapes.push_back(nullptr);
+        shapes.push_back(create_unique<shape, square>(2, 3.0));
+        auto shared_circle = std::make_shared<circle>(3, 1.0);
+        auto shared_square = std::make_shared<square>(4, 5.0);
+        std::shared_ptr<shape> shared_shape = shared_circle;
+        shared_square->children = { shared_shape, shared_shape, nullptr };
+        auto plain = std::make_unique<std::string>("not polymorphic");
+        std::unique_ptr<int> null_int;
+
+        auto write = [&](auto& ar) { ar(shapes, shared_shape, shared_square, std::shared_ptr<shape>(shared_square), plain, null_int); };
+        auto check = [&](auto& ar)
+        {
+            std::vector<std::unique_ptr<shape>> shapes1;
+            std::shared_ptr<shape> shared_shape1, shared_square_base1;
+            std::shared_ptr<square> shared_square1;
+            std::unique_ptr<std::string> plain1;
+            auto null_int1 = std::make_unique<int>(1);
+            ar(shapes1, shared_shape1, shared_square1, shared_square_base1, plain1, null_int1);
+
+            gbassert(shapes1.size() == 3);
+            gbassert(dynamic_cast<circle*>(shapes1[0].get()) && shapes1[0]->id == 1 && shapes1[0]->area() == shapes[0]->area());
+            gbassert(!shapes1[1]);
+            gbassert(dynamic_cast<square*>(shapes1[2].get()) && shapes1[2]->id == 2 && shapes1[2]->area() == 9.0);
+            // shared objects are restored shared
+            gbassert(shared_square1->children.size() == 3);
+            gbassert(shared_square1->children[0] == shared_shape1);
+            gbassert(shared_square1->children[1] == shared_shape1);
+            gbassert(!shared_square1->children[2]);
+            gbassert(shared_shape1->id == 3 && dynamic_cast<circle*>(shared_shape1.get()));
+            // the same object through a different pointer type is a separate object
+            gbassert(shared_square_base1 && shared_square_base1->id == 4 && shared_square_base1.get() != shared_square1.get());
+            gbassert(plain1 && *plain1 == "not polymorphic");
+            gbassert(!null_int1);
+        };
+
+        omem_archive<> ma;
+        write(ma);
+        imem_archive<> ia(ma);
+        check(ia);
+
+        ocompact_archive<> oca;
+        write(oca);
+        icompact_archive<> ica(oca);
+        check(ica);
+
+        // the object shared by several pointers is written once
+        std::shared_ptr<shape> one = std::make_shared<circle>(5, 1.0);
+        gbassert(serialization_size(one, one, one) < 2 * serialization_size(one));
+
+        // archives stay copyable, a copy continues with its own copy of the shared objects
+        omem_archive<> mo;
+        mo(one);
+        const auto& cmo = mo;
+        auto mo1 = cmo;
+        mo(one);
+        mo1(one);
+        gbassert(mo1.get_stream().get_buffer() == mo.get_stream().get_buffer());
+        imem_archive<> io(mo1);
+        std::shared_ptr<shape> one1, one2;
+        io(one1, one2);
+        gbassert(one1 && one1 == one2 && one1->id == 5);
+
+        try
+        {
+            omem_archive<> bad;
+            bad(std::unique_ptr<shape>(std::make_unique<triangle>()));
+            gbassert(false);
+        }
+        catch (const polymorphic_error&) {}
+    }
+}
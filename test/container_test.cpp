@@ -281,4 +281,44 @@ namespace
         gbassert(matrix<int, 2, 2>{2, 0, 0, 2} == 2 * identity_matrix<int>(2));
         gbassert(matrix<int, 2, 2>{2, 0, 0, 2} / 2 == identity_matrix<int>(2));
     }
+
+    GB_TEST(yadro, matrix_decomposition_test)
+    {
+        using namespace tensor_operators;
+
+        matrix<double, 3, 3> m{
+            4, 1, 2,
+            1, 3, 0,
+            2, 0, 5
+        };
+        auto [eigenvalues, eigenvectors] = symmetric_eigen(m);
+        gbassert(eigenvalues.size() == 3 && eigenvectors.rows() == 3 && eigenvectors.columns() == 3);
+        gbassert(almost_equal(transpose(eigenvectors) * eigenvectors, identity_matrix<double>(3), 1e-12));
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            auto v = get_column(eigenvectors, i);
+            gbassert(almost_equal(m * v, v * eigenvalues[i], 1e-10));
+        }
+        gbassert(almost_equal(eigenvalues[0] + eigenvalues[1] + eigenvalues[2], 12., 1e-12));
+
+        // positive definite system, the same solution as the gaussian elimination
+        auto rh = column_t<double, 3>{ 1, 2, 3 };
+        gbassert(almost_equal(cholesky_solve(m, rh).data(), solve(m, rh).data(), 1e-12));
+        must_throw([] { cholesky_solve(matrix<double, 2, 2>{ 1, 2, 2, 1 }, column_t<double, 2>{ 1, 1 }); });
+
+        // overdetermined system y = 2 + 3 * x, the least squares solution is exact
+        matrix<double> x(4, 2), y(4, 1);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            x(i, 0) = 1;
+            x(i, 1) = static_cast<double>(i);
+            y(i, 0) = 2 + 3. * i;
+        }
+        auto p = qr_solve(x, y);
+        gbassert(p.rows() == 2 && p.columns() == 1);
+        gbassert(almost_equal(p(0, 0), 2., 1e-12) && almost_equal(p(1, 0), 3., 1e-12));
+        for (std::size_t i = 0; i < 4; ++i)
+            x(i, 1) = 2;
+        must_throw([&] { qr_solve(x, y); });
+    }
 }
@@ -33,6 +33,7 @@
 #include "../container/static_vector.h"
 #include "../container/tree.h"
 #include "../archive/archive.h"
+#include "../archive/versioned.h"
 #include <vector>
 
 namespace
@@ -133,5 +134,36 @@ edges 7:
         imem_archive ima(std::move(ma));
         graph<int> g1(ima);
         gbassert(g == g1);
+
+        // edges and nodes without padding are serialized in bulk, the format doesn't change
+        static_assert(is_bitwise_serializable_v<edge<void>> && is_bitwise_serializable_v<node<double>>);
+        static_assert(!is_bitwise_serializable_v<node<int>> || sizeof(node<int>) == sizeof(int) + 2 * sizeof(index_t));
+        gbassert(serialization_size(g) == 2 * sizeof(std::uint64_t) + 7 * 4 * sizeof(index_t) + 5 * (sizeof(int) + 2 * sizeof(index_t)));
+
+        graph<double, double> g2(3, 0.5);
+        g2.add_edge(0, 1, 1.5);
+        g2.add_edge(1, 2, 2.5);
+        omem_archive<> ma2;
+        ma2(g2);
+        imem_archive ima2(std::move(ma2));
+        graph<double, double> g3(ima2);
+        gbassert(g2 == g3);
+
+        // versioned graph
+        omem_archive<> ma3;
+        ma3(versioned(g));
+        imem_archive ima3(std::move(ma3));
+        graph<int> g4;
+        ima3(versioned(g4));
+        gbassert(g == g4);
+
+        // parallel serialization
+        gb::yadro::async::threadpool<> tp(4);
+        omem_archive<> ma4;
+        g.serialize(ma4, tp);
+        imem_archive ima4(std::move(ma4));
+        graph<int> g5;
+        g5.serialize(ima4, tp);
+        gbassert(g == g5);
     }
 }
@@ -35,6 +35,13 @@
 #include <vector>
 #include <deque>
 #include <future>
+#include <limits>
+
+#if !defined(GBWINDOWS)
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -336,6 +343,36 @@ unset multiplot)*";
         gbassert(md5digest("2024/07/08") != md5digest("2024/7/8"));
         gbassert(md5string("2024/07/08", "2024/7/8") == "500faf436e1f15bbac22a95b1e896b02");
         gbassert(base64_encode(md5digest("2024/07/08")) == "8kE1D2bSTvuHIONFtGLF/A==");
+
+        // multi-buffer MD5 matches MD5 of every message, lengths around padding boundaries
+        std::vector<std::string> messages;
+        for (auto size : { 0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 3, 4096, 17 })
+            messages.push_back(std::string(size, static_cast<char>('a' + size % 26)));
+        std::vector<std::span<const std::uint8_t>> spans;
+        for (auto&& m : messages)
+            spans.emplace_back(reinterpret_cast<const std::uint8_t*>(m.data()), m.size());
+        auto digests = md5_many(spans);
+        gbassert(digests.size() == messages.size());
+        for (std::size_t i = 0; i < messages.size(); ++i)
+            gbassert(digests[i] == md5digest(messages[i]));
+        gbassert(md5_many({}).empty());
+
+        // 128-bit hash doesn't depend on how the data are split in updates
+        std::string text(5000, 0);
+        for (std::size_t i = 0; i < text.size(); ++i)
+            text[i] = static_cast<char>(i * 7 + i / 13);
+        auto h = hash128string(text);
+        gbassert(h.size() == 32);
+        hash128 h1;
+        for (std::size_t i = 0; i < text.size(); i += 37)
+            h1.update(std::string_view(text).substr(i, 37));
+        gbassert(h1.finalize().to_string() == h);
+        gbassert(hash128string("") != hash128string(std::string(1, '\0')));
+        gbassert(hash128string("abc") != hash128string("abd"));
+        auto swapped = text;
+        std::swap_ranges(swapped.begin(), swapped.begin() + 64, swapped.begin() + 64);
+        gbassert(hash128string(swapped) != h);
+        gbassert(to_hex(std::array<std::uint8_t, 3>{ 0x01, 0xab, 0xff }) == "01abff");
     }
 
     GB_TEST(util, win_pipe1)
@@ -587,4 +624,424 @@ unset multiplot)*";
         gbassert(shutdown_server(L"\\\\.\\pipe\\yadro\\pipe", 10));
 #endif
     }
+
+    GB_TEST(util, unix_socket)
+    {
+        using namespace std::chrono_literals;
+#if !defined(GBWINDOWS)
+        // functions invoked by index, epoll server dispatching to threadpool
+        const std::string path = "/tmp/yadro_unix_socket_test";
+        auto f = std::async(std::launch::async, [&]
+            {
+                gb::yadro::async::threadpool<> tp(4);
+                start_server(tp, path, nullptr,
+                    [](int) {},
+                    [](const std::vector<int>& v) { return v; }, // echo vector
+                    [](int i1, int i2, int i3) { return std::array{ i1, i2, i3 }; },
+                    [] {},
+                    [] { return 1; },
+                    [](int i) { if (i < 0) throw std::runtime_error("negative"); return i; }
+                    );
+            });
+        {   // single client
+            unix_socket_client_t client(path, 50);
+            gbassert(client.request<void>(0, 1));
+            gbassert(client.request<std::array<int, 3>>(2, 1, 2, 3).value() == std::array{ 1,2,3 });
+            gbassert(client.request<void>(3));
+            gbassert(client.request<int>(4) == 1);
+            gbassert(client.request<5, int>(7) == 7);
+            gbassert(client.request<5, int>(-1).error() == "negative");
+            std::vector<int> vec(1'000'000, 0);
+            vec[0] = 1; vec[1] = 2; vec[3] = 3; vec[4] = 4; vec[5] = 5; vec.back() = 12345;
+            gbassert(client.request<std::vector<int>>(1, vec).value() == vec);
+            client.disconnect();
+        }
+        {   // two clients, overlapping requests
+            unix_socket_client_t client(path, "first client", 5);
+            gbassert(client.request<void>(0, 1));
+            unix_socket_client_t client1(path, "second client", 5);
+            gbassert(client.request<std::array<int, 3>>(2, 1, 2, 3).value() == std::array{ 1,2,3 });
+            client.disconnect();
+            gbassert(client1.request<void>(0, 1));
+            gbassert(client1.request<std::array<int, 3>>(2, 1, 2, 3).value() == std::array{ 1,2,3 });
+        }
+        {   // many clients, concurrent access
+            auto make_client = [&](const char* name)
+                {
+                    return std::async(std::launch::async, [&, name]
+                        {
+                            unix_socket_client_t client(path, name, 5);
+                            for (auto i = 0; i < 5; ++i)
+                            {
+                                std::vector<int> vec(100'000, 0);
+                                vec[0] = i; vec[1] = i + 1; vec.back() = 12345;
+                                gbassert(client.request<1, std::vector<int>>(vec).value() == vec);
+                                gbassert(client.request<4, int>() == 1);
+                            }
+                        }).share();
+                };
+
+            std::vector futures{ make_client("one"), make_client("two"), make_client("three"), make_client("four"),
+                make_client("five"), make_client("six"), make_client("seven"), make_client("eight") };
+            for (auto&& fut : futures)
+                fut.get();
+        }
+
+        gbassert(shutdown_server(path, 10));
+        f.get();
+#endif
+    }
+
+    GB_TEST(util, unix_socket_named)
+    {
+        using namespace std::chrono_literals;
+#if !defined(GBWINDOWS)
+        // functions invoked by name
+        const std::string path = "/tmp/yadro_unix_socket_named_test";
+        auto f = std::async(std::launch::async, [&]
+            {
+                start_server(path, nullptr,
+                    std::tuple{ "zero", [](int) {} },
+                    std::tuple{ "one", [](const std::vector<int>& v) { return v; } }, // echo vector
+                    std::tuple{ "two", [](int i1, int i2, int i3) { return std::array{ i1, i2, i3 }; } },
+                    std::tuple{ "three", [] {} },
+                    std::tuple{ "four", [] { return 1; } }
+                    );
+            });
+        {
+            unix_socket_client_t client(path, 50);
+            gbassert(client.request<void>("zero", 1));
+            gbassert(client.request<std::array<int, 3>>("two", 1, 2, 3).value() == std::array{ 1,2,3 });
+            gbassert(client.request<void>("three"));
+            gbassert(client.request<int>("four") == 1);
+            std::vector<int> vec(1'000'000, 0);
+            vec[0] = 1; vec.back() = 12345;
+            gbassert(client.request<std::vector<int>>("one", vec).value() == vec);
+            gbassert(!client.request<int>("five"));
+        }
+
+        // the server is running, starting another one must fail
+        gbassert(is_server_running(path));
+        must_throw([&] { unix_socket_server_t server(path); });
+        gbassert(shutdown_server(path, 10));
+        f.get();
+        // shutting down server multiple times should succeed
+        gbassert(shutdown_server(path, 10));
+#endif
+    }
+
+    GB_TEST(util, unix_socket_stalled_client)
+    {
+        using namespace std::chrono_literals;
+#if !defined(GBWINDOWS)
+        // any bind failure is reported, not only the address in use
+        must_throw([&] { unix_socket_server_t server("/tmp/yadro_no_such_dir/socket"); });
+
+        // the socket is closed and removed if the epoll setup fails, the descriptor limit leaves room for the socket only
+        {
+            const std::string failed_path = "/tmp/yadro_unix_socket_epoll_test";
+            auto next_fd = ::dup(0);
+            ::close(next_fd);
+            auto next_open = ::fcntl(next_fd + 1, F_GETFD) != -1;
+            rlimit limit{};
+            gbassert(::getrlimit(RLIMIT_NOFILE, &limit) == 0);
+            auto lowered = limit;
+            lowered.rlim_cur = next_fd + 2;
+            gbassert(::setrlimit(RLIMIT_NOFILE, &lowered) == 0);
+            auto failed = false;
+            try
+            {
+                unix_socket_server_t server(failed_path);
+            }
+            catch (const std::exception&)
+            {
+                failed = true;
+            }
+            gbassert(::setrlimit(RLIMIT_NOFILE, &limit) == 0);
+            gbassert(failed && ::access(failed_path.c_str(), F_OK) != 0);
+            auto fd = ::dup(0);
+            ::close(fd);
+            gbassert(fd == next_fd && (::fcntl(next_fd + 1, F_GETFD) != -1) == next_open);
+        }
+
+        // a client that stops in the middle of a message doesn't hold the only serving thread forever
+        const std::string path = "/tmp/yadro_unix_socket_stalled_test";
+        unix_socket_server_t server(path);
+        server.set_receive_timeout(200ms);
+        auto f = std::async(std::launch::async, [&]
+            {
+                gb::yadro::async::threadpool<> tp(1);
+                server.run(tp, [](int i) { return i * i; });
+            });
+
+        auto address = sockaddr_un{ .sun_family = AF_UNIX };
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        gbassert(fd != -1 && ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+        std::uint16_t half_call_id = 0;
+        gbassert(::send(fd, &half_call_id, sizeof(half_call_id), MSG_NOSIGNAL) == sizeof(half_call_id));
+        std::this_thread::sleep_for(50ms); // the serving thread is blocked on the partial message
+
+        {
+            unix_socket_client_t client(path, 50);
+            gbassert(client.request<0, int>(3) == 9);
+        }
+        ::close(fd);
+
+        gbassert(shutdown_server(path, 10));
+        f.get();
+#endif
+    }
+
+    GB_TEST(util, unix_socket_async)
+    {
+        using namespace std::chrono_literals;
+#if !defined(GBWINDOWS)
+        // pipelined and batched requests
+        const std::string path = "/tmp/yadro_unix_socket_async_test";
+        auto f = std::async(std::launch::async, [&]
+            {
+                gb::yadro::async::threadpool<> tp(4);
+                start_server(tp, path, nullptr,
+                    [](int i) { return i * i; },
+                    [](int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); return ms; },
+                    [](const std::vector<int>& v, int i) { return v.size() + i; },
+                    [](int i) { if (i < 0) throw std::runtime_error("negative"); return i; }
+                    );
+            });
+        {   // the fast request overtakes the slow one
+            unix_socket_client_t client(path, 50);
+            auto slow = client.request_async<int>(1, 500);
+            auto fast = client.request_async<1, int>(1);
+            gbassert(fast.get() == 1);
+            gbassert(slow.wait_for(0s) != std::future_status::ready);
+            gbassert(slow.get() == 500);
+
+            // synchronous requests are answered through the receiver thread
+            gbassert(client.request<0, int>(3) == 9);
+            gbassert(client.request_async<3, int>(-1).get().error() == "negative");
+            std::vector<int> vec(1'000'000, 1);
+            gbassert(client.request_async<std::size_t>(2, vec, 5).get() == 1'000'005);
+
+            // outstanding requests are completed before disconnect
+            auto last = client.request_async<int>(1, 100);
+            client.disconnect();
+            gbassert(last.get() == 100);
+        }
+        {   // batch: one write, results in the order of parameters
+            unix_socket_client_t client(path, 50);
+            auto squares = client.request_batch<0, int>(std::views::iota(0, 1000));
+            gbassert(squares.size() == 1000);
+            for (auto i = 0; i < 1000; ++i)
+                gbassert(squares[i] == i * i);
+
+            std::vector params{ std::tuple{ std::vector<int>(10), 1 }, std::tuple{ std::vector<int>(100), 2 } };
+            auto sizes = client.request_batch<std::size_t>(2, params);
+            gbassert(sizes[0] == 11 && sizes[1] == 102);
+
+            auto checked = client.request_batch<3, int>(std::vector{ 1, -1, 2 });
+            gbassert(checked[0] == 1 && checked[1].error() == "negative" && checked[2] == 2);
+        }
+        {   // many threads share a client
+            unix_socket_client_t client(path, 50);
+            std::vector<std::future<void>> futures;
+            for (auto t = 0; t < 8; ++t)
+                futures.push_back(std::async(std::launch::async, [&, t]
+                    {
+                        std::vector<std::future<std::expected<int, std::string>>> responses;
+                        for (auto i = 0; i < 100; ++i)
+                            responses.push_back(client.request_async<0, int>(t * 100 + i));
+                        for (auto i = 0; i < 100; ++i)
+                            gbassert(responses[i].get() == (t * 100 + i) * (t * 100 + i));
+                    }));
+            for (auto&& fut : futures)
+                fut.get();
+        }
+
+        gbassert(shutdown_server(path, 10));
+        f.get();
+#endif
+    }
+
+    GB_TEST(util, unix_socket_async_named)
+    {
+#if !defined(GBWINDOWS)
+        const std::string path = "/tmp/yadro_unix_socket_async_named_test";
+        auto f = std::async(std::launch::async, [&]
+            {
+                start_server(path, nullptr,
+                    std::tuple{ "square", [](int i) { return i * i; } },
+                    std::tuple{ "one", [] { return 1; } }
+                    );
+            });
+        {
+            unix_socket_client_t client(path, 50);
+            gbassert(client.request_async<int>("square", 5).get() == 25);
+            gbassert(client.request_async<int>("one").get() == 1);
+            auto squares = client.request_batch<int>("square", std::vector{ 1, 2, 3 });
+            gbassert(squares[0] == 1 && squares[1] == 4 && squares[2] == 9);
+            gbassert(!client.request_async<int>("two").get()); // the server closes the connection
+        }
+        gbassert(shutdown_server(path, 10));
+        f.get();
+#endif
+    }
+
+    GB_TEST(util, shm_ring)
+    {
+        // multiple producers share one ring, messages larger than the ring are streamed through it
+        shm_channel_t channel("yadro_shm_ring_test", 4096);
+        constexpr int producers = 4, messages = 200;
+        auto make_message = [](int p, int i) { return std::vector<int>(i % 7 == 0 ? 5000 : i % 13, p * messages + i); };
+
+        std::vector<std::future<void>> futures;
+        for (int p = 0; p < producers; ++p)
+            futures.push_back(std::async(std::launch::async, [&, p]
+                {
+                    shm_channel_t producer_channel("yadro_shm_ring_test"); // separate mapping of the same memory
+                    oshm_stream out(producer_channel.ring(0), true);
+                    oshm_archive a{ out };
+                    for (int i = 0; i < messages; ++i)
+                    {
+                        a(p, i, make_message(p, i));
+                        out.flush();
+                    }
+                }));
+
+        ishm_stream in(channel.ring(0));
+        ishm_archive a{ in };
+        std::vector<int> next(producers, 0);
+        for (int k = 0; k < producers * messages; ++k)
+        {
+            int p{}, i{};
+            std::vector<int> v;
+            a(p, i, v);
+            gbassert(p >= 0 && p < producers && i == next[p]++);
+            gbassert(v == make_message(p, i));
+        }
+        for (auto&& f : futures)
+            f.get();
+        gbassert(!in.has_data());
+    }
+
+    GB_TEST(util, shm_ring_closed)
+    {
+        using namespace std::chrono_literals;
+        // closing the ring fails the producer waiting for space and the one waiting for the lock
+        shm_channel_t channel("yadro_shm_ring_closed_test", 4096);
+        std::atomic<int> failed{ 0 };
+        auto produce = [&](std::size_t size)
+            {
+                return std::async(std::launch::async, [&, size]
+                    {
+                        oshm_stream out(channel.ring(0), true);
+                        std::vector<char> message(size);
+                        try
+                        {
+                            out.write(message.data(), message.size());
+                            out.flush();
+                        }
+                        catch (const exception_t<>&)
+                        {
+                            ++failed;
+                        }
+                    });
+            };
+        auto blocked = produce(3 * 4096); // larger than the ring, nobody reads it
+        std::this_thread::sleep_for(50ms);
+        auto waiting = produce(10);
+        std::this_thread::sleep_for(50ms);
+        channel.close();
+        gbassert(blocked.wait_for(5s) == std::future_status::ready);
+        gbassert(waiting.wait_for(5s) == std::future_status::ready);
+        gbassert(failed == 2);
+
+        // a message isn't started on a closed ring, even if it has space
+        must_throw([&] { oshm_stream out(channel.ring(1), true); char c{}; out.write(&c, 1); });
+    }
+
+    GB_TEST(util, shm_rpc)
+    {
+        shm_server_t server("yadro_shm_rpc_test", 1 << 16);
+        auto f = std::async(std::launch::async, [&]
+            {
+                for (;;)
+                    if (auto ret = server.run(
+                        [](int i) { return i + 1; },
+                        [](const std::vector<double>& v) { return v; }, // echo vector
+                        [](int i) { if (i < 0) throw std::runtime_error("negative"); return i; });
+                        ret == server_shutdown)
+                        return ret;
+            });
+        {
+            shm_client_t client("yadro_shm_rpc_test", 50);
+            gbassert(client.request<int>(0, 1) == 2);
+            gbassert(client.request<2, int>(-1).error() == "negative");
+            std::vector<double> vec(1'000'000); // larger than the ring
+            for (std::size_t i = 0; i < vec.size(); ++i)
+                vec[i] = i * 0.5;
+            gbassert(client.request<std::vector<double>>(1, vec).value() == vec);
+            // one client at a time
+            must_throw([] { shm_client_t("yadro_shm_rpc_test", "second client", 1); });
+            for (int i = 0; i < 10'000; ++i)
+                gbassert(client.request<int>(0, i) == i + 1);
+        }
+        {   // the channel is reused by the next client
+            shm_client_t client("yadro_shm_rpc_test", "second client", 5);
+            gbassert(client.request<int>(0, 41) == 42);
+            client.shutdown();
+        }
+        gbassert(f.get() == server_shutdown);
+
+        // functions invoked by name
+        shm_server_t named_server("yadro_shm_rpc_named_test", 1 << 16);
+        auto fn = std::async(std::launch::async, [&]
+            {
+                return named_server.run(
+                    std::tuple{ "two", [](int i1, int i2) { return std::array{ i1, i2 }; } },
+                    std::tuple{ "three", [] {} });
+            });
+        shm_client_t client("yadro_shm_rpc_named_test", 50);
+        gbassert(client.request<std::array<int, 2>>("two", 1, 2).value() == std::array{ 1,2 });
+        gbassert(client.request<void>("three"));
+        client.shutdown();
+        gbassert(fn.get() == server_shutdown);
+    }
+
+    GB_TEST(util, shm_abandoned_client)
+    {
+        shm_server_t server("yadro_shm_abandoned_test", 1 << 12);
+        auto f = std::async(std::launch::async, [&]
+            {
+                for (;;)
+                    if (auto ret = server.run([](int i) { return i + 1; }); ret == server_shutdown)
+                        return ret;
+            });
+        {   // the client process exited without disconnecting, no process has this id
+            shm_channel_t channel("yadro_shm_abandoned_test");
+            gbassert(channel.connect(std::numeric_limits<std::int32_t>::max()));
+        }
+        {   // the next client takes over the connection
+            shm_client_t client("yadro_shm_abandoned_test", "next client", 5);
+            gbassert(client.request<int>(0, 1) == 2);
+            // the connection of a running client is kept
+            must_throw([] { shm_client_t("yadro_shm_abandoned_test", "another client", 1); });
+            gbassert(client.request<int>(0, 2) == 3);
+        }
+        {   // the client abandoned with the responses unread
+            shm_channel_t channel("yadro_shm_abandoned_test");
+            gbassert(channel.connect(std::numeric_limits<std::int32_t>::max()));
+            oshm_stream out(channel.ring(0));
+            ishm_stream in(channel.ring(1));
+            oshm_archive a{ out };
+            a(std::uint32_t(0), std::tuple{ 10 });
+            out.flush();
+            std::uint8_t first = 0;
+            ishm_archive{ in }(first); // the response is published, the rest of it is left in the ring
+        }
+        shm_client_t client("yadro_shm_abandoned_test", "last client", 5);
+        gbassert(client.request<int>(0, 41) == 42);
+        client.shutdown();
+        gbassert(f.get() == server_shutdown);
+    }
 }
@@ -36,7 +36,11 @@
 #include <ostream>
 #include <fstream>
 #include <concepts>
+#if defined(_WIN32)
 #include <process.h> // for getpid
+#else
+#include <unistd.h> // for getpid
+#endif
 #include <cassert>
 #include <map>
 #include <set>
@@ -39,9 +39,12 @@
 #include "gnuplot.h"
 #include "hash_util.h"
 #include "misc.h"
+#include "rpc.h"
+#include "shm_ring.h"
 #include "string_util.h"
 #include "time_util.h"
 #include "traits.h"
 #include "tuple_functions.h"
+#include "unix_socket.h"
 #include "win_pipe.h"
 #include "win_service.h"
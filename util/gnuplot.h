@@ -31,6 +31,7 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <filesystem>
 #include <string>
 #include <vector>
 #include <map>
@@ -263,6 +264,20 @@ namespace gb::yadro::util
     //---------------------------------------------------------------------------------------------
     inline auto operator ""_cmd(const char* cmd, std::size_t) { return detail::cmd_t{ cmd }; }
 
+    //---------------------------------------------------------------------------------------------
+    // plot command for columns of an existing data file, e.g. convergence curve of optimization trace:
+    // gnuplot().multiplot(1, data_file_plot("trace.dat", 1, 2, "best target"))
+    //---------------------------------------------------------------------------------------------
+    inline auto data_file_plot(const std::filesystem::path& path, unsigned x_column, unsigned y_column,
+        const std::string& title = "", plotstyle style = plotstyle::s_line)
+    {
+        auto posix_path{ path.string() };
+        std::replace(posix_path.begin(), posix_path.end(), '\\', '/'); // gnuplot expects posix path
+
+        return detail::cmd_t{ std::format("plot \"{}\" using {}:{} {} {}", posix_path, x_column, y_column,
+            title.empty() ? std::string("notitle") : "title \"" + title + "\"", detail::style_str(style)) };
+    }
+
     //---------------------------------------------------------------------------------------------
     // gnuplot class
     struct gnuplot
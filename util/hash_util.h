@@ -30,6 +30,15 @@
 #include <string>
 #include <type_traits>
 #include <ranges>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "string_util.h"
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
 namespace gb::yadro::util
 {
@@ -84,4 +93,185 @@ namespace gb::yadro::util
 #endif
 
     using make_hash_t = decltype([](auto&& ...v) { return gb::yadro::util::make_hash(std::forward<decltype(v)>(v)...); });
+
+    //-------------------------------------------------------------------------
+    // fast non-cryptographic 128-bit content hash, built like XXH3 (but not compatible with it):
+    // 64-byte stripes are accumulated in 8 independent 64-bit lanes with 32x32->64 multiplications,
+    // the keys shift with the stripe position, accumulators are scrambled every 16 stripes,
+    // and merged with 64x64->128 multiplications in the end
+    struct hash128
+    {
+        hash128& update(const std::uint8_t* data, std::size_t length)
+        {
+            _length += length;
+            if (_buf_size)
+            {
+                auto n = std::min(length, stripe_size - _buf_size);
+                std::memcpy(_buf + _buf_size, data, n);
+                _buf_size += n;
+                data += n;
+                length -= n;
+                if (_buf_size < stripe_size)
+                    return *this;
+                stripe(_buf);
+                _buf_size = 0;
+            }
+            for (; length >= stripe_size; data += stripe_size, length -= stripe_size)
+                stripe(data);
+            if (length)
+            {
+                std::memcpy(_buf, data, length);
+                _buf_size = length;
+            }
+            return *this;
+        }
+
+        hash128& update(auto&& t) requires (std::is_aggregate_v<std::remove_cvref_t<decltype(t)>> or std::is_fundamental_v<std::remove_cvref_t<decltype(t)>>)
+        {
+            return update(reinterpret_cast<const std::uint8_t*>(std::addressof(t)), sizeof(t));
+        }
+
+        hash128& update(std::ranges::sized_range auto&& r) requires(not std::is_aggregate_v<std::remove_cvref_t<decltype(r)>>)
+        {
+            return update(reinterpret_cast<const std::uint8_t*>(std::ranges::data(r)),
+                std::ranges::size(r) * sizeof(std::ranges::range_value_t<decltype(r)>));
+        }
+
+        hash128& update(const char* str)
+        {
+            return update(std::string_view(str));
+        }
+
+        hash128& finalize()
+        {
+            if (_finalized)
+                return *this;
+            // the last partial stripe is zero padded, the length distinguishes padding from data
+            std::memset(_buf + _buf_size, 0, stripe_size - _buf_size);
+            stripe(_buf);
+
+            _lo = _length * 0x9E3779B185EBCA87ull;
+            _hi = ~(_length * 0xC2B2AE3D27D4EB4Full);
+            for (std::size_t i = 0; i < lanes; i += 2)
+            {
+                _lo += mul_fold(_acc[i] ^ secret[merge_key + i], _acc[i + 1] ^ secret[merge_key + i + 1]);
+                _hi += mul_fold(_acc[i] ^ secret[merge_key + lanes + i], _acc[i + 1] ^ secret[merge_key + lanes + i + 1]);
+            }
+            _lo = avalanche(_lo);
+            _hi = avalanche(_hi);
+            _finalized = true;
+            return *this;
+        }
+
+        std::array<std::uint8_t, 16> digest() const
+        {
+            std::array<std::uint8_t, 16> result;
+            for (int i = 0; i < 8; ++i)
+            {
+                result[i] = static_cast<std::uint8_t>(_lo >> (8 * i));
+                result[8 + i] = static_cast<std::uint8_t>(_hi >> (8 * i));
+            }
+            return result;
+        }
+
+        std::string to_string() const { return to_hex(digest()); }
+
+    private:
+        static constexpr std::size_t stripe_size = 64;
+        static constexpr std::size_t lanes = 8;
+        static constexpr std::size_t block_stripes = 16;
+        static constexpr std::size_t scramble_key = lanes + block_stripes - 1;
+        static constexpr std::size_t merge_key = scramble_key + lanes;
+
+        // secret keys generated by splitmix64
+        static constexpr auto secret = [] {
+            std::array<std::uint64_t, merge_key + 2 * lanes> keys{};
+            std::uint64_t x = 0x2545F4914F6CDD1Dull;
+            for (auto& k : keys)
+            {
+                auto z = (x += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                k = z ^ (z >> 31);
+            }
+            return keys;
+        }();
+
+        static std::uint64_t read64(const std::uint8_t* p)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            if constexpr (std::endian::native == std::endian::big)
+                v = std::byteswap(v);
+            return v;
+        }
+
+        // xor folded 128-bit product
+        static std::uint64_t mul_fold(std::uint64_t a, std::uint64_t b)
+        {
+#if defined(__SIZEOF_INT128__)
+            auto p = static_cast<unsigned __int128>(a) * b;
+            return static_cast<std::uint64_t>(p) ^ static_cast<std::uint64_t>(p >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            std::uint64_t hi;
+            auto lo = _umul128(a, b, &hi);
+            return lo ^ hi;
+#else
+            auto lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+            auto hi_lo = (a >> 32) * (b & 0xffffffff);
+            auto lo_hi = (a & 0xffffffff) * (b >> 32);
+            auto hi_hi = (a >> 32) * (b >> 32);
+            auto cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+            auto hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+            auto lo = (cross << 32) | (lo_lo & 0xffffffff);
+            return lo ^ hi;
+#endif
+        }
+
+        static std::uint64_t avalanche(std::uint64_t h)
+        {
+            h ^= h >> 37;
+            h *= 0x165667919E3779F9ull;
+            return h ^ (h >> 32);
+        }
+
+        void stripe(const std::uint8_t* p)
+        {
+            auto key = secret.data() + _stripes % block_stripes;
+            for (std::size_t i = 0; i < lanes; ++i)
+            {
+                auto v = read64(p + 8 * i);
+                auto k = v ^ key[i];
+                _acc[i ^ 1] += v;
+                _acc[i] += (k & 0xffffffff) * (k >> 32);
+            }
+            if (++_stripes % block_stripes == 0)
+            {
+                for (std::size_t i = 0; i < lanes; ++i)
+                {
+                    auto a = _acc[i];
+                    a ^= a >> 47;
+                    a ^= secret[scramble_key + i];
+                    _acc[i] = a * 0x9E3779B1ull;
+                }
+            }
+        }
+
+        std::array<std::uint64_t, lanes> _acc{
+            0xC2B2AE3Dull, 0x9E3779B185EBCA87ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull,
+            0x85EBCA77C2B2AE63ull, 0x85EBCA77ull, 0x27D4EB2F165667C5ull, 0x9E3779B1ull };
+        std::uint8_t _buf[stripe_size]{};
+        std::size_t _buf_size{};
+        std::size_t _stripes{};
+        std::uint64_t _length{};
+        std::uint64_t _lo{}, _hi{};
+        bool _finalized{};
+    };
+
+    inline auto hash128string(auto&& ...t)
+    {
+        hash128 _{};
+        (_.update(std::forward<decltype(t)>(t)), ...);
+        return _.finalize().to_string();
+    }
 }
@@ -0,0 +1,240 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2024, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+#include "gberror.h"
+#include "misc.h"
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+// RPC protocol shared by the transports (win_pipe, unix_socket, shm_ring)
+//  request: uint32 function index (0 for named functions), [function name], [parameters tuple]
+//  response: std::expected<result, std::string>
+//  server_disconnect and server_shutdown indices close the connection or stop the server
+//  pipelined request: server_async, uint64 request id, then the request,
+//  the response is the request id followed by the response, in the order of completion
+//  endpoint is a transport object with:
+//  send(const T&...) - sends all arguments as one message
+//  write(const T&...) - buffers the arguments until the next send or flush (pipelined requests only)
+//  receive<T>() - receives an object
+//  log(...) - writes to the transport log
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::util
+{
+    inline constexpr std::uint32_t server_disconnect = -1;
+    inline constexpr std::uint32_t server_shutdown = -2;
+    inline constexpr std::uint32_t server_async = -3;
+
+    namespace detail
+    {
+        //------------------------------------------------------------------------------------------
+        // client side: send the request and receive the response
+        template<class T>
+        auto rpc_request(auto& endpoint, const std::string& name, auto&& ...params)
+        {
+            if constexpr (sizeof ...(params))
+                endpoint.send(0u, name, std::tuple{ params... });
+            else
+                endpoint.send(0u, name);
+            return endpoint.template receive<std::expected<T, std::string>>();
+        }
+
+        template<class T>
+        auto rpc_request(auto& endpoint, std::uint32_t fn_id, auto&& ...params)
+        {
+            if constexpr (sizeof ...(params))
+                endpoint.send(fn_id, std::tuple{ params... });
+            else
+                endpoint.send(fn_id);
+            return endpoint.template receive<std::expected<T, std::string>>();
+        }
+
+        // client side: buffer the pipelined request, the response is received later with request_id
+        // params is a tuple of the function parameters
+        inline void rpc_write_async(auto& endpoint, std::uint64_t request_id, const std::string& name, const auto& params)
+        {
+            endpoint.write(server_async, request_id, 0u, name, params);
+        }
+
+        inline void rpc_write_async(auto& endpoint, std::uint64_t request_id, std::uint32_t fn_id, const auto& params)
+        {
+            endpoint.write(server_async, request_id, fn_id, params);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // server side: invoke the function, the exceptions are returned as the error message
+        template<class Fn>
+        auto rpc_call(auto& endpoint, Fn& fn, auto& params)
+        {
+            using lambda_type = std::remove_cvref_t<Fn>;
+            using sent_t = std::expected< lambda_ret<lambda_type>, std::string>;
+
+            try
+            {
+                if constexpr (std::is_void_v<lambda_ret<lambda_type>>)
+                {
+                    std::apply([&](auto&& ...args) { fn(std::move(args)...); }, params);
+                    return sent_t{};
+                }
+                else
+                    return sent_t{ std::apply([&](auto&& ...args) { return fn(std::move(args)...); }, params) };
+            }
+            catch (util::exception_t<>& e)
+            {
+                endpoint.log("exception: ", e.what());
+                return sent_t{ std::unexpected{ std::string(e.what()) } };
+            }
+            catch (std::exception& e)
+            {
+                endpoint.log("exception: ", e.what());
+                return sent_t{ std::unexpected{ std::string(e.what()) } };
+            }
+            catch (...)
+            {
+                endpoint.log("unknown exception");
+                return sent_t{ std::unexpected{ std::string("unknown exception") } };
+            }
+        }
+
+        //------------------------------------------------------------------------------------------
+        // server side: receive parameters, invoke the function and send the result or the exception message
+        // transport errors are not caught, they close the connection
+        template<class Fn>
+        void rpc_invoke(auto& endpoint, Fn& fn, const auto& fun_id)
+        {
+            auto params = endpoint.template receive<lambda_pure_args<std::remove_cvref_t<Fn>>>();
+            endpoint.log("received parameters for function: ", fun_id);
+            endpoint.send(rpc_call(endpoint, fn, params));
+            endpoint.log("sent response from function: ", fun_id);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // server side of pipelined request: parameters are received now, execute(task) runs task(endpoint) later,
+        // possibly concurrently with the following requests, so fn must outlive the task
+        template<class Fn>
+        void rpc_invoke_async(auto& endpoint, Fn& fn, const auto& fun_id, std::uint64_t request_id, auto&& execute)
+        {
+            auto params = endpoint.template receive<lambda_pure_args<std::remove_cvref_t<Fn>>>();
+            endpoint.log("received parameters for function: ", fun_id, ", request: ", request_id);
+            execute([&fn, fun_id, request_id, params = std::move(params)](auto& endpoint) mutable
+                {
+                    endpoint.send(request_id, rpc_call(endpoint, fn, params));
+                    endpoint.log("sent response from function: ", fun_id, ", request: ", request_id);
+                });
+        }
+
+        //------------------------------------------------------------------------------------------
+        // serve the request after its function index is received
+        // returns false if the request can't be served, the connection must be closed then,
+        // because the parameters can't be skipped without knowing their types
+        template<class ...Fn>
+        bool rpc_dispatch_index(auto& endpoint, std::tuple<Fn...>& functions, std::uint32_t fun_index)
+        {
+            if (fun_index >= sizeof...(Fn))
+            {
+                endpoint.log("error: client requested invalid function: ", fun_index);
+                return false;
+            }
+
+            endpoint.log("client requested function: ", fun_index);
+            // the function is invoked in place, tuple_to_variant would require default constructible functions
+            [&]<std::size_t ...I>(std::index_sequence<I...>)
+            {
+                ((I == fun_index ? (rpc_invoke(endpoint, std::get<I>(functions), fun_index), true) : false) || ...);
+            }(std::index_sequence_for<Fn...>{});
+            return true;
+        }
+
+        template<class ...Fn>
+        bool rpc_dispatch_name(auto& endpoint, std::tuple<std::tuple<const char*, Fn>...>& functions)
+        {
+            auto fun_name = endpoint.template receive<std::string>();
+            endpoint.log("client requested function: ", fun_name);
+
+            auto found = false;
+            std::apply([&](auto&&... fn_tuple) {
+                ((!found && std::get<0>(fn_tuple) == fun_name ? (rpc_invoke(endpoint, std::get<1>(fn_tuple), fun_name), found = true) : false), ...);
+                }, functions);
+
+            if (!found)
+            {
+                endpoint.log("error: client requested invalid function: ", fun_name);
+                endpoint.send(std::expected<void, std::string>{ std::unexpected{ "bad function name: " + fun_name } });
+            }
+            return found;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // pipelined counterparts: the function is referenced in place, the response is sent by the executed task,
+        // the error of invalid request is sent right away with the request id
+        template<class ...Fn>
+        bool rpc_dispatch_index_async(auto& endpoint, std::tuple<Fn...>& functions, std::uint32_t fun_index,
+            std::uint64_t request_id, auto&& execute)
+        {
+            if (fun_index >= sizeof...(Fn))
+            {
+                endpoint.log("error: client requested invalid function: ", fun_index, ", request: ", request_id);
+                return false;
+            }
+
+            endpoint.log("client requested function: ", fun_index, ", request: ", request_id);
+            [&]<std::size_t ...I>(std::index_sequence<I...>)
+            {
+                ((I == fun_index ? (rpc_invoke_async(endpoint, std::get<I>(functions), fun_index, request_id, execute), true) : false) || ...);
+            }(std::index_sequence_for<Fn...>{});
+            return true;
+        }
+
+        template<class ...Fn>
+        bool rpc_dispatch_name_async(auto& endpoint, std::tuple<std::tuple<const char*, Fn>...>& functions,
+            std::uint64_t request_id, auto&& execute)
+        {
+            auto fun_name = endpoint.template receive<std::string>();
+            endpoint.log("client requested function: ", fun_name, ", request: ", request_id);
+
+            auto found = false;
+            std::apply([&](auto&&... fn_tuple) {
+                ((!found && std::get<0>(fn_tuple) == fun_name ? (rpc_invoke_async(endpoint, std::get<1>(fn_tuple), fun_name, request_id, execute), found = true) : false), ...);
+                }, functions);
+
+            if (!found)
+            {
+                endpoint.log("error: client requested invalid function: ", fun_name, ", request: ", request_id);
+                endpoint.send(request_id, std::expected<void, std::string>{ std::unexpected{ "bad function name: " + fun_name } });
+            }
+            return found;
+        }
+    }
+}
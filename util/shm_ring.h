@@ -0,0 +1,1041 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2024, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+#include "gbwin.h"
+#include "gberror.h"
+#include "gblog.h"
+#include "time_util.h"
+#include "rpc.h"
+#include "../archive/archive.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#ifndef GBWINDOWS
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// shared memory transport for the processes on the same machine
+//  shm_ring_t: byte ring in shared memory, positions are 64-bit byte counters,
+//  head is published by the producer, tail by the consumer
+//  the archives serialize directly into the ring and deserialize directly from it,
+//  so a message is copied once in each direction, large messages are streamed through
+//  the ring while the consumer drains it
+//  waiting spins first, then sleeps on a futex (Linux) or a named event (Windows),
+//  the wake up system call is made only if the other side is actually sleeping
+//  single producer by default, oshm_stream(ring, true) locks the ring for the whole message,
+//  so any number of producers can share the ring (MPSC)
+//  shm_channel_t: two rings in one named shared memory segment
+//  shm_server_t, shm_client_t: RPC over a channel (rpc.h protocol), one client at a time,
+//  the channel keeps the process id of the attached client, the connection of a client that
+//  exited without disconnecting is taken over by the next one, unless it exited in the middle
+//  of a request, the server waits for the rest of the request then
+//  segment layout: channel header, ring header 0, ring 0 data, ring header 1, ring 1 data
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::util
+{
+    class shm_ring_t;
+    struct ishm_stream;
+    struct oshm_stream;
+    using ishm_archive = gb::yadro::archive::archive<ishm_stream&, gb::yadro::archive::archive_format_t::custom>;
+    using oshm_archive = gb::yadro::archive::archive<oshm_stream&, gb::yadro::archive::archive_format_t::custom>;
+
+    // constants
+    inline constexpr std::size_t shm_default_capacity = 1 << 20;
+    inline constexpr std::uint32_t shm_channel_magic = 0x4d485359; // "YSHM"
+
+    namespace detail
+    {
+        // a few microseconds of spinning before sleeping, spinning on a single CPU only delays the other side
+        inline int shm_spin_count()
+        {
+            static const int count = std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+            return count;
+        }
+
+        //------------------------------------------------------------------------------------------
+        inline void cpu_relax()
+        {
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+            _mm_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+        //------------------------------------------------------------------------------------------
+        struct shm_channel_header
+        {
+            std::atomic<std::uint32_t> magic;
+            std::atomic<std::uint32_t> client_pid; // process id of the attached client, 0 if none
+            std::uint64_t capacity;
+            std::int64_t owner_pid;
+        };
+
+        struct alignas(64) shm_ring_header
+        {
+            alignas(64) std::atomic<std::uint64_t> head;    // bytes published by the producer
+            std::atomic<std::uint32_t> data_seq;            // futex word, incremented when sleeping consumer must wake up
+            std::atomic<std::uint32_t> consumer_waiting;
+            alignas(64) std::atomic<std::uint64_t> tail;    // bytes released by the consumer
+            std::atomic<std::uint32_t> space_seq;           // futex word, incremented when sleeping producer must wake up
+            std::atomic<std::uint32_t> producer_waiting;
+            alignas(64) std::atomic<std::uint32_t> producer_lock; // 0 - free, 1 - locked, 2 - locked with waiters
+            std::atomic<std::uint32_t> closed;
+        };
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+            "shared memory atomics must be lock-free");
+
+        inline constexpr std::size_t shm_channel_header_size = 64;
+        static_assert(sizeof(shm_channel_header) <= shm_channel_header_size);
+
+        //------------------------------------------------------------------------------------------
+        // false only if the process is known to be gone, a reused process id keeps the resource taken
+        inline bool is_process_running(std::int64_t pid)
+        {
+#ifdef GBWINDOWS
+            auto process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+            if (!process)
+                return GetLastError() != ERROR_INVALID_PARAMETER;
+            auto is_running = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+            CloseHandle(process);
+            return is_running;
+#else
+            return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+        }
+
+        //------------------------------------------------------------------------------------------
+        // futex-like wait on a 32-bit word in shared memory, visible to all processes mapping it
+        class shm_signal
+        {
+        public:
+            shm_signal(std::atomic<std::uint32_t>& word, [[maybe_unused]] const std::string& name) : _word(&word)
+            {
+#ifdef GBWINDOWS
+                auto wname = L"Local\\" + std::wstring(name.begin(), name.end());
+                if (_event = CreateEventW(nullptr, FALSE, FALSE, wname.c_str()); !_event)
+                    throw util::exception_t("failed to create event: " + name, GetLastError());
+#endif
+            }
+
+            shm_signal(const shm_signal&) = delete;
+            shm_signal& operator=(const shm_signal&) = delete;
+
+            ~shm_signal()
+            {
+#ifdef GBWINDOWS
+                CloseHandle(_event);
+#endif
+            }
+
+            // sleep while the word has the old value, may return spuriously
+            void wait(std::uint32_t old) const
+            {
+#if defined(GBWINDOWS)
+                if (_word->load() == old) // auto-reset event, the timeout covers the wake up consumed by another waiter
+                    WaitForSingleObject(_event, 1);
+#elif defined(__linux__)
+                ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(_word), FUTEX_WAIT, old, nullptr, nullptr, 0);
+#else
+                if (_word->load() == old)
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+            }
+
+            void notify_all() const
+            {
+#if defined(GBWINDOWS)
+                SetEvent(_event);
+#elif defined(__linux__)
+                ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(_word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+            }
+
+        private:
+            std::atomic<std::uint32_t>* _word;
+#ifdef GBWINDOWS
+            HANDLE _event = nullptr;
+#endif
+        };
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // named shared memory segment, the creator owns the name
+    class shared_memory_t
+    {
+    public:
+        // create a new segment filled with zeros
+        shared_memory_t(const std::string& name, std::size_t size) : _name(name), _size(size), _owner(true)
+        {
+#ifdef GBWINDOWS
+            auto wname = L"Local\\" + std::wstring(name.begin(), name.end());
+            _mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(std::uint64_t(size) >> 32), static_cast<DWORD>(size), wname.c_str());
+            if (!_mapping || GetLastError() == ERROR_ALREADY_EXISTS)
+            {
+                auto error = GetLastError();
+                if (_mapping)
+                    CloseHandle(_mapping);
+                throw util::exception_t("failed to create shared memory: " + name, error);
+            }
+            map();
+#else
+            auto fd = ::shm_open(posix_name().c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+            if (fd == -1)
+                throw util::exception_t(std::format("failed to create shared memory: {}: {}", name, std::generic_category().message(errno)), errno);
+            if (::ftruncate(fd, static_cast<off_t>(size)) == -1)
+            {
+                auto error = errno;
+                ::close(fd);
+                ::shm_unlink(posix_name().c_str());
+                throw util::exception_t(std::format("failed to size shared memory: {}: {}", name, std::generic_category().message(error)), error);
+            }
+            map(fd);
+#endif
+        }
+
+        // open an existing segment
+        explicit shared_memory_t(const std::string& name) : _name(name)
+        {
+#ifdef GBWINDOWS
+            auto wname = L"Local\\" + std::wstring(name.begin(), name.end());
+            if (_mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, wname.c_str()); !_mapping)
+                throw util::exception_t("failed to open shared memory: " + name, GetLastError());
+            map();
+            MEMORY_BASIC_INFORMATION info{};
+            VirtualQuery(_data, &info, sizeof(info));
+            _size = info.RegionSize;
+#else
+            auto fd = ::shm_open(posix_name().c_str(), O_RDWR | O_CLOEXEC, 0600);
+            if (fd == -1)
+                throw util::exception_t(std::format("failed to open shared memory: {}: {}", name, std::generic_category().message(errno)), errno);
+            struct stat st {};
+            ::fstat(fd, &st);
+            _size = static_cast<std::size_t>(st.st_size);
+            if (_size == 0)
+            {   // the creator didn't set the size yet
+                ::close(fd);
+                throw util::exception_t("shared memory is not initialized: " + name);
+            }
+            map(fd);
+#endif
+        }
+
+        shared_memory_t(const shared_memory_t&) = delete;
+        shared_memory_t& operator=(const shared_memory_t&) = delete;
+
+        ~shared_memory_t()
+        {
+#ifdef GBWINDOWS
+            if (_data)
+                UnmapViewOfFile(_data);
+            if (_mapping)
+                CloseHandle(_mapping);
+#else
+            if (_data)
+                ::munmap(_data, _size);
+            if (_owner)
+                ::shm_unlink(posix_name().c_str());
+#endif
+        }
+
+        // remove the name left by a process that didn't exit cleanly
+        static void remove([[maybe_unused]] const std::string& name)
+        {
+#ifndef GBWINDOWS
+            ::shm_unlink(("/" + name).c_str());
+#endif
+        }
+
+        char* data() const { return static_cast<char*>(_data); }
+        auto size() const { return _size; }
+        auto&& name() const { return _name; }
+
+    private:
+        std::string _name;
+        std::size_t _size = 0;
+        void* _data = nullptr;
+        bool _owner = false;
+#ifdef GBWINDOWS
+        HANDLE _mapping = nullptr;
+
+        void map()
+        {
+            if (_data = MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, _size); !_data)
+            {
+                auto error = GetLastError();
+                CloseHandle(_mapping);
+                throw util::exception_t("failed to map shared memory: " + _name, error);
+            }
+        }
+#else
+        std::string posix_name() const { return "/" + _name; }
+
+        void map(int fd)
+        {
+            auto data = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            auto error = errno;
+            ::close(fd);
+            if (data == MAP_FAILED)
+            {
+                if (_owner)
+                    ::shm_unlink(posix_name().c_str());
+                throw util::exception_t(std::format("failed to map shared memory: {}: {}", _name, std::generic_category().message(error)), error);
+            }
+            _data = data;
+        }
+#endif
+    };
+
+    //----------------------------------------------------------------------------------------------
+    // ring of bytes in shared memory, shared state only, the positions of the current
+    // message are kept by the streams
+    class shm_ring_t
+    {
+    public:
+        shm_ring_t(detail::shm_ring_header& header, char* data, std::uint64_t capacity, const std::string& name)
+            : _h(header), _data(data), _mask(capacity - 1),
+            _data_signal(header.data_seq, name + "_data"),
+            _space_signal(header.space_seq, name + "_space"),
+            _lock_signal(header.producer_lock, name + "_lock")
+        {
+            gbassert(std::has_single_bit(capacity));
+        }
+
+        shm_ring_t(const shm_ring_t&) = delete;
+        shm_ring_t& operator=(const shm_ring_t&) = delete;
+
+        auto capacity() const { return _mask + 1; }
+        auto head() const { return _h.head.load(std::memory_order_acquire); }
+        auto tail() const { return _h.tail.load(std::memory_order_acquire); }
+
+        //------------------------------------------------------------------------------------------
+        // waiting sides fail instead of sleeping forever, the producers waiting for the lock
+        // are woken up too, the one missing the wake up is woken by the owner releasing the lock
+        void close()
+        {
+            _h.closed.store(1);
+            _h.data_seq.fetch_add(1);
+            _h.space_seq.fetch_add(1);
+            _data_signal.notify_all();
+            _space_signal.notify_all();
+            _lock_signal.notify_all();
+        }
+
+        bool is_closed() const { return _h.closed.load(std::memory_order_acquire) != 0; }
+
+        //------------------------------------------------------------------------------------------
+        // the waiting flag is stored before the position is checked again, the position is stored
+        // before the flag is checked, sequentially consistent order guarantees that either
+        // the waiting side sees the new position or the other side sees the flag and wakes it up
+        void publish_head(std::uint64_t pos) { publish(_h.head, pos, _h.consumer_waiting, _h.data_seq, _data_signal); }
+        void publish_tail(std::uint64_t pos) { publish(_h.tail, pos, _h.producer_waiting, _h.space_seq, _space_signal); }
+
+        // wait for data after pos, returns head
+        std::uint64_t wait_data(std::uint64_t pos)
+        {
+            return wait(_h.head, _h.consumer_waiting, _h.data_seq, _data_signal, [=](auto head) { return head != pos; });
+        }
+
+        // wait for free space to write at pos, returns tail
+        std::uint64_t wait_space(std::uint64_t pos)
+        {
+            return wait(_h.tail, _h.producer_waiting, _h.space_seq, _space_signal, [=, this](auto tail) { return pos - tail < capacity(); });
+        }
+
+        //------------------------------------------------------------------------------------------
+        // cross-process mutex for multiple producers, fails when the ring is closed
+        void lock_producer()
+        {
+            auto locked = false;
+            for (auto spin = 0; !locked && spin < detail::shm_spin_count(); ++spin)
+            {
+                if (std::uint32_t expected = 0; _h.producer_lock.compare_exchange_weak(expected, 1, std::memory_order_acquire))
+                    locked = true;
+                else
+                    detail::cpu_relax();
+            }
+
+            // mark the lock contended, so the owner wakes us up
+            if (!locked)
+            {
+                for (auto state = _h.producer_lock.exchange(2, std::memory_order_acquire); state != 0;
+                    state = _h.producer_lock.exchange(2, std::memory_order_acquire))
+                {
+                    if (is_closed())
+                        throw util::exception_t("shared memory ring is closed");
+                    _lock_signal.wait(2);
+                }
+            }
+
+            if (is_closed())
+            {
+                unlock_producer();
+                throw util::exception_t("shared memory ring is closed");
+            }
+        }
+
+        void unlock_producer()
+        {
+            if (_h.producer_lock.exchange(0, std::memory_order_release) == 2)
+                _lock_signal.notify_all();
+        }
+
+        //------------------------------------------------------------------------------------------
+        void write_at(std::uint64_t pos, const char* c, std::size_t size)
+        {
+            auto i = static_cast<std::size_t>(pos & _mask);
+            auto first = std::min<std::size_t>(size, capacity() - i);
+            std::memcpy(_data + i, c, first);
+            std::memcpy(_data, c + first, size - first);
+        }
+
+        void read_at(std::uint64_t pos, char* c, std::size_t size) const
+        {
+            auto i = static_cast<std::size_t>(pos & _mask);
+            auto first = std::min<std::size_t>(size, capacity() - i);
+            std::memcpy(c, _data + i, first);
+            std::memcpy(c + first, _data, size - first);
+        }
+
+    private:
+        detail::shm_ring_header& _h;
+        char* _data;
+        std::uint64_t _mask;
+        detail::shm_signal _data_signal;
+        detail::shm_signal _space_signal;
+        detail::shm_signal _lock_signal;
+
+        void publish(std::atomic<std::uint64_t>& position, std::uint64_t pos, std::atomic<std::uint32_t>& waiting,
+            std::atomic<std::uint32_t>& seq, const detail::shm_signal& signal)
+        {
+            position.store(pos);
+            if (waiting.load())
+            {
+                seq.fetch_add(1);
+                signal.notify_all();
+            }
+        }
+
+        std::uint64_t wait(std::atomic<std::uint64_t>& position, std::atomic<std::uint32_t>& waiting,
+            std::atomic<std::uint32_t>& seq, const detail::shm_signal& signal, auto&& ready)
+        {
+            for (auto spin = 0; spin < detail::shm_spin_count(); ++spin)
+            {
+                if (auto pos = position.load(std::memory_order_acquire); ready(pos))
+                    return pos;
+                detail::cpu_relax();
+            }
+
+            for (;;)
+            {
+                auto s = seq.load();
+                waiting.store(1);
+                if (auto pos = position.load(); ready(pos))
+                {
+                    waiting.store(0, std::memory_order_relaxed);
+                    return pos;
+                }
+                if (is_closed())
+                {
+                    waiting.store(0, std::memory_order_relaxed);
+                    throw util::exception_t("shared memory ring is closed");
+                }
+                signal.wait(s);
+            }
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    // writes into the ring, flush() publishes the message
+    struct oshm_stream
+    {
+        using char_type = char;
+        oshm_stream() = default;
+        explicit oshm_stream(shm_ring_t& ring, bool multi_producer = false) { reset(ring, multi_producer); }
+
+        // the message is abandoned and the producer lock is released if the ring is closed
+        // while waiting for space
+        void write(const char_type* c, std::streamsize size)
+        {
+            if (!_in_message)
+                begin_message();
+
+            try
+            {
+                const auto capacity = _ring->capacity();
+                for (auto n = static_cast<std::size_t>(size); n != 0;)
+                {
+                    auto used = _pos - _tail;
+                    if (used >= capacity)
+                    {
+                        _tail = _ring->tail();
+                        if (used = _pos - _tail; used >= capacity)
+                        {   // the consumer drains the published part of the message, while we wait
+                            _ring->publish_head(_pos);
+                            _tail = _ring->wait_space(_pos);
+                            used = _pos - _tail;
+                        }
+                    }
+
+                    auto chunk = std::min<std::size_t>(n, capacity - used);
+                    _ring->write_at(_pos, c, chunk);
+                    _pos += chunk;
+                    c += chunk;
+                    n -= chunk;
+                }
+            }
+            catch (...)
+            {
+                end_message();
+                throw;
+            }
+        }
+
+        void flush()
+        {
+            if (!_in_message)
+                return;
+            _ring->publish_head(_pos);
+            end_message();
+        }
+
+        void reset(shm_ring_t& ring, bool multi_producer = false)
+        {
+            _ring = &ring;
+            _multi_producer = multi_producer;
+            _in_message = false;
+            _tail = ring.tail();
+        }
+
+    private:
+        shm_ring_t* _ring = nullptr;
+        bool _multi_producer = false;
+        bool _in_message = false;
+        std::uint64_t _pos = 0;
+        std::uint64_t _tail = 0; // cached tail, may be behind the ring
+
+        void begin_message()
+        {
+            if (_multi_producer)
+                _ring->lock_producer();
+            _pos = _ring->head();
+            _in_message = true;
+        }
+
+        void end_message()
+        {
+            _in_message = false;
+            if (_multi_producer)
+                _ring->unlock_producer();
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    // reads from the ring, the space is released lazily: before waiting for more data,
+    // after a quarter of the ring is read, or on destruction
+    struct ishm_stream
+    {
+        using char_type = char;
+        ishm_stream() = default;
+        explicit ishm_stream(shm_ring_t& ring) { reset(ring); }
+
+        ishm_stream(const ishm_stream&) = delete;
+        ishm_stream& operator=(const ishm_stream&) = delete;
+
+        ~ishm_stream() { release(); }
+
+        void read(char_type* c, std::streamsize size)
+        {
+            for (auto n = static_cast<std::size_t>(size); n != 0;)
+            {
+                if (_head == _pos)
+                {
+                    if (_head = _ring->head(); _head == _pos)
+                    {   // the producer may be waiting for space
+                        release();
+                        _head = _ring->wait_data(_pos);
+                    }
+                }
+
+                auto chunk = std::min<std::size_t>(n, static_cast<std::size_t>(_head - _pos));
+                _ring->read_at(_pos, c, chunk);
+                _pos += chunk;
+                c += chunk;
+                n -= chunk;
+            }
+
+            if (_pos - _released >= _ring->capacity() / 4)
+                release();
+        }
+
+        // true if the next message has been published, at least partially
+        bool has_data() const { return _pos != _head || _pos != _ring->head(); }
+
+        // release the space of the bytes read so far
+        void release()
+        {
+            if (_ring && _released != _pos)
+            {
+                _ring->publish_tail(_pos);
+                _released = _pos;
+            }
+        }
+
+        void reset(shm_ring_t& ring)
+        {
+            release();
+            _ring = &ring;
+            _pos = _head = _released = ring.tail();
+        }
+
+        // drop the published bytes nobody is going to read
+        void skip()
+        {
+            _pos = _head = _ring->head();
+            release();
+        }
+
+    private:
+        shm_ring_t* _ring = nullptr;
+        std::uint64_t _pos = 0;
+        std::uint64_t _head = 0;     // cached head
+        std::uint64_t _released = 0; // published tail
+    };
+
+    //----------------------------------------------------------------------------------------------
+    // two rings in a named shared memory segment
+    class shm_channel_t
+    {
+    public:
+        // create a new channel
+        shm_channel_t(const std::string& name, std::size_t capacity)
+            : _capacity(std::bit_ceil(std::max<std::size_t>(capacity, 4096))),
+            _memory(create_memory(name, segment_size(_capacity)))
+        {
+            auto channel = std::construct_at(reinterpret_cast<detail::shm_channel_header*>(_memory->data()));
+            channel->capacity = _capacity;
+            channel->owner_pid = util::process_id();
+            for (auto i = 0; i < 2; ++i)
+                std::construct_at(ring_header(i));
+            make_rings();
+            channel->magic.store(shm_channel_magic, std::memory_order_release);
+        }
+
+        // open the existing channel
+        explicit shm_channel_t(const std::string& name) : _memory(std::make_unique<shared_memory_t>(name))
+        {
+            auto channel = header();
+            if (_memory->size() < detail::shm_channel_header_size || channel->magic.load(std::memory_order_acquire) != shm_channel_magic)
+                throw util::exception_t("shared memory channel is not initialized: " + name);
+            _capacity = channel->capacity;
+            if (_memory->size() < segment_size(_capacity))
+                throw util::exception_t("invalid shared memory channel: " + name);
+            make_rings();
+        }
+
+        auto& ring(int i) { return *_rings[i]; }
+        auto&& name() const { return _memory->name(); }
+        auto capacity() const { return _capacity; }
+
+        // attach the client process, false if another running client is attached,
+        // the connection left by a client that exited without disconnecting is taken over
+        bool connect(std::uint32_t pid = static_cast<std::uint32_t>(util::process_id()))
+        {
+            auto channel = header();
+            for (std::uint32_t expected = 0; !channel->client_pid.compare_exchange_strong(expected, pid);)
+                if (detail::is_process_running(expected))
+                    return false;
+            return true;
+        }
+
+        void disconnect() { header()->client_pid.store(0); }
+
+        // fail the waiting sides
+        void close()
+        {
+            _rings[0]->close();
+            _rings[1]->close();
+        }
+
+    private:
+        std::uint64_t _capacity = 0;
+        std::unique_ptr<shared_memory_t> _memory;
+        std::unique_ptr<shm_ring_t> _rings[2];
+
+        static std::size_t segment_size(std::uint64_t capacity)
+        {
+            return detail::shm_channel_header_size + 2 * (sizeof(detail::shm_ring_header) + capacity);
+        }
+
+        detail::shm_channel_header* header() const { return reinterpret_cast<detail::shm_channel_header*>(_memory->data()); }
+
+        detail::shm_ring_header* ring_header(int i) const
+        {
+            return reinterpret_cast<detail::shm_ring_header*>(_memory->data() + detail::shm_channel_header_size
+                + i * (sizeof(detail::shm_ring_header) + _capacity));
+        }
+
+        void make_rings()
+        {
+            for (auto i = 0; i < 2; ++i)
+                _rings[i] = std::make_unique<shm_ring_t>(*ring_header(i), reinterpret_cast<char*>(ring_header(i) + 1), _capacity,
+                    std::format("{}_{}", _memory->name(), i));
+        }
+
+        // the name left by a crashed server is reused, the name of a running server is not
+        static std::unique_ptr<shared_memory_t> create_memory(const std::string& name, std::size_t size)
+        {
+#ifndef GBWINDOWS
+            try
+            {
+                return std::make_unique<shared_memory_t>(name, size);
+            }
+            catch (util::exception_t<int>& e)
+            {
+                if (e.data() != EEXIST)
+                    throw;
+            }
+
+            auto is_owner_running = false;
+            try
+            {
+                shared_memory_t existing(name);
+                auto channel = reinterpret_cast<const detail::shm_channel_header*>(existing.data());
+                is_owner_running = existing.size() >= detail::shm_channel_header_size && channel->magic.load() == shm_channel_magic
+                    && detail::is_process_running(channel->owner_pid);
+            }
+            catch (std::exception&) {} // unreadable segment is left by a crashed creator
+
+            if (is_owner_running)
+                throw util::exception_t("failed to create shared memory channel, the owner is running: " + name);
+            shared_memory_t::remove(name);
+#endif
+            return std::make_unique<shared_memory_t>(name, size);
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    struct shm_base_t
+    {
+        shm_base_t(auto&&... log_args)
+            : _log(std::make_shared<util::logger>(std::forward<decltype(log_args)>(log_args)...))
+        {}
+
+        shm_base_t(std::shared_ptr<util::logger> log) : _log(log) {}
+
+        void set_logger(auto&&...args)
+        {
+            _log = std::make_shared<util::logger>(std::forward<decltype(args)>(args)...);
+        }
+
+        void set_send_receive_log(bool set) { _log_send_receive = set; }
+        void log(auto&&...args) const
+        {
+            if (_log)
+                _log->writeln(util::time_stamp(), ':', _channel ? _channel->name() : std::string(), ':', std::forward<decltype(args)>(args)...);
+        }
+
+        template<class T> requires(archive::is_serializable_v<ishm_archive, std::remove_cvref_t<T>>)
+        void receive(T& t)
+        {
+            ishm_archive a{ _in };
+            a(t);
+            if (_log_send_receive)
+                log("received: ", archive::serialization_size(t), " bytes");
+        }
+
+        template<class T> requires(archive::is_serializable_v<ishm_archive, std::remove_cvref_t<T>>)
+        T receive()
+        {
+            T t;
+            receive(t);
+            return t;
+        }
+
+        template<class T> requires(std::is_void_v<T>)
+        auto receive() { return std::tuple{}; }
+
+        // all arguments are sent as one message
+        template<class ...T> requires((archive::is_serializable_v<oshm_archive, std::remove_cvref_t<T>> && ...))
+        void send(const T&... t)
+        {
+            if (_log_send_receive)
+                log("sending: ", archive::serialization_size(t...), " bytes");
+            oshm_archive a{ _out };
+            a(t...);
+            _out.flush();
+        }
+
+        bool has_data() const { return _in.has_data(); }
+
+    protected:
+        std::unique_ptr<shm_channel_t> _channel; // destroyed after the streams
+
+        // in_ring is read, the other ring is written
+        void attach(std::unique_ptr<shm_channel_t> channel, int in_ring)
+        {
+            _channel = std::move(channel);
+            _in.reset(_channel->ring(in_ring));
+            _out.reset(_channel->ring(1 - in_ring));
+        }
+
+        void skip_input() { _in.skip(); }
+
+        void detach()
+        {
+            _in.release();
+            _channel.reset();
+        }
+
+    private:
+        std::shared_ptr<util::logger> _log;
+        bool _log_send_receive = false;
+        ishm_stream _in;
+        oshm_stream _out;
+    };
+
+    //----------------------------------------------------------------------------------------------
+    struct shm_client_t : shm_base_t
+    {
+        // anonymous client
+        shm_client_t(const std::string& channel_name, unsigned connection_attempts, auto&& ...log_args)
+            : shm_client_t(channel_name, "", connection_attempts, std::forward<decltype(log_args)>(log_args)...)
+        {}
+
+        // named client
+        shm_client_t(const std::string& channel_name, std::string client_name, unsigned connection_attempts, auto&& ...log_args)
+            : shm_base_t(std::forward<decltype(log_args)>(log_args)...), _client_name(std::move(client_name))
+        {
+            using namespace std::chrono_literals;
+            std::string error;
+            auto attempt = 0u;
+            for (; !_channel && attempt < connection_attempts; ++attempt)
+            {
+                if (attempt != 0)
+                    std::this_thread::sleep_for(10ms);
+
+                // the server may not have created the channel yet, or another client is attached
+                try
+                {
+                    auto channel = std::make_unique<shm_channel_t>(channel_name);
+                    if (channel->connect())
+                    {
+                        attach(std::move(channel), 1);
+                        skip_input(); // responses left unread by a client that exited without disconnecting
+                    }
+                    else
+                        error = "another client is connected";
+                }
+                catch (std::exception& e)
+                {
+                    error = e.what();
+                }
+            }
+
+            if (!_channel)
+            {
+                auto error_string = util::to_string("\"", _client_name, "\": failed to connect to channel: ", channel_name, ": ", error);
+                log(error_string);
+                throw util::exception_t(error_string);
+            }
+
+            log("\"", _client_name, "\": connected to channel after ", attempt, " attempts");
+        }
+
+        ~shm_client_t()
+        {
+            log("\"", _client_name, "\": destructor");
+            try
+            {
+                disconnect();
+            }
+            catch (...) {} // server is already gone
+        }
+
+        template<class T>
+        [[nodiscard]]
+        auto request(const std::string& name, auto&& ...params)
+        {
+            log("\"", _client_name, "\": sending request for function: ", name);
+            return detail::rpc_request<T>(*this, name, std::forward<decltype(params)>(params)...);
+        }
+
+        template<class T>
+        [[nodiscard]]
+        auto request(std::uint32_t fn_id, auto&& ...params)
+        {
+            log("\"", _client_name, "\": sending request");
+            return detail::rpc_request<T>(*this, fn_id, std::forward<decltype(params)>(params)...);
+        }
+
+        template<auto Index, class T>
+        [[nodiscard]]
+        auto request(auto&& ...params)
+        {
+            return request<T>(Index, std::forward<decltype(params)>(params)...);
+        }
+
+        void disconnect() { close(server_disconnect); }
+        void shutdown() { close(server_shutdown); }
+
+        auto&& get_name() const { return _client_name; }
+
+    private:
+        std::string _client_name;
+
+        void close(std::uint32_t request)
+        {
+            if (!_channel)
+                return;
+
+            try
+            {
+                send(request);
+            }
+            catch (...)
+            {   // the channel is released even if the server is gone
+                release();
+                throw;
+            }
+            release();
+        }
+
+        void release()
+        {
+            _channel->disconnect();
+            detach();
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    // serves one client at a time, run() returns when the client disconnects and can be called again
+    struct shm_server_t : shm_base_t
+    {
+        shm_server_t(const std::string& channel_name, std::size_t capacity, auto&& ...log_args)
+            : shm_base_t(std::forward<decltype(log_args)>(log_args)...)
+        {
+            try
+            {
+                attach(std::make_unique<shm_channel_t>(channel_name, capacity), 0);
+            }
+            catch (std::exception& e)
+            {
+                log("failed to create channel: ", channel_name, ": ", e.what());
+                throw;
+            }
+            log("server created channel, ring capacity: ", _channel->capacity());
+        }
+
+        ~shm_server_t()
+        {
+            log("server destructor");
+            if (_channel)
+                _channel->close();
+        }
+
+        // functions are invoked by index
+        template<class ...Fn>
+        int run(Fn... functions)
+        {
+            static_assert(sizeof...(Fn) != 0, "server must have at least one function");
+            std::tuple<Fn...> fun_tuple{ functions... };
+            return run_loop([&](std::uint32_t fun_index) { return detail::rpc_dispatch_index(*this, fun_tuple, fun_index); });
+        }
+
+        // functions are invoked by name
+        template<class ...Fn>
+        int run(std::tuple<const char*, Fn> ... functions)
+        {
+            static_assert(sizeof...(Fn) != 0, "server must have at least one function");
+            std::tuple<std::tuple<const char*, Fn>...> tuple_functions{ functions... };
+            return run_loop([&](std::uint32_t) { return detail::rpc_dispatch_name(*this, tuple_functions); });
+        }
+
+        // wake up the server waiting for requests, run() throws then
+        void stop() { _channel->close(); }
+
+    private:
+        int run_loop(auto&& handler)
+        {
+            for (;;)
+            {
+                auto call_id = receive<std::uint32_t>();
+
+                if (call_id == server_shutdown)
+                {
+                    log("client requested shutdown");
+                    return server_shutdown;
+                }
+
+                if (call_id == server_disconnect)
+                {
+                    log("client requested disconnect");
+                    return 0;
+                }
+
+                if (!handler(call_id))
+                {   // the rest of the request can't be skipped
+                    _channel->close();
+                    throw util::exception_t("invalid request, channel is closed");
+                }
+            }
+        }
+    };
+}
@@ -37,6 +37,7 @@
 #include <vector>
 #include <cstdint>
 #include <cstring>
+#include <bit>
 
 namespace gb::yadro::util
 {
@@ -58,10 +59,14 @@ namespace gb::yadro::util
         size_t i = 0;
 
         if (length >= partLen) {
-            memcpy(&buffer[index], data, partLen);
-            transform(buffer);
+            if (index) {
+                memcpy(&buffer[index], data, partLen);
+                transform(buffer);
+                i = partLen;
+            }
 
-            for (i = partLen; i + 63 < length; i += 64) {
+            // full blocks are transformed in place
+            for (; i + 63 < length; i += 64) {
                 transform(&data[i]);
             }
 
@@ -107,12 +112,7 @@ namespace gb::yadro::util
 
     std::string md5::to_string() const
     {
-        std::ostringstream result;
-        result << std::hex << std::setfill('0');
-        for (uint8_t byte : digest()) {
-            result << std::setw(2) << static_cast<unsigned>(byte);
-        }
-        return result.str();
+        return to_hex(digest());
     }
 
     void md5::transform(const uint8_t block[64]) 
@@ -215,6 +215,11 @@ namespace gb::yadro::util
 
     void md5::decode(uint32_t* output, const uint8_t* input, size_t length) 
     {
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            std::memcpy(output, input, length);
+            return;
+        }
         for (size_t i = 0, j = 0; j < length; i++, j += 4) {
             output[i] = static_cast<uint32_t>(input[j]) |
                 (static_cast<uint32_t>(input[j + 1]) << 8) |
@@ -223,4 +228,172 @@ namespace gb::yadro::util
         }
     }
 
-}
\ No newline at end of file
+    //-------------------------------------------------------------------------
+    namespace
+    {
+        // multi-buffer md5: every lane hashes its own message, the lanes advance in lockstep
+        // one block at a time, so the round loops over lanes are vectorized
+        constexpr std::size_t md5_lanes = 8;
+
+        constexpr std::uint32_t md5_k[64] = {
+            0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+            0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+            0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+            0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+            0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+            0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+            0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+            0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 };
+        constexpr int md5_s[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+        using md5_vec = std::uint32_t[md5_lanes];
+
+        // one md5 step for all lanes, round R selects the function
+        template<int R>
+        inline void md5_step(md5_vec& a, const md5_vec& b, const md5_vec& c, const md5_vec& d, const md5_vec& x, std::uint32_t k, int s)
+        {
+            for (std::size_t l = 0; l < md5_lanes; ++l)
+            {
+                std::uint32_t f;
+                if constexpr (R == 0) f = d[l] ^ (b[l] & (c[l] ^ d[l]));
+                else if constexpr (R == 1) f = c[l] ^ (d[l] & (b[l] ^ c[l]));
+                else if constexpr (R == 2) f = b[l] ^ c[l] ^ d[l];
+                else f = c[l] ^ (b[l] | ~d[l]);
+                auto t = a[l] + f + k + x[l];
+                a[l] = b[l] + ((t << s) | (t >> (32 - s)));
+            }
+        }
+
+        template<int R>
+        inline void md5_round(md5_vec& a, md5_vec& b, md5_vec& c, md5_vec& d, const md5_vec* x)
+        {
+            for (int i = 16 * R; i < 16 * R + 16; i += 4)
+            {
+                auto g = [](int j) {
+                    if constexpr (R == 0) return j;
+                    else if constexpr (R == 1) return (5 * j + 1) & 15;
+                    else if constexpr (R == 2) return (3 * j + 5) & 15;
+                    else return (7 * j) & 15;
+                };
+                md5_step<R>(a, b, c, d, x[g(i)], md5_k[i], md5_s[4 * R]);
+                md5_step<R>(d, a, b, c, x[g(i + 1)], md5_k[i + 1], md5_s[4 * R + 1]);
+                md5_step<R>(c, d, a, b, x[g(i + 2)], md5_k[i + 2], md5_s[4 * R + 2]);
+                md5_step<R>(b, c, d, a, x[g(i + 3)], md5_k[i + 3], md5_s[4 * R + 3]);
+            }
+        }
+
+        struct md5_lane
+        {
+            const std::uint8_t* data{};
+            std::size_t full_blocks{};      // blocks read directly from the message
+            std::size_t blocks{};           // total number of blocks including padding
+            std::size_t block{};            // current block
+            std::size_t message{};
+            std::uint8_t tail[128]{};       // last partial block, padding and length
+
+            void reset(std::span<const std::uint8_t> m, std::size_t index)
+            {
+                data = m.data();
+                message = index;
+                full_blocks = m.size() / 64;
+                auto rest = m.size() % 64;
+                std::memset(tail, 0, sizeof(tail));
+                if (rest)
+                    std::memcpy(tail, m.data() + 64 * full_blocks, rest);
+                tail[rest] = 0x80;
+                auto tail_size = rest < 56 ? 64 : 128;
+                auto bits = static_cast<std::uint64_t>(m.size()) * 8;
+                for (int i = 0; i < 8; ++i)
+                    tail[tail_size - 8 + i] = static_cast<std::uint8_t>(bits >> (8 * i));
+                blocks = full_blocks + tail_size / 64;
+                block = 0;
+            }
+
+            const std::uint8_t* current() const
+            {
+                return block < full_blocks ? data + 64 * block : tail + 64 * (block - full_blocks);
+            }
+        };
+    }
+
+    std::vector<std::array<std::uint8_t, 16>> md5_many(std::span<const std::span<const std::uint8_t>> messages)
+    {
+        std::vector<std::array<std::uint8_t, 16>> result(messages.size());
+        std::array<md5_lane, md5_lanes> lanes;
+        std::array<bool, md5_lanes> active{};
+        md5_vec a, b, c, d;
+        md5_vec x[16];
+        constexpr std::uint8_t zero_block[64]{};
+
+        std::size_t next = 0;
+        auto start = [&](std::size_t l)
+        {
+            active[l] = next < messages.size();
+            if (active[l])
+            {
+                lanes[l].reset(messages[next], next);
+                ++next;
+            }
+            a[l] = 0x67452301;
+            b[l] = 0xefcdab89;
+            c[l] = 0x98badcfe;
+            d[l] = 0x10325476;
+        };
+        for (std::size_t l = 0; l < md5_lanes; ++l)
+            start(l);
+
+        while (std::ranges::any_of(active, std::identity{}))
+        {
+            // transpose the current blocks of all lanes
+            for (std::size_t l = 0; l < md5_lanes; ++l)
+            {
+                auto p = active[l] ? lanes[l].current() : zero_block;
+                for (int j = 0; j < 16; ++j)
+                {
+                    std::uint32_t w;
+                    std::memcpy(&w, p + 4 * j, 4);
+                    if constexpr (std::endian::native == std::endian::big)
+                        w = std::byteswap(w);
+                    x[j][l] = w;
+                }
+            }
+
+            md5_vec a0, b0, c0, d0;
+            std::memcpy(a0, a, sizeof(a));
+            std::memcpy(b0, b, sizeof(b));
+            std::memcpy(c0, c, sizeof(c));
+            std::memcpy(d0, d, sizeof(d));
+            md5_round<0>(a, b, c, d, x);
+            md5_round<1>(a, b, c, d, x);
+            md5_round<2>(a, b, c, d, x);
+            md5_round<3>(a, b, c, d, x);
+            for (std::size_t l = 0; l < md5_lanes; ++l)
+            {
+                a[l] += a0[l];
+                b[l] += b0[l];
+                c[l] += c0[l];
+                d[l] += d0[l];
+            }
+
+            // finished lanes take the next message
+            for (std::size_t l = 0; l < md5_lanes; ++l)
+            {
+                if (active[l] && ++lanes[l].block == lanes[l].blocks)
+                {
+                    std::uint32_t state[4]{ a[l], b[l], c[l], d[l] };
+                    auto& digest = result[lanes[l].message];
+                    for (int i = 0; i < 16; ++i)
+                        digest[i] = static_cast<std::uint8_t>(state[i / 4] >> (8 * (i % 4)));
+                    start(l);
+                }
+            }
+        }
+
+        // Zeroize sensitive information: message schedule and copies of the message tails.
+        std::memset(x, 0, sizeof x);
+        for (auto& lane : lanes)
+            std::memset(lane.tail, 0, sizeof(lane.tail));
+        return result;
+    }
+
+}
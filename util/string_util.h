@@ -33,6 +33,9 @@
 #include <vector>
 #include <type_traits>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
 
 namespace gb::yadro::util
 {
@@ -243,8 +246,9 @@ namespace gb::yadro::util
         static void encode(uint8_t* output, const uint32_t* input, size_t length);
         static void decode(uint32_t* output, const uint8_t* input, size_t length);
 
-        static uint32_t F(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (~x & z); }
-        static uint32_t G(uint32_t x, uint32_t y, uint32_t z) { return (x & z) | (y & ~z); }
+        // F and G in the form with one fewer operation
+        static uint32_t F(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+        static uint32_t G(uint32_t x, uint32_t y, uint32_t z) { return y ^ (z & (x ^ y)); }
         static uint32_t H(uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; }
         static uint32_t I(uint32_t x, uint32_t y, uint32_t z) { return y ^ (x | ~z); }
 
@@ -266,7 +270,7 @@ namespace gb::yadro::util
         }
 
         static uint32_t rotate_left(uint32_t x, uint32_t n) {
-            return (x << n) | (x >> (32 - n));
+            return std::rotl(x, static_cast<int>(n));
         }
 
         static constexpr uint32_t S11 = 7;
@@ -292,6 +296,28 @@ namespace gb::yadro::util
         bool finilized = false;
     };
 
+    //-------------------------------------------------------------------------
+    // MD5 digests of many independent messages,
+    // messages are hashed in parallel lanes that the compiler vectorizes (multi-buffer MD5),
+    // it's faster than hashing messages one by one when there are many of them
+    std::vector<std::array<std::uint8_t, 16>> md5_many(std::span<const std::span<const std::uint8_t>> messages);
+
+    //-------------------------------------------------------------------------
+    // hexadecimal representation of binary data
+    inline std::string to_hex(std::ranges::sized_range auto&& bytes)
+    {
+        constexpr auto digits = "0123456789abcdef";
+        std::string result;
+        result.reserve(2 * std::ranges::size(bytes));
+        for (auto b : bytes)
+        {
+            auto u = static_cast<std::uint8_t>(b);
+            result += digits[u >> 4];
+            result += digits[u & 0xf];
+        }
+        return result;
+    }
+
     //-------------------------------------------------------------------------
     // md5 functions
     inline auto md5string(auto&& ...t) 
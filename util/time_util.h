@@ -30,9 +30,24 @@
 #include <chrono>
 #include <sstream>
 #include <thread>
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace gb::yadro::util
 {
+    //-------------------------------------------------------------------------
+    inline auto process_id()
+    {
+#if defined(_WIN32)
+        return ::_getpid();
+#else
+        return ::getpid();
+#endif
+    }
+
     //-------------------------------------------------------------------------
     // get time stamp for specified time zone (current zone by default)
     // e.g. time_stamp("UTC"), time_stamp("America/New_York")
@@ -41,11 +56,11 @@ namespace gb::yadro::util
         using namespace std::chrono;
         try {
             return std::format("[{:%F %T}][pid: {}, tid: {}]", zoned_time{ zone, system_clock::now() },
-                ::_getpid(), std::this_thread::get_id());
+                process_id(), std::this_thread::get_id());
         }
         catch (std::exception&)
         {
-            return std::format("[invalid time zone: {}][pid: {}, tid: {}]", zone, ::_getpid(), std::this_thread::get_id());
+            return std::format("[invalid time zone: {}][pid: {}, tid: {}]", zone, process_id(), std::this_thread::get_id());
         }
     }
     //-------------------------------------------------------------------------
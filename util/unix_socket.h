@@ -0,0 +1,1073 @@
+//-----------------------------------------------------------------------------
+//  Copyright (C) 2011-2024, Gene Bushuyev
+//
+//  Boost Software License - Version 1.0 - August 17th, 2003
+//
+//  Permission is hereby granted, free of charge, to any person or organization
+//  obtaining a copy of the software and accompanying documentation covered by
+//  this license (the "Software") to use, reproduce, display, distribute,
+//  execute, and transmit the Software, and to prepare derivative works of the
+//  Software, and to permit third-parties to whom the Software is furnished to
+//  do so, all subject to the following:
+//
+//  The copyright notices in the Software and this entire statement, including
+//  the above license grant, this restriction and the following disclaimer,
+//  must be included in all copies of the Software, in whole or in part, and
+//  all derivative works of the Software, unless such copies or derivative
+//  works are solely in the form of machine-executable object code generated by
+//  a source language processor.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+//  FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#pragma once
+#include "gbwin.h"
+#include "gberror.h"
+#include "tuple_functions.h"
+#include "gblog.h"
+#include "misc.h"
+#include "time_util.h"
+#include "rpc.h"
+#include "../archive/archive.h"
+#include "../async/threadpool.h"
+
+#include <string>
+#include <format>
+#include <variant>
+#include <tuple>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <system_error>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <expected>
+#include <exception>
+#include <functional>
+#include <ranges>
+#include <thread>
+#include <chrono>
+
+#ifndef GBWINDOWS
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------
+// POSIX counterpart of win_pipe: typed RPC over Unix domain stream sockets
+//  the protocol is the same as win_pipe (rpc.h), functions are invoked by index or by name
+//  the client writes each request with a single send, the server reads through a buffer,
+//  so the small requests take one system call in each direction
+//  the server is driven by epoll, listening socket accepts any number of clients,
+//  readable connections are armed one-shot and handled in the threadpool, so each connection
+//  is served by at most one thread at a time, while different clients are served concurrently
+//  pipelined requests (request_async, request_batch) are executed as separate threadpool tasks,
+//  so the requests of one client run concurrently and the responses come back in the order of completion
+//  accepted connections are blocking: once the first bytes of a request arrive, the serving thread
+//  reads the rest of the message in place, a peer that stalls mid-message holds that threadpool thread
+//  until the receive timeout expires (connection_receive_timeout by default), then the connection is dropped
+//-----------------------------------------------------------------------------
+
+namespace gb::yadro::util
+{
+    struct iunix_socket_stream;
+    struct ounix_socket_stream;
+    using iunix_socket_archive = gb::yadro::archive::archive<iunix_socket_stream&, gb::yadro::archive::archive_format_t::custom>;
+    using ounix_socket_archive = gb::yadro::archive::archive<ounix_socket_stream&, gb::yadro::archive::archive_format_t::custom>;
+
+    struct unix_socket_client_t;
+    struct unix_socket_server_t;
+
+    // multi-client server
+    template<class ...Fn>
+    int start_server(async::threadpool<>& tp, const std::string& socket_path, std::shared_ptr<util::logger> log, Fn&&... fn);
+    template<class ...Fn>
+    int start_server(const std::string& socket_path, std::shared_ptr<util::logger> log, Fn&&... fn);
+    bool shutdown_server(const std::string& socket_path, unsigned attempts, auto&&...log_args);
+
+    // constants
+    inline constexpr std::size_t socket_buffer_size = 64 * 1024;
+    inline constexpr std::chrono::seconds connection_receive_timeout{ 30 }; // no progress within a started message
+
+    namespace detail
+    {
+        //------------------------------------------------------------------------------------------
+        inline auto socket_error(const std::string& message, int error = errno)
+        {
+            return util::exception_t(std::format("{}: {}", message, std::generic_category().message(error)), error);
+        }
+
+        //------------------------------------------------------------------------------------------
+        inline auto make_socket_address(const std::string& socket_path)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+                throw util::exception_t(std::format("invalid unix socket path: \"{}\"", socket_path));
+            std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+            return address;
+        }
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // buffered output, flush() sends the accumulated message, large blocks are sent directly
+    struct ounix_socket_stream
+    {
+        using char_type = char;
+        explicit ounix_socket_stream(int fd = -1) : _fd(fd) {}
+
+        void write(const char_type* c, std::streamsize size)
+        {
+            if (_buf.size() + size > socket_buffer_size)
+            {
+                flush();
+                if (static_cast<std::size_t>(size) >= socket_buffer_size)
+                {
+                    send_all(c, static_cast<std::size_t>(size));
+                    return;
+                }
+            }
+            _buf.insert(_buf.end(), c, c + size);
+        }
+
+        void flush()
+        {
+            send_all(_buf.data(), _buf.size());
+            _buf.clear();
+        }
+
+        void reset(int fd) { _fd = fd; _buf.clear(); }
+
+    private:
+        int _fd = -1;
+        std::vector<char_type> _buf;
+
+        void send_all(const char_type* c, std::size_t size) const
+        {
+            for (std::size_t sent_bytes = 0; sent_bytes < size;)
+            {
+                // MSG_NOSIGNAL: a closed peer is reported as EPIPE instead of killing the process with SIGPIPE
+                if (auto bytes_written = ::send(_fd, c + sent_bytes, size - sent_bytes, MSG_NOSIGNAL); bytes_written >= 0)
+                    sent_bytes += static_cast<std::size_t>(bytes_written);
+                else if (errno != EINTR)
+                    throw detail::socket_error(std::format("ounix_socket_stream failed to write to socket {}, bytes requested: {}, sent bytes: {}",
+                        _fd, size, sent_bytes));
+            }
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    // buffered input, keeps the bytes received ahead of the current message for the next one
+    struct iunix_socket_stream
+    {
+        using char_type = char;
+        explicit iunix_socket_stream(int fd = -1) : _fd(fd), _buf(socket_buffer_size) {}
+
+        void read(char_type* c, std::streamsize size)
+        {
+            auto n = static_cast<std::size_t>(size);
+            auto buffered = std::min(n, _end - _pos);
+            std::copy_n(_buf.data() + _pos, buffered, c);
+            _pos += buffered;
+
+            if (buffered == n)
+                return;
+
+            if (n - buffered >= _buf.size())
+            {   // large block bypasses the buffer
+                for (auto received = buffered; received < n;)
+                    received += receive_some(c + received, n - received);
+                return;
+            }
+
+            _pos = _end = 0;
+            for (auto received = buffered; received < n;)
+            {
+                _end += receive_some(_buf.data() + _end, _buf.size() - _end);
+                auto copied = std::min(n - received, _end - _pos);
+                std::copy_n(_buf.data() + _pos, copied, c + received);
+                _pos += copied;
+                received += copied;
+            }
+        }
+
+        // true if the next message has already been received, at least partially
+        bool has_data() const { return _pos != _end; }
+
+        void reset(int fd) { _fd = fd; _pos = _end = 0; }
+
+    private:
+        int _fd = -1;
+        std::vector<char_type> _buf;
+        std::size_t _pos = 0;
+        std::size_t _end = 0;
+
+        std::size_t receive_some(char_type* c, std::size_t size) const
+        {
+            for (;;)
+            {
+                if (auto bytes_read = ::recv(_fd, c, size, 0); bytes_read > 0)
+                    return static_cast<std::size_t>(bytes_read);
+                else if (bytes_read == 0)
+                    throw util::exception_t(std::format("iunix_socket_stream: socket {} closed by peer", _fd));
+                else if (errno != EINTR)
+                    throw detail::socket_error(std::format("iunix_socket_stream failed to read from socket {}, bytes requested: {}", _fd, size));
+            }
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    struct unix_socket_base_t
+    {
+        unix_socket_base_t(auto&&... log_args)
+            : _log(std::make_shared<util::logger>(std::forward<decltype(log_args)>(log_args)...))
+        {}
+
+        unix_socket_base_t(std::shared_ptr<util::logger> log) : _log(log) {}
+
+        unix_socket_base_t(int fd, std::shared_ptr<util::logger> log) : _log(log) { reset(fd); }
+
+        unix_socket_base_t(const unix_socket_base_t&) = delete;
+        unix_socket_base_t& operator=(const unix_socket_base_t&) = delete;
+
+        ~unix_socket_base_t() { close(); }
+
+        void set_logger(auto&&...args)
+        {
+            _log = std::make_shared<util::logger>(std::forward<decltype(args)>(args)...);
+        }
+
+        void set_send_receive_log(bool set) { _log_send_receive = set; }
+        void log(auto&&...args) const { if (_log) _log->writeln(util::time_stamp(), ':', _fd, ':', std::forward<decltype(args)>(args)...); }
+
+        template<class T> requires(archive::is_serializable_v<iunix_socket_archive, std::remove_cvref_t<T>>)
+        void receive(T& t)
+        {
+            iunix_socket_archive a{ _in };
+            a(t);
+            if (_log_send_receive)
+                log("received: ", archive::serialization_size(t), " bytes");
+        }
+
+        template<class T> requires(archive::is_serializable_v<iunix_socket_archive, std::remove_cvref_t<T>>)
+        T receive()
+        {
+            T t;
+            receive(t);
+            return t;
+        }
+
+        template<class T> requires(std::is_void_v<T>)
+        auto receive() { return std::tuple{}; }
+
+        // all arguments are sent as one message
+        template<class ...T> requires((archive::is_serializable_v<ounix_socket_archive, std::remove_cvref_t<T>> && ...))
+        void send(const T&... t)
+        {
+            write(t...);
+            flush();
+        }
+
+        // the arguments are buffered until the next send or flush
+        template<class ...T> requires((archive::is_serializable_v<ounix_socket_archive, std::remove_cvref_t<T>> && ...))
+        void write(const T&... t)
+        {
+            if (_log_send_receive)
+                log("sending: ", archive::serialization_size(t...), " bytes");
+            ounix_socket_archive a{ _out };
+            a(t...);
+        }
+
+        void flush() { _out.flush(); }
+
+        bool has_data() const { return _in.has_data(); }
+
+        auto get_handle() const { return _fd; }
+
+    protected:
+        int _fd = -1;
+
+        void reset(int fd)
+        {
+            _fd = fd;
+            _in.reset(fd);
+            _out.reset(fd);
+        }
+
+        void close()
+        {
+            if (_fd != -1)
+            {
+                ::close(_fd);
+                _fd = -1;
+            }
+        }
+
+        auto get_logger() const { return _log; }
+
+    private:
+        std::shared_ptr<util::logger> _log;
+        bool _log_send_receive = false;
+        iunix_socket_stream _in;
+        ounix_socket_stream _out;
+    };
+
+    //----------------------------------------------------------------------------------------------
+    struct unix_socket_client_t : unix_socket_base_t
+    {
+        // anonymous client
+        unix_socket_client_t(const std::string& socket_path, unsigned connection_attempts, auto&& ...log_args)
+            : unix_socket_client_t(socket_path, "", connection_attempts, std::forward<decltype(log_args)>(log_args)...)
+        {}
+
+        // named client
+        unix_socket_client_t(const std::string& socket_path, std::string client_name, unsigned connection_attempts, auto&& ...log_args)
+            : unix_socket_base_t(std::forward<decltype(log_args)>(log_args)...), _client_name(std::move(client_name))
+        {
+            using namespace std::chrono_literals;
+            auto address = detail::make_socket_address(socket_path);
+            auto attempt = 0u;
+            auto error = 0;
+            for (; _fd == -1 && attempt < connection_attempts; ++attempt)
+            {
+                if (attempt != 0)
+                    std::this_thread::sleep_for(10ms);
+
+                // the server may not be listening yet, or its backlog is full
+                auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (fd == -1)
+                {
+                    error = errno;
+                    continue;
+                }
+
+                if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0)
+                    reset(fd);
+                else
+                {
+                    error = errno;
+                    ::close(fd);
+                }
+            }
+
+            if (_fd == -1)
+            {
+                auto error_string = util::to_string("\"", _client_name, "\": failed to connect to socket: ", socket_path, ": ",
+                    std::generic_category().message(error));
+                log(error_string);
+                throw util::exception_t(error_string, error);
+            }
+
+            log("\"", _client_name, "\": connected to socket after ", attempt, " attempts");
+        }
+
+        ~unix_socket_client_t()
+        {
+            log("\"", _client_name, "\": destructor");
+            try
+            {
+                disconnect();
+            }
+            catch (...) {} // server is already gone
+        }
+
+        // synchronous request, waits for the response
+        template<class T>
+        [[nodiscard]]
+        auto request(const std::string& name, auto&& ...params)
+        {
+            if (_receiver.joinable()) // the responses are read by the receiver thread
+                return request_async<T>(name, std::forward<decltype(params)>(params)...).get();
+            log("\"", _client_name, "\": sending request for function: ", name);
+            return detail::rpc_request<T>(*this, name, std::forward<decltype(params)>(params)...);
+        }
+
+        template<class T>
+        [[nodiscard]]
+        auto request(std::uint32_t fn_id, auto&& ...params)
+        {
+            if (_receiver.joinable())
+                return request_async<T>(fn_id, std::forward<decltype(params)>(params)...).get();
+            log("\"", _client_name, "\": sending request");
+            return detail::rpc_request<T>(*this, fn_id, std::forward<decltype(params)>(params)...);
+        }
+
+        template<auto Index, class T>
+        [[nodiscard]]
+        auto request(auto&& ...params)
+        {
+            return request<T>(Index, std::forward<decltype(params)>(params)...);
+        }
+
+        // pipelined request, returns without waiting for the response
+        // the server may complete outstanding requests in any order, the responses are matched by request id
+        // in the receiver thread, which is started by the first pipelined request
+        template<class T>
+        [[nodiscard]]
+        auto request_async(const std::string& name, auto&& ...params)
+        {
+            log("\"", _client_name, "\": sending pipelined request for function: ", name);
+            return std::move(send_pipelined<T>(name, std::views::single(std::tuple<const std::remove_cvref_t<decltype(params)>&...>(params...))).front());
+        }
+
+        template<class T>
+        [[nodiscard]]
+        auto request_async(std::uint32_t fn_id, auto&& ...params)
+        {
+            log("\"", _client_name, "\": sending pipelined request");
+            return std::move(send_pipelined<T>(fn_id, std::views::single(std::tuple<const std::remove_cvref_t<decltype(params)>&...>(params...))).front());
+        }
+
+        template<auto Index, class T>
+        [[nodiscard]]
+        auto request_async(auto&& ...params)
+        {
+            return request_async<T>(Index, std::forward<decltype(params)>(params)...);
+        }
+
+        // batch of calls of one function sent in one write, the results are in the order of the parameters
+        // the elements of the range are tuples of the function parameters, or the parameter of one parameter function
+        template<class T>
+        [[nodiscard]]
+        auto request_batch(const std::string& name, std::ranges::input_range auto&& params)
+        {
+            log("\"", _client_name, "\": sending batch request for function: ", name);
+            return get_all(send_pipelined<T>(name, params));
+        }
+
+        template<class T>
+        [[nodiscard]]
+        auto request_batch(std::uint32_t fn_id, std::ranges::input_range auto&& params)
+        {
+            log("\"", _client_name, "\": sending batch request");
+            return get_all(send_pipelined<T>(fn_id, params));
+        }
+
+        template<auto Index, class T>
+        [[nodiscard]]
+        auto request_batch(std::ranges::input_range auto&& params)
+        {
+            return request_batch<T>(Index, std::forward<decltype(params)>(params));
+        }
+
+        // the outstanding pipelined requests are completed before the server closes the connection
+        void disconnect()
+        {
+            if (_fd != -1)
+            {
+                try
+                {
+                    send_locked<std::uint32_t>(server_disconnect);
+                }
+                catch (...)
+                {
+                    stop_receiver(true);
+                    close();
+                    throw;
+                }
+                stop_receiver(false);
+                close();
+            }
+        }
+
+        void shutdown()
+        {
+            if (_fd != -1)
+            {
+                try
+                {
+                    send_locked<std::uint32_t>(server_shutdown);
+                }
+                catch (...)
+                {
+                    stop_receiver(true);
+                    throw;
+                }
+                stop_receiver(false);
+                close();
+            }
+        }
+
+        auto&& get_name() const { return _client_name; }
+
+    private:
+        template<class T>
+        using response_t = std::expected<T, std::string>;
+        // completes the pending request: reads the response, or sets the exception if the connection is broken
+        using pending_t = std::move_only_function<void(std::exception_ptr)>;
+
+        std::string _client_name;
+        std::mutex _m_send; // orders the pipelined requests of different threads
+        std::uint64_t _request_id = 0;
+        std::mutex _m_pending;
+        std::unordered_map<std::uint64_t, pending_t> _pending;
+        std::exception_ptr _receiver_error;
+        std::thread _receiver;
+
+        //------------------------------------------------------------------------------------------
+        template<class ...T>
+        void send_locked(const T&... t)
+        {
+            std::lock_guard _(_m_send);
+            send(t...);
+        }
+
+        //------------------------------------------------------------------------------------------
+        // the requests are buffered and sent with one flush
+        template<class T>
+        auto send_pipelined(const auto& fn, auto&& params)
+        {
+            std::vector<std::future<response_t<T>>> futures;
+            if constexpr (std::ranges::sized_range<decltype(params)>)
+                futures.reserve(std::ranges::size(params));
+
+            std::lock_guard _(_m_send);
+            if (!_receiver.joinable())
+                _receiver = std::thread([this] { receive_responses(); });
+
+            auto first_id = _request_id;
+            try
+            {
+                for (auto&& p : params)
+                {
+                    futures.push_back(add_pending<T>(_request_id));
+                    if constexpr (archive::is_tuple_v<std::remove_cvref_t<decltype(p)>>)
+                        detail::rpc_write_async(*this, _request_id++, fn, p);
+                    else
+                        detail::rpc_write_async(*this, _request_id++, fn, std::tuple<const std::remove_cvref_t<decltype(p)>&>(p));
+                }
+                flush();
+            }
+            catch (...)
+            {
+                std::lock_guard _(_m_pending);
+                for (auto id = first_id; id != _request_id; ++id)
+                    _pending.erase(id);
+                throw;
+            }
+            return futures;
+        }
+
+        //------------------------------------------------------------------------------------------
+        template<class T>
+        auto add_pending(std::uint64_t request_id)
+        {
+            std::promise<response_t<T>> p;
+            auto f = p.get_future();
+            std::lock_guard _(_m_pending);
+            if (_receiver_error) // no more responses
+                std::rethrow_exception(_receiver_error);
+
+            _pending.emplace(request_id, [this, p = std::move(p)](std::exception_ptr e) mutable
+                {
+                    if (e)
+                        p.set_exception(e);
+                    else
+                    {
+                        try
+                        {
+                            p.set_value(receive<response_t<T>>());
+                        }
+                        catch (...)
+                        {
+                            p.set_exception(std::current_exception());
+                            throw;
+                        }
+                    }
+                });
+            return f;
+        }
+
+        //------------------------------------------------------------------------------------------
+        template<class T>
+        static auto get_all(std::vector<std::future<response_t<T>>>&& futures)
+        {
+            std::vector<response_t<T>> responses;
+            responses.reserve(futures.size());
+            for (auto&& f : futures)
+                responses.push_back(f.get());
+            return responses;
+        }
+
+        //------------------------------------------------------------------------------------------
+        // receiver thread runs until the server closes the connection
+        void receive_responses()
+        {
+            try
+            {
+                for (;;)
+                {
+                    auto request_id = receive<std::uint64_t>();
+                    pending_t pending;
+                    {
+                        std::lock_guard _(_m_pending);
+                        if (auto it = _pending.find(request_id); it != _pending.end())
+                        {
+                            pending = std::move(it->second);
+                            _pending.erase(it);
+                        }
+                    }
+                    if (!pending) // the rest of the message can't be skipped
+                        throw util::exception_t(std::format("unexpected response, request id: {}", request_id));
+                    pending(nullptr);
+                }
+            }
+            catch (std::exception& e)
+            {
+                log("\"", _client_name, "\": receiver stopped: ", e.what());
+                std::unordered_map<std::uint64_t, pending_t> pending;
+                {
+                    std::lock_guard _(_m_pending);
+                    _receiver_error = std::current_exception();
+                    pending.swap(_pending);
+                }
+                for (auto&& [id, p] : pending)
+                    p(_receiver_error);
+            }
+        }
+
+        //------------------------------------------------------------------------------------------
+        // wait for the server to close the connection, or close it right away
+        void stop_receiver(bool abort)
+        {
+            if (_receiver.joinable())
+            {
+                if (abort)
+                    ::shutdown(_fd, SHUT_RDWR);
+                _receiver.join();
+            }
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    inline auto is_server_running(const std::string& socket_path)
+    {
+        auto address = detail::make_socket_address(socket_path);
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1)
+            return false;
+        auto is_running = ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (is_running)
+        {   // the probe connection shouldn't be reported as a broken client
+            std::uint32_t disconnect = server_disconnect;
+            [[maybe_unused]] auto ret = ::send(fd, &disconnect, sizeof(disconnect), MSG_NOSIGNAL);
+        }
+        ::close(fd);
+        return is_running;
+    }
+
+    //----------------------------------------------------------------------------------------------
+    template< class Rep, class Period >
+    inline auto is_server_running(const std::string& socket_path, const std::chrono::duration<Rep, Period>& timeout_duration)
+    {
+        using namespace std::chrono_literals;
+        const auto sleep_duration = 100ms;
+
+        for (auto start = std::chrono::high_resolution_clock::now(); !is_server_running(socket_path)
+            && std::chrono::high_resolution_clock::now() - start < timeout_duration;)
+            std::this_thread::sleep_for(sleep_duration);
+
+        return is_server_running(socket_path);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    struct unix_socket_server_t : unix_socket_base_t
+    {
+        unix_socket_server_t(const std::string& socket_path, auto&& ...log_args);
+
+        ~unix_socket_server_t()
+        {
+            log("server destructor");
+            if (_epoll != -1)
+                ::close(_epoll);
+            if (_event != -1)
+                ::close(_event);
+            stop_listening();
+        }
+
+        // functions are invoked by index
+        template<class ...Fn>
+        int run(async::threadpool<>& tp, Fn... functions)
+        {
+            static_assert(sizeof...(Fn) != 0, "server must have at least one function");
+            std::tuple<Fn...> fun_tuple{ functions... };
+
+            return run_loop(tp,
+                [&](connection_t& c, std::uint32_t fun_index)
+                {
+                    return detail::rpc_dispatch_index(c, fun_tuple, fun_index);
+                },
+                [&](connection_t& c, std::uint64_t request_id, auto&& execute)
+                {
+                    return detail::rpc_dispatch_index_async(c, fun_tuple, c.receive<std::uint32_t>(), request_id, execute);
+                });
+        }
+
+        // functions are invoked by name
+        template<class ...Fn>
+        int run(async::threadpool<>& tp, std::tuple<const char*, Fn> ... functions)
+        {
+            static_assert(sizeof...(Fn) != 0, "server must have at least one function");
+            std::tuple<std::tuple<const char*, Fn>...> tuple_functions{ functions... };
+
+            return run_loop(tp,
+                [&](connection_t& c, std::uint32_t)
+                {
+                    return detail::rpc_dispatch_name(c, tuple_functions);
+                },
+                [&](connection_t& c, std::uint64_t request_id, auto&& execute)
+                {
+                    c.receive<std::uint32_t>(); // 0 for named functions
+                    return detail::rpc_dispatch_name_async(c, tuple_functions, request_id, execute);
+                });
+        }
+
+        // limits the wait for the rest of a started message, applies to the connections accepted afterwards
+        template< class Rep, class Period >
+        void set_receive_timeout(const std::chrono::duration<Rep, Period>& timeout)
+        {
+            _receive_timeout = std::chrono::duration_cast<std::chrono::microseconds>(timeout);
+        }
+
+        // stop the running server from any thread
+        void stop()
+        {
+            std::uint64_t one = 1;
+            [[maybe_unused]] auto ret = ::write(_event, &one, sizeof(one));
+        }
+
+    private:
+        struct connection_t : unix_socket_base_t
+        {
+            connection_t(int fd, std::shared_ptr<util::logger> log) : unix_socket_base_t(fd, log) {}
+            using unix_socket_base_t::close;
+
+            // the responses to pipelined requests are sent from the threadpool, concurrently with the serving thread
+            void send(const auto&... t)
+            {
+                std::lock_guard _(m_send);
+                unix_socket_base_t::send(t...);
+            }
+
+            std::mutex m; // uncontended, orders the threads serving the connection one after another
+            std::mutex m_send;
+        };
+
+        std::string _socket_path;
+        int _epoll = -1;
+        int _event = -1; // eventfd signaling stop
+        std::chrono::microseconds _receive_timeout = connection_receive_timeout;
+        std::mutex _m_connections;
+        std::unordered_map<int, std::shared_ptr<connection_t>> _connections; // shared with pipelined requests in progress
+        std::mutex _m_pending;
+        std::vector<std::future<void>> _pending; // pipelined requests
+
+        //------------------------------------------------------------------------------------------
+        // new clients fail to connect right away, instead of waiting for the pending requests
+        void stop_listening()
+        {
+            if (_fd != -1)
+            {
+                ::unlink(_socket_path.c_str());
+                close();
+            }
+        }
+
+        //------------------------------------------------------------------------------------------
+        void close_connection(int fd)
+        {
+            std::shared_ptr<connection_t> c;
+            {
+                std::lock_guard _(_m_connections);
+                if (auto it = _connections.find(fd); it != _connections.end())
+                {
+                    c = std::move(it->second);
+                    _connections.erase(it);
+                }
+            }
+            ::epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+            // connection destructor closes the socket, after the pipelined requests are completed
+        }
+
+        //------------------------------------------------------------------------------------------
+        void accept_connections()
+        {
+            for (;;)
+            {
+                auto fd = ::accept4(_fd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd == -1)
+                {
+                    if (errno == EINTR || errno == ECONNABORTED)
+                        continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        log("accept failed: ", std::generic_category().message(errno));
+                    return;
+                }
+
+                // idle connections wait in epoll, the timeout only limits the reads of a partially received message
+                timeval tv{ .tv_sec = static_cast<time_t>(_receive_timeout.count() / 1'000'000),
+                    .tv_usec = static_cast<suseconds_t>(_receive_timeout.count() % 1'000'000) };
+                if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1)
+                    log("failed to set receive timeout: ", std::generic_category().message(errno));
+
+                {
+                    std::lock_guard _(_m_connections);
+                    _connections.emplace(fd, std::make_shared<connection_t>(fd, get_logger()));
+                }
+
+                epoll_event ev{ .events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, .data{.fd = fd } };
+                if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev) == -1)
+                {
+                    log("failed to register connection: ", std::generic_category().message(errno));
+                    close_connection(fd);
+                }
+                else
+                    log("server accepted connection: ", fd);
+            }
+        }
+
+        //------------------------------------------------------------------------------------------
+        // serve the requests of a readable connection, handler processes one request,
+        // async_handler receives pipelined request and schedules its execution in the threadpool
+        // returns true to keep the connection
+        bool serve(async::threadpool<>& tp, int fd, auto& handler, auto& async_handler)
+        {
+            std::shared_ptr<connection_t> c;
+            {
+                std::lock_guard _(_m_connections);
+                if (auto it = _connections.find(fd); it != _connections.end())
+                    c = it->second;
+            }
+            if (!c)
+                return false;
+
+            std::lock_guard _(c->m);
+            try
+            {   // requests already in the buffer are not reported by epoll
+                do
+                {
+                    auto call_id = c->receive<std::uint32_t>();
+
+                    if (call_id == server_shutdown)
+                    {
+                        c->log("client requested shutdown");
+                        stop();
+                        return false;
+                    }
+
+                    if (call_id == server_disconnect)
+                    {
+                        c->log("client requested disconnect");
+                        return false;
+                    }
+
+                    if (call_id == server_async)
+                    {
+                        auto execute = [&](auto&& task)
+                            {
+                                auto f = tp([c, task = std::move(task)]() mutable
+                                    {
+                                        try
+                                        {
+                                            task(*c);
+                                        }
+                                        catch (std::exception& e)
+                                        {   // the client is gone
+                                            c->log("failed to send response: ", e.what());
+                                        }
+                                    });
+                                std::lock_guard _(_m_pending);
+                                _pending.push_back(std::move(f));
+                            };
+                        if (!async_handler(*c, c->receive<std::uint64_t>(), execute))
+                            return false;
+                    }
+                    else if (!handler(*c, call_id))
+                        return false;
+                } while (c->has_data());
+            }
+            catch (std::exception& e)
+            {
+                c->log("connection closed: ", e.what());
+                return false;
+            }
+            return true;
+        }
+
+        //------------------------------------------------------------------------------------------
+        int run_loop(async::threadpool<>& tp, auto&& handler, auto&& async_handler)
+        {
+            if (_fd == -1)
+                throw util::exception_t("can't run unconnected server");
+
+            std::vector<std::future<void>> pending;
+            epoll_event events[64];
+
+            for (auto running = true; running;)
+            {
+                auto n = ::epoll_wait(_epoll, events, std::size(events), -1);
+                if (n == -1)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    throw detail::socket_error("epoll_wait failed");
+                }
+
+                for (auto i = 0; i < n; ++i)
+                {
+                    auto fd = events[i].data.fd;
+                    if (fd == _event)
+                        running = false;
+                    else if (fd == _fd)
+                        accept_connections();
+                    else
+                    {
+                        pending.push_back(tp([this, fd, &tp, &handler, &async_handler]
+                            {
+                                if (epoll_event ev{ .events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, .data{.fd = fd } };
+                                    !serve(tp, fd, handler, async_handler) || ::epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &ev) == -1)
+                                    close_connection(fd);
+                            }));
+                    }
+                }
+
+                auto is_ready = [](auto&& f) { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+                if (pending.size() > 64) // clean up periodically
+                    std::erase_if(pending, is_ready);
+                if (std::lock_guard _(_m_pending); _pending.size() > 64)
+                    std::erase_if(_pending, is_ready);
+            }
+
+            log("server shutdown");
+            stop_listening();
+            {   // wake up the threads blocked in the connections, the connections are destroyed after the threads are done
+                std::lock_guard _(_m_connections);
+                for (auto&& [fd, c] : _connections)
+                    ::shutdown(fd, SHUT_RDWR);
+            }
+            for (auto&& f : pending)
+                f.wait();
+            // the serving threads are done, no more pipelined requests are scheduled
+            for (auto&& f : _pending)
+                f.wait();
+            _pending.clear();
+            std::lock_guard _(_m_connections);
+            _connections.clear();
+            return server_shutdown;
+        }
+    };
+
+    //----------------------------------------------------------------------------------------------
+    inline unix_socket_server_t::unix_socket_server_t(const std::string& socket_path, auto&& ...log_args)
+        : unix_socket_base_t(std::forward<decltype(log_args)>(log_args)...), _socket_path(socket_path)
+    {
+        auto address = detail::make_socket_address(socket_path);
+
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd == -1)
+            throw detail::socket_error("failed to create socket: " + socket_path);
+
+        auto bind = [&] { return ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0; };
+        auto bound = bind();
+        if (!bound && errno == EADDRINUSE)
+        {   // the file is left by a server that didn't exit cleanly, unless some server still accepts connections
+            if (is_server_running(socket_path))
+            {
+                ::close(fd);
+                log("failed to start the server another instance is already running: ", socket_path);
+                throw util::exception_t("failed to start the server another instance is already running: " + socket_path);
+            }
+            ::unlink(socket_path.c_str());
+            bound = bind();
+        }
+        if (!bound)
+        {
+            auto error = errno;
+            ::close(fd);
+            log("failed to bind socket: ", socket_path, ": ", std::generic_category().message(error));
+            throw detail::socket_error("failed to bind socket: " + socket_path, error);
+        }
+
+        if (::listen(fd, SOMAXCONN) == -1)
+        {
+            auto error = errno;
+            ::close(fd);
+            ::unlink(socket_path.c_str());
+            throw detail::socket_error("failed to listen on socket: " + socket_path, error);
+        }
+        reset(fd);
+
+        _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        _event = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event listen_ev{ .events = EPOLLIN, .data{.fd = _fd } };
+        epoll_event stop_ev{ .events = EPOLLIN, .data{.fd = _event } };
+        if (_epoll == -1 || _event == -1
+            || ::epoll_ctl(_epoll, EPOLL_CTL_ADD, _fd, &listen_ev) == -1
+            || ::epoll_ctl(_epoll, EPOLL_CTL_ADD, _event, &stop_ev) == -1)
+        {
+            auto error = errno;
+            log("failed to create epoll: ", std::generic_category().message(error));
+            // the destructor isn't called for a partially constructed server
+            if (_epoll != -1)
+                ::close(_epoll);
+            if (_event != -1)
+                ::close(_event);
+            stop_listening();
+            throw detail::socket_error("failed to create epoll", error);
+        }
+
+        log("server is listening on socket: ", socket_path);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    // server runs until a client requests shutdown, connections are served in threadpool
+    template<class ...Fn>
+    int start_server(async::threadpool<>& tp, const std::string& socket_path, std::shared_ptr<util::logger> log, Fn&&... fn)
+    {
+        unix_socket_server_t server(socket_path, log);
+        return server.run(tp, std::forward<Fn>(fn)...);
+    }
+
+    template<class ...Fn>
+    int start_server(const std::string& socket_path, std::shared_ptr<util::logger> log, Fn&&... fn)
+    {
+        async::threadpool<> tp;
+        return start_server(tp, socket_path, log, std::forward<Fn>(fn)...);
+    }
+
+    //----------------------------------------------------------------------------------------------
+    inline bool shutdown_server(const std::string& socket_path, unsigned attempts, auto&&...log_args)
+    {
+        using namespace std::chrono_literals;
+        try {
+            // make at most 10 attemps to shutdown server
+            for (auto i = 0; is_server_running(socket_path) && i < 10; ++i)
+            {
+                unix_socket_client_t(socket_path, "shutdown", attempts, log_args...).shutdown();
+                // the server stops listening when it processes the request
+                for (auto start = std::chrono::steady_clock::now(); is_server_running(socket_path)
+                    && std::chrono::steady_clock::now() - start < 1s;)
+                    std::this_thread::sleep_for(10ms);
+            }
+        }
+        catch (...) {}
+
+        return !is_server_running(socket_path);
+    }
+}
+#endif
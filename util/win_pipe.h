@@ -34,6 +34,7 @@
 #include "time_util.h"
 #include "string_util.h"
 #include "file_mutex.h"
+#include "rpc.h"
 #include "../archive/archive.h"
 #include "../async/threadpool.h"
 
@@ -70,8 +71,6 @@ namespace gb::yadro::util
 
     // constants
     inline constexpr auto pipe_chunk_size = 1024;
-    inline constexpr std::uint32_t server_disconnect = -1;
-    inline constexpr std::uint32_t server_shutdown = -2;
 
     //----------------------------------------------------------------------------------------------
     struct owinpipe_stream
@@ -328,89 +327,28 @@ namespace gb::yadro::util
         template<class ...Fn>
         int run(Fn... functions)
         {
-            if (_pipe == INVALID_HANDLE_VALUE)
-                throw util::exception_t("can't run unconnected server");
-
             static_assert(sizeof...(Fn) != 0, "server must have at least one function");
             std::tuple<Fn...> fun_tuple{ functions... };
-
-            for (;;)
-            {
-                auto fun_index = receive<std::uint32_t>();
-
-                if (fun_index == server_shutdown)
-                {
-                    log("client requested shutdown");
-                    return server_shutdown;
-                }
-
-                if (fun_index == server_disconnect)
-                {
-                    log("client requested disconnect");
-                    return 0;
-                }
-
-                if (fun_index >= sizeof...(functions))
-                {
-                    log("error: client requested invalid function: ", fun_index);
-                    return 0;
-                }
-
-                log("client requested function: ", fun_index);
-
-                std::visit([&](auto&& fn)
-                    {
-                        using lambda_type = std::remove_cvref_t<decltype(fn)>; // tuple
-                        auto params = receive<lambda_pure_args<lambda_type>>();
-                        log("received parameters for function: ", fun_index);
-                        using sent_t = std::expected< lambda_ret<lambda_type>, std::string>;
-
-                        try
-                        {
-                            if constexpr (std::is_void_v<lambda_ret<lambda_type>>)
-                            {
-                                std::apply([&](auto&& ...args)
-                                    {
-                                        fn(std::move(args)...); // no response required
-                                    }, params);
-                                send(sent_t{});
-                            }
-                            else
-                                send(sent_t{ std::apply([&](auto&& ...args)
-                                {
-                                    return fn(std::move(args)...);
-                                }, params) });
-                            log("sent response from function: ", fun_index);
-                        }
-                        catch (util::exception_t<>& e)
-                        {
-                            log("exception: ", e.what());
-                            send(sent_t{ std::unexpected{e.what()} });
-                        }
-                        catch (std::exception& e)
-                        {
-                            log("exception: ", e.what());
-                            send(sent_t{ std::unexpected{e.what()} });
-                        }
-                        catch (...)
-                        {
-                            log("unknown exception");
-                            send(sent_t{ std::unexpected{std::string("unknown exception")} });
-                        }
-
-                    }, util::tuple_to_variant(fun_tuple, fun_index));
-            }
+            return run_loop([&](std::uint32_t fun_index) { return detail::rpc_dispatch_index(*this, fun_tuple, fun_index); });
         }
 
         // functions are invoked by name
         template<class ...Fn>
         int run(std::tuple<const char*, Fn> ... functions)
+        {
+            static_assert(sizeof...(Fn) != 0, "server must have at least one function");
+            std::tuple<std::tuple<const char*, Fn>...> tuple_functions{ functions... };
+            return run_loop([&](std::uint32_t) { return detail::rpc_dispatch_name(*this, tuple_functions); });
+        }
+
+    private:
+        // the functions are dispatched by rpc.h, the invalid request closes the connection,
+        // because its parameters can't be skipped
+        int run_loop(auto&& handler)
         {
             if (_pipe == INVALID_HANDLE_VALUE)
                 throw util::exception_t("can't run unconnected server");
 
-            static_assert(sizeof...(Fn) != 0, "server must have at least one function");
-            auto tuple_functions{ std::tuple{functions...} };
             for (;;)
             {
                 auto call_id = receive<std::uint32_t>();
@@ -427,51 +365,8 @@ namespace gb::yadro::util
                     return 0;
                 }
 
-                auto fun_name = receive<std::string>();
-                log("client requested function: ", fun_name);
-
-                try
-                {
-                    std::visit([&](auto&& fn_tuple)
-                        {
-                            auto&& fn = std::get<1>(fn_tuple);
-                            using lambda_type = std::remove_cvref_t<decltype(fn)>; // tuple
-                            auto params = receive<lambda_pure_args<lambda_type>>();
-                            log("received parameters for function: ", fun_name);
-                            using sent_t = std::expected< lambda_ret<lambda_type>, std::string>;
-
-                            if constexpr (std::is_void_v<lambda_ret<lambda_type>>)
-                            {
-                                std::apply([&](auto&& ...args)
-                                    {
-                                        fn(std::move(args)...); // no response required
-                                    }, params);
-                                send(sent_t{});
-                            }
-                            else
-                                send(sent_t{ std::apply([&](auto&& ...args)
-                                {
-                                    return fn(std::move(args)...);
-                                }, params) });
-                            log("sent response from function: ", fun_name);
-
-                        }, util::tuple_to_variant(tuple_functions, [&](auto&& fun_tup) { return std::get<0>(fun_tup) == fun_name; }));
-                }
-                catch (util::exception_t<>& e)
-                {
-                    log("exception: ", e.what());
-                    send(std::expected<void, std::string>{ std::unexpected{e.what()} });
-                }
-                catch (std::exception& e)
-                {
-                    log("exception: ", e.what());
-                    send(std::expected<void, std::string>{ std::unexpected{e.what()} });
-                }
-                catch (...)
-                {
-                    log("unknown exception");
-                    send(std::expected<void, std::string>{ std::unexpected{ "unknown exception" }});
-                }
+                if (!handler(call_id))
+                    return 0;
             }
         }
     };